@@ -7,9 +7,13 @@
 */
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryFile>
 #include <QTextStream>
 
 #include "tracedata.h"
+#include "fixcost.h"
+#include "callgraph.h"
 #include "loader.h"
 #include "config.h"
 #include "globalconfig.h"
@@ -33,11 +37,144 @@ void showHelp(QTextStream& out, bool fullHelp = true)
                " -s <ev>   Sort and show counters for event <ev>\n"
                " -c        Sort by call count\n"
                " -b        Show butterfly (callers and callees)\n"
-               " -n        Do not detect recursive cycles\n";
+               " -n        Do not detect recursive cycles\n"
+               " -j <n>    Load files with <n> threads (0: one per core)\n"
+               " -x        Use and write binary cache files\n"
+               " -t        Show time needed for loading\n"
+               " -m        Show memory used by loaded profile data\n"
+               " -g <n>    Load generated profile with hub functions calling\n"
+               "           <n> functions each (loader benchmark, use with -t)\n"
+               " -p <n>    Benchmark parsing of <n> generated cost lines\n"
+               " -y <n>    Benchmark cycle detection on deep and wide generated\n"
+               "           call graphs with <n> functions\n";
 
     exit(1);
 }
 
+/*
+ * Write a synthetic profile with a few hub functions each calling
+ * the same <callees> leaf functions. Loading it stresses lookup of
+ * calls of functions with a lot of callees.
+ */
+void writeHubProfile(QIODevice* file, int callees)
+{
+    const int hubs = 10;
+    QTextStream s(file);
+
+    s << "# callgrind format\nversion: 1\ncreator: cgview\n"
+         "positions: line\nevents: Ir\n\nfl=(1) hub.c\n";
+    for (int h = 0; h < hubs; h++) {
+        s << "\nfn=(" << h + 1 << ") hub" << h << "\n1 10\n";
+        for (int c = 0; c < callees; c++) {
+            s << "cfn=(" << hubs + c + 1 << ")";
+            if (h == 0) s << " leaf" << c;
+            s << "\ncalls=1 1\n2 100\n";
+        }
+    }
+    for (int c = 0; c < callees; c++)
+        s << "\nfn=(" << hubs + c + 1 << ")\n1 100\n";
+}
+
+/*
+ * Microbenchmark for parsing cost lines with a relative line number
+ * and 12 events: vectorized parsing used by the loader against value
+ * by value parsing as done before.
+ */
+void benchmarkParsing(QTextStream& out, int lines)
+{
+    const int events = 12;
+    if (lines <= 0) return;
+
+    QByteArray data;
+    QVector<int> lineStart;
+    for (int l = 0; l < lines; l++) {
+        lineStart.append(data.size());
+        data += '+' + QByteArray::number(l % 7);
+        for (int e = 0; e < events; e++)
+            data += ' ' + QByteArray::number((l * 7919ULL + e * 104729ULL) %
+                                              (e < 4 ? 100000000 : 1000));
+        data += '\n';
+    }
+    lineStart.append(data.size());
+
+    uint64 v[events];
+    uint64 sum[2] = { 0, 0 };
+    qint64 elapsed[2];
+    for (int variant = 0; variant < 2; variant++) {
+        QElapsedTimer timer;
+        timer.start();
+        PositionSpec current, pos;
+        for (int l = 0; l < lines; l++) {
+            FixString s(data.constData() + lineStart[l],
+                        lineStart[l+1] - lineStart[l] - 1);
+            int n = 0;
+            if (variant == 0) {
+                pos.parse(s, current, false, true);
+                n = s.stripUInt64s(v, events);
+            }
+            else {
+                char c;
+                uint diff;
+                s.stripFirst(c);
+                s.stripUInt(diff);
+                pos.fromLine = current.fromLine + diff;
+                while ((n < events) && s.stripUInt64(v[n])) n++;
+            }
+            current = pos;
+            for (int i = 0; i < n; i++) sum[variant] += v[i];
+        }
+        elapsed[variant] = timer.nsecsElapsed();
+    }
+
+    out << "Parsing " << lines << " cost lines with " << events << " events:\n"
+        << "  vectorized:     " << elapsed[0] / lines << " ns/line\n"
+        << "  value by value: " << elapsed[1] / lines << " ns/line\n";
+    if (sum[0] != sum[1])
+        out << "Error: results differ.\n";
+}
+
+/*
+ * Benchmark for cycle detection on two generated graphs with <nodes>
+ * functions: a deep one with a call chain closed into one cycle, and
+ * a wide one with 5 random calls per function.
+ */
+void benchmarkCycles(QTextStream& out, int nodes)
+{
+    if (nodes <= 0) return;
+
+    for (int variant = 0; variant < 2; variant++) {
+        QVector<int> start, targets;
+        start.reserve(nodes + 1);
+        quint32 random = 12345;
+        for (int n = 0; n < nodes; n++) {
+            start.append(targets.count());
+            if (variant == 0)
+                targets.append((n + 1) % nodes);
+            else {
+                for (int e = 0; e < 5; e++) {
+                    // linear congruential generator, reproducible
+                    random = random * 1664525 + 1013904223;
+                    targets.append((random >> 8) % nodes);
+                }
+            }
+        }
+        start.append(targets.count());
+
+        QElapsedTimer timer;
+        timer.start();
+        StronglyConnectedComponents scc(start, targets);
+        qint64 elapsed = timer.elapsed();
+
+        int cycles = 0;
+        for (int c = 0; c < scc.count(); c++)
+            if (scc.size(c) > 1) cycles++;
+
+        out << (variant == 0 ? "Deep" : "Wide") << " graph with " << nodes
+            << " functions and " << targets.count() << " calls: "
+            << cycles << " cycles found in " << elapsed << " ms.\n";
+    }
+}
+
 
 int main(int argc, char** argv)
 {
@@ -55,8 +192,11 @@ int main(int argc, char** argv)
     bool sortByExcl = false;
     bool sortByCount = false;
     bool showCalls = false;
+    bool showLoadTime = false;
+    bool showMemoryUsage = false;
     QString showEvent;
     QStringList files;
+    QTemporaryFile generated;
 
     for(int arg = 0; arg<list.count(); arg++) {
         if      (list[arg] == QLatin1String("-h")) showHelp(out);
@@ -65,11 +205,39 @@ int main(int argc, char** argv)
         else if (list[arg] == QLatin1String("-b")) showCalls = true;
         else if (list[arg] == QLatin1String("-c")) sortByCount = true;
         else if (list[arg] == QLatin1String("-s")) showEvent = list[++arg];
+        else if (list[arg] == QLatin1String("-j"))
+            GlobalConfig::setLoadThreads(list[++arg].toInt());
+        else if (list[arg] == QLatin1String("-x")) GlobalConfig::setUseCacheFiles(true);
+        else if (list[arg] == QLatin1String("-t")) showLoadTime = true;
+        else if (list[arg] == QLatin1String("-m")) showMemoryUsage = true;
+        else if (list[arg] == QLatin1String("-p")) {
+            benchmarkParsing(out, list[++arg].toInt());
+            return 0;
+        }
+        else if (list[arg] == QLatin1String("-y")) {
+            benchmarkCycles(out, list[++arg].toInt());
+            return 0;
+        }
+        else if (list[arg] == QLatin1String("-g")) {
+            if (!generated.open()) {
+                out << "Error: can not create temporary file.\n";
+                return 1;
+            }
+            writeHubProfile(&generated, list[++arg].toInt());
+            generated.close();
+            files << generated.fileName();
+        }
         else
             files << list[arg];
     }
     TraceData* d = new TraceData(new Logger);
+    QElapsedTimer loadTimer;
+    loadTimer.start();
     d->load(files);
+    if (showLoadTime)
+        out << "Loading took " << loadTimer.elapsed() << " ms.\n";
+    if (showMemoryUsage)
+        out << "\nMemory usage:\n" << d->memoryUsage().toString();
 
     EventTypeSet* m = d->eventTypes();
     if (m->realCount() == 0) {
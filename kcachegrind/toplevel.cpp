@@ -31,6 +31,7 @@
 #include <QStatusBar>
 #include <QTemporaryFile>
 #include <QTimer>
+#include <QToolButton>
 #include <QUrl>
 #include <QDBusConnection>
 
@@ -62,6 +63,8 @@
 #include "stackselection.h"
 #include "stackbrowser.h"
 #include "tracedata.h"
+#include "backgroundload.h"
+#include "pool.h"
 #include "globalguiconfig.h"
 #include "config.h"
 #include "configdlg.h"
@@ -79,6 +82,20 @@ TopLevel::TopLevel()
     _statusbar->addWidget(_statusLabel, 1);
     _ccProcess = nullptr;
 
+    _backgroundLoad = nullptr;
+    _loadTimer = new QTimer(this);
+    _loadTimer->setSingleShot(true);
+    _loadTimer->setInterval(100);
+    connect(_loadTimer, &QTimer::timeout,
+            this, &TopLevel::checkBackgroundLoad);
+    _cancelLoadButton = new QToolButton(_statusbar);
+    _cancelLoadButton->setText(i18n("Cancel"));
+    _cancelLoadButton->setToolTip(i18n("Stop loading of profile data"));
+    _statusbar->addPermanentWidget(_cancelLoadButton);
+    _cancelLoadButton->hide();
+    connect(_cancelLoadButton, &QToolButton::clicked,
+            this, &TopLevel::cancelLoad);
+
     _layoutCount = 1;
     _layoutCurrent = 0;
 
@@ -86,6 +103,7 @@ TopLevel::TopLevel()
 
     KConfig *kconfig = KSharedConfig::openConfig().data();
     GlobalGUIConfig::config()->readOptions();
+    FixPool::setUseHugePages(GlobalConfig::useHugePages());
 
     createDocks();
 
@@ -336,6 +354,7 @@ void TopLevel::createDocks()
 
 TopLevel::~TopLevel()
 {
+    cancelLoad();
     delete _data;
 }
 
@@ -436,6 +455,15 @@ void TopLevel::createMiscActions()
                 "of the GraphViz package.</p>");
     action->setWhatsThis( hint );
 
+    action = actionCollection()->addAction( QStringLiteral("memory_usage") );
+    action->setText( i18n( "&Memory Usage" ) );
+    connect(action, &QAction::triggered, this, &TopLevel::showMemoryUsage);
+
+    hint = i18n("<b>Memory Usage</b>"
+                "<p>Shows the memory used by the loaded profile data, "
+                "split into categories.</p>");
+    action->setWhatsThis( hint );
+
 
     _taDump = actionCollection()->add<KToggleAction>( QStringLiteral("dump") );
     _taDump->setIcon( QIcon::fromTheme(QStringLiteral("edit-redo")) );
@@ -944,11 +972,7 @@ void TopLevel::load(QString file)
         return;
     }
 
-    bool loaded = openDataFile(file);
-    if (!loaded && showError)
-        KMessageBox::error(this, i18n("Could not open the file \"%1\". "
-                                      "Check it exists and you have enough "
-                                      "permissions to read it.", file));
+    openDataFile(file, showError);
 }
 
 
@@ -1022,9 +1046,7 @@ void TopLevel::loadTraceDelayed()
 
     if (_loadFilesDelayed.count()>1) {
         // FIXME: we expect all files to be local and existing
-        TraceData* d = new TraceData(this);
-        d->load(_loadFilesDelayed);
-        setData(d);
+        startLoad(new BackgroundLoad(new TraceData(this), _loadFilesDelayed));
     }
     else {
         QString file = _loadFilesDelayed[0];
@@ -1059,6 +1081,16 @@ void TopLevel::exportGraph()
     GraphExporter::savePrompt(this, _data, _function, _eventType, _groupType, nullptr);
 }
 
+void TopLevel::showMemoryUsage()
+{
+    if (!_data) return;
+
+    QString text = _data->memoryUsage().toString();
+    KMessageBox::information(this, QStringLiteral("<pre>%1</pre>")
+                             .arg(text.toHtmlEscaped()),
+                             i18n("Memory Usage"));
+}
+
 
 void TopLevel::setEventType(QString s)
 {
@@ -1859,6 +1891,7 @@ void TopLevel::configure()
 
 bool TopLevel::queryClose()
 {
+    cancelLoad();
     saveTraceSettings();
 
     // save current toplevel options as defaults...
@@ -2332,10 +2365,10 @@ void TopLevel::loadWarning(int line, const QString& msg)
     qWarning() << "Loading" << _filename << ":" << line << ": " << msg;
 }
 
-bool TopLevel::openDataFile(const QString& file)
+void TopLevel::openDataFile(const QString& file, bool showError)
 {
     TraceData* d = new TraceData(this);
-    int filesLoaded;
+    BackgroundLoad* load;
 
     // see whether this file is compressed, than take the direct route
     QMimeDatabase dataBase;
@@ -2347,17 +2380,79 @@ bool TopLevel::openDataFile(const QString& file)
                                         compressionType);
     if (compressed &&
         (compressed->compressionType() != KCompressionDevice::None)) {
-        filesLoaded = d->load(compressed, file);
+        load = new BackgroundLoad(d, compressed, file);
     } else {
         // else fallback to string based method that can also find multi-part callgrind data.
-        filesLoaded = d->load(file);
+        delete compressed;
+        load = new BackgroundLoad(d, QStringList(file));
     }
-    if (filesLoaded > 0) {
-        setData(d);
-        return true;
-    } else {
-        return false;
+    startLoad(load, showError ? file : QString());
+}
+
+void TopLevel::startLoad(BackgroundLoad* load, const QString& errorFile)
+{
+    // only one load at a time
+    cancelLoad();
+
+    _backgroundLoad = load;
+    _loadErrorFile = errorFile;
+    _cancelLoadButton->show();
+    load->start();
+    _loadTimer->start();
+}
+
+// merge loaded parts, and show them
+void TopLevel::checkBackgroundLoad()
+{
+    if (!_backgroundLoad) return;
+
+    TraceData* d = _backgroundLoad->data();
+    if (_backgroundLoad->mergeLoaded() > 0) {
+        if (d != _data)
+            setData(d);
+        else {
+            // GUI update for added parts
+            _partSelection->hiddenPartsChangedSlot(_hiddenParts);
+            configChanged();
+
+            if (_data->parts().count()>1 && !_partDock->isVisible()) {
+                _partDock->show();
+                _partDockShown->setChecked(true);
+            }
+        }
     }
+
+    if (!_backgroundLoad->isFinished()) {
+        showStatus(i18n("Loading %1", _backgroundLoad->currentFile()),
+                   _backgroundLoad->progress());
+        _loadTimer->start();
+        return;
+    }
+
+    bool loaded = (_backgroundLoad->partsLoaded() > 0);
+    QString errorFile = _loadErrorFile;
+    cancelLoad();
+
+    if (!loaded && !errorFile.isEmpty())
+        KMessageBox::error(this, i18n("Could not open the file \"%1\". "
+                                      "Check it exists and you have enough "
+                                      "permissions to read it.", errorFile));
+}
+
+void TopLevel::cancelLoad()
+{
+    if (!_backgroundLoad) return;
+
+    _loadTimer->stop();
+    TraceData* d = _backgroundLoad->data();
+    // this waits for loading threads to stop
+    delete _backgroundLoad;
+    _backgroundLoad = nullptr;
+    _cancelLoadButton->hide();
+    showStatus(QString(), 0);
+
+    // keep parts already shown
+    if (d != _data) delete d;
 }
 
 #include "moc_toplevel.cpp"
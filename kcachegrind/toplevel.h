@@ -30,6 +30,8 @@ class QLineEdit;
 class QDockWidget;
 class QLabel;
 class QProgressBar;
+class QTimer;
+class QToolButton;
 class QMenu;
 
 class QUrl;
@@ -39,6 +41,7 @@ class KToolBarPopupAction;
 class KStatusBar;
 
 class TraceData;
+class BackgroundLoad;
 class KRecentFilesAction;
 class MainWidget;
 class PartSelection;
@@ -100,6 +103,7 @@ public Q_SLOTS:
 
     void reload();
     void exportGraph();
+    void showMemoryUsage();
     void newWindow();
     void configure();
     void querySlot();
@@ -188,6 +192,10 @@ public Q_SLOTS:
     void loadTraceDelayed();
     void setDirectionDelayed();
 
+    // for loading in the background
+    void checkBackgroundLoad();
+    void cancelLoad();
+
     // configuration has changed
     void configChanged() override;
 
@@ -215,9 +223,11 @@ private:
     void restoreTraceTypes();
     void restoreTraceSettings();
     void updateViewsOnChange(int);
-    /// open @p file, might be compressed
-    /// @return true when the file could be opened, false otherwise.
-    bool openDataFile(const QString& file);
+    /// open @p file in the background, might be compressed.
+    /// With @p showError, a failure to open is reported at the end.
+    void openDataFile(const QString& file, bool showError = false);
+    /// start background loading; errors are reported for @p errorFile
+    void startLoad(BackgroundLoad*, const QString& errorFile = QString());
 
     QStatusBar* _statusbar;
     QLabel* _statusLabel;
@@ -275,6 +285,12 @@ private:
     QElapsedTimer _progressStart;
     QProgressBar* _progressBar;
 
+    // background loading, with data shown as soon as parts are merged
+    BackgroundLoad* _backgroundLoad;
+    QString _loadErrorFile;
+    QTimer* _loadTimer;
+    QToolButton* _cancelLoadButton;
+
     // toplevel configuration options
     bool _showPercentage, _showExpanded, _showCycles, _hideTemplates;
 
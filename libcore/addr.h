@@ -29,6 +29,7 @@ public:
     // and return number of interpreted chars.
     int set(const char *s);
     bool set(FixString& s);
+    uint64 v() const { return _v; }
     QString toString() const;
     // similar to toString(), but adds a space every 4 digits
     QString pretty() const;
@@ -0,0 +1,174 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Loading of profile data in background threads
+ */
+
+#include "backgroundload.h"
+
+#include <QFile>
+#include <QIODevice>
+#include <QThread>
+
+#include "globalconfig.h"
+#include "logger.h"
+#include "tracedata.h"
+
+
+struct BackgroundLoad::FileLoad {
+    QString file;
+    BufferedLogger logger;
+    // staging trace, not used with direct loading
+    TraceData* data;
+    int partsLoaded;
+    QAtomicInt done;
+};
+
+
+//---------------------------------------------------
+// BackgroundLoad
+
+BackgroundLoad::BackgroundLoad(TraceData* data, const QStringList& files)
+{
+    _data = data;
+    _device = nullptr;
+    _logger = nullptr;
+    _merged = 0;
+    _partsLoaded = 0;
+
+    foreach(const QString& file, _data->prepareLoad(files))
+        addFile(file);
+    _direct = (_loads.count() == 1);
+}
+
+BackgroundLoad::BackgroundLoad(TraceData* data, QIODevice* device,
+                               const QString& filename)
+{
+    _data = data;
+    _device = device;
+    _logger = nullptr;
+    _merged = 0;
+    _partsLoaded = 0;
+
+    _data->_traceName = filename;
+    addFile(filename);
+    _direct = true;
+}
+
+BackgroundLoad::~BackgroundLoad()
+{
+    cancel();
+    _pool.waitForDone();
+
+    if (_direct && _logger)
+        _data->_logger = _logger;
+    _data->setLoadCancel(nullptr);
+
+    foreach(FileLoad* load, _loads)
+        delete load->data;
+    qDeleteAll(_loads);
+    delete _device;
+}
+
+void BackgroundLoad::addFile(const QString& file)
+{
+    FileLoad* load = new FileLoad;
+    load->file = file;
+    load->data = nullptr;
+    load->partsLoaded = 0;
+    _loads.append(load);
+}
+
+void BackgroundLoad::start()
+{
+    if (_loads.isEmpty()) return;
+
+    int threads = GlobalConfig::loadThreads();
+    if (threads == 0) threads = QThread::idealThreadCount();
+    if (threads > _loads.count()) threads = _loads.count();
+    _pool.setMaxThreadCount(threads);
+
+    _data->setLoadCancel(&_canceled);
+    if (_direct) {
+        // notifications have to be forwarded from our thread
+        _logger = _data->_logger;
+        _data->_logger = &_loads[0]->logger;
+    }
+
+    foreach(FileLoad* load, _loads)
+        _pool.start([this, load]() { loadFile(load); });
+}
+
+void BackgroundLoad::loadFile(FileLoad* load)
+{
+    if (!_direct)
+        load->data = TraceData::loadStaged(load->file, &load->logger,
+                                           &_canceled);
+    else {
+        QFile file(load->file);
+        QIODevice* device = _device ? _device : &file;
+        load->partsLoaded = _data->internalLoad(device, load->file);
+        if ((load->partsLoaded > 0) && !isCanceled())
+            _data->finishLoad();
+    }
+    load->done.storeRelease(1);
+}
+
+void BackgroundLoad::cancel()
+{
+    _canceled.storeRelaxed(1);
+}
+
+int BackgroundLoad::mergeLoaded()
+{
+    int partsLoaded = 0;
+    while ((_merged < _loads.count()) && !isCanceled()) {
+        FileLoad* load = _loads[_merged];
+        if (!load->done.loadAcquire()) break;
+
+        if (_direct) {
+            _data->_logger = _logger;
+            _logger = nullptr;
+            partsLoaded += load->partsLoaded;
+        }
+        load->logger.forward(_data->_logger);
+        if (load->data) {
+            partsLoaded += _data->mergeStaged(load->data);
+            delete load->data;
+            load->data = nullptr;
+        }
+        _merged++;
+    }
+
+    // costs of directly loaded trace already are updated
+    if ((partsLoaded > 0) && !_direct)
+        _data->finishLoad();
+
+    _partsLoaded += partsLoaded;
+    return partsLoaded;
+}
+
+bool BackgroundLoad::isFinished() const
+{
+    return isCanceled() || (_merged == _loads.count());
+}
+
+int BackgroundLoad::progress() const
+{
+    if (_loads.isEmpty()) return 100;
+
+    int sum = 0;
+    foreach(FileLoad* load, _loads)
+        sum += load->done.loadAcquire() ? 100 : load->logger.progress();
+    return sum / _loads.count();
+}
+
+QString BackgroundLoad::currentFile() const
+{
+    if (_merged >= _loads.count()) return QString();
+    return _loads[_merged]->file;
+}
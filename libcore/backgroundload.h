@@ -0,0 +1,101 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Loading of profile data in background threads
+ */
+
+#ifndef BACKGROUNDLOAD_H
+#define BACKGROUNDLOAD_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+class QIODevice;
+class Logger;
+class TraceData;
+
+/**
+ * Loads profile data files into a trace in background threads, for
+ * front ends which should stay responsive and allow to cancel loading.
+ *
+ * With multiple files, each one is loaded into its own staging trace
+ * (see TraceData::loadStaged()). The front end regularly calls
+ * mergeLoaded() from its own thread, which moves files finished up to
+ * now into the trace, in file order. Thus, the trace can be shown
+ * and inspected while further files still are loading.
+ *
+ * A single file is loaded directly into the trace, which must not be
+ * accessed until finished then. This allows the loader to use
+ * multiple threads for one big file.
+ *
+ * Notifications are forwarded to the logger of the trace on merging.
+ * The trace must exist as long as this object.
+ */
+class BackgroundLoad
+{
+public:
+    /**
+     * Load @p files into the empty trace @p data. As with
+     * TraceData::load(), a single file is taken as prefix.
+     */
+    BackgroundLoad(TraceData* data, const QStringList& files);
+    // load from @p device into empty trace @p data; @p device is taken over
+    BackgroundLoad(TraceData* data, QIODevice* device, const QString& filename);
+    // cancels loading and waits for background threads
+    ~BackgroundLoad();
+
+    TraceData* data() const { return _data; }
+    // number of files to load, 0 if nothing found
+    int fileCount() const { return _loads.count(); }
+
+    void start();
+    /**
+     * Stops loading. Files merged up to now stay in the trace. If the
+     * trace was loaded directly, it may be incomplete: delete it.
+     */
+    void cancel();
+    bool isCanceled() const { return _canceled.loadRelaxed() != 0; }
+
+    /**
+     * Moves files loaded up to now into the trace, and updates its
+     * dynamic costs and cycles. Must be called from the thread
+     * owning the trace. Returns the number of new parts.
+     */
+    int mergeLoaded();
+    // true if all files are merged, or loading is canceled
+    bool isFinished() const;
+    // parts merged up to now
+    int partsLoaded() const { return _partsLoaded; }
+
+    // progress over all files, 0 - 100
+    int progress() const;
+    // first file not merged yet
+    QString currentFile() const;
+
+private:
+    struct FileLoad;
+
+    void addFile(const QString& file);
+    void loadFile(FileLoad*);
+
+    TraceData* _data;
+    QIODevice* _device;
+    // single file loaded directly into _data
+    bool _direct;
+    // logger of _data while loading directly
+    Logger* _logger;
+
+    QThreadPool _pool;
+    QList<FileLoad*> _loads;
+    int _merged, _partsLoaded;
+    QAtomicInt _canceled;
+};
+
+#endif // BACKGROUNDLOAD_H
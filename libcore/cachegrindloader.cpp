@@ -7,19 +7,29 @@
 */
 
 #include "loader.h"
+#include "cacheloader.h"
 
 #include <QIODevice>
+#include <QFile>
 #include <QVector>
 #include <QDebug>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
 
 #include "addr.h"
 #include "tracedata.h"
 #include "utils.h"
 #include "fixcost.h"
+#include "logger.h"
+#include "globalconfig.h"
 
 
 #define TRACE_LOADER 0
 
+// files smaller than this are never parsed in chunks by multiple threads
+#define CHUNKED_LOAD_MINSIZE (64*1024*1024)
+
 /*
  * Loader for Callgrind Profile data (format based on Cachegrind format).
  * See Callgrind documentation for the file format.
@@ -32,12 +42,39 @@ public:
 
     bool canLoad(QIODevice* file) override;
     int  load(TraceData*, QIODevice* file, const QString& filename) override;
+    Loader* clone() const override;
 
 private:
     void error(QString);
     void warning(QString);
 
     int loadInternal(TraceData*, QIODevice* file, const QString& filename);
+    bool parseLines(FixFile& file);
+    void writeCache(int parts);
+
+    /* Support for parsing a file in chunks by multiple threads.
+     * Chunks start at "fn=" lines. A pre-pass over the file records
+     * the ELF object and file set at chunk start, and all definitions
+     * of compressed names, as chunks may refer to names defined in
+     * previous ones.
+     */
+    struct Chunk {
+        uint64 start, end;
+        int lineNo;
+        bool hasObject, hasFunctionFile;
+        QString object, functionFile;
+    };
+    struct NameDefinitions {
+        QVector<QString> objects, files, functions;
+        // object and file names in effect at function definition
+        QVector<QString> functionObjects, functionFiles;
+    };
+    int loadChunked(FixFile& file, int count);
+    bool scanChunks(FixFile& file, int count, uint64& headerEnd,
+                    QVector<Chunk>& chunks, NameDefinitions& defs);
+    void loadChunk(TraceData*, FixFile& file, const QString& filename,
+                   uint64 headerEnd, const Chunk& chunk,
+                   const NameDefinitions* defs);
 
     enum lineType { SelfCost, CallCost, BoringJump, CondJump };
 
@@ -48,17 +85,20 @@ private:
     void ensureObject();
     void ensureFile();
     void ensureFunction();
-    void setObject(const QString&);
-    void setCalledObject(const QString&);
-    void setFile(const QString&);
-    void setCalledFile(const QString&);
-    void setFunction(const QString&);
-    void setCalledFunction(const QString&);
+    void setObject(FixString&);
+    void setCalledObject(FixString&);
+    void setFile(FixString&);
+    void setCalledFile(FixString&);
+    void setFunction(FixString&);
+    void setCalledFunction(FixString&);
 
     void prepareNewPart();
 
     QString _emptyString;
 
+    // derived event types declared in the file, for the cache file
+    QList<CacheLoader::EventDefinition> _eventDefinitions;
+
     // current line in file to read in
     QString _filename;
     int _lineNo;
@@ -67,6 +107,8 @@ private:
     TraceData* _data;
     TracePart* _part;
     int partsAdded;
+    FixPool* _pool;
+    int _statusProgress;
 
     // current position
     lineType nextLineType;
@@ -102,6 +144,19 @@ private:
     PositionSpec targetPos;
     SubCost jumpsFollowed, jumpsExecuted;
 
+    /* Support for reading costs of instructions on demand, see
+     * GlobalConfig::lazyInstrDetail(). Self costs get summed up per
+     * source line into <_lineCost>, and the file ranges with cost lines
+     * of a part function are recorded as FixInstrRange objects.
+     */
+    bool _lazyDetail;
+    uint64 _detailFileSize;
+    FixCost* _lineCost;
+    TracePartFunction* _lineCostFunction;
+    FixInstrRange* _instrRange;
+    TracePartFunction* _instrRangeFunction;
+    QVector<SubCost> _zeroCost;
+
     /** Support for compressed string format
    * This uses the following string compression model
    * for objects, files, functions:
@@ -115,12 +170,17 @@ private:
    */
     void clearCompression();
     const QString& checkUnknown(const QString& n);
-    TraceObject* compressedObject(const QString& name);
-    TraceFile* compressedFile(const QString& name);
-    TraceFunction* compressedFunction(const QString& name,
+    TraceObject* compressedObject(FixString name);
+    TraceFile* compressedFile(FixString name);
+    TraceFunction* compressedFunction(FixString name,
                                       TraceFile*, TraceObject*);
+    // for compressed names defined before the chunk loaded
+    TraceObject* definedObject(int index);
+    TraceFile* definedFile(int index);
+    TraceFunction* definedFunction(int index);
 
     QVector<TraceCostItem*> _objectVector, _fileVector, _functionVector;
+    const NameDefinitions* _nameDefinitions;
 };
 
 
@@ -134,6 +194,9 @@ CachegrindLoader::CachegrindLoader()
     : Loader(QStringLiteral("Callgrind"),
              QObject::tr( "Import filter for Cachegrind/Callgrind generated profile data files") )
 {
+    _nameDefinitions = nullptr;
+    _lazyDetail = false;
+    _detailFileSize = 0;
 }
 
 bool CachegrindLoader::canLoad(QIODevice* file)
@@ -183,6 +246,11 @@ int CachegrindLoader::load(TraceData* d,
     return l.loadInternal(d, file, filename);
 }
 
+Loader* CachegrindLoader::clone() const
+{
+    return new CachegrindLoader();
+}
+
 Loader* createCachegrindLoader()
 {
     return new CachegrindLoader();
@@ -204,122 +272,31 @@ void CachegrindLoader::warning(QString msg)
 bool CachegrindLoader::parsePosition(FixString& line,
                                      PositionSpec& newPos)
 {
-    char c;
-    uint diff;
+    int negativeLine = 0;
 
-    if (hasAddrInfo) {
+    if (!newPos.parse(line, currentPos, hasAddrInfo, hasLineInfo,
+                      &negativeLine))
+        return false;
 
-        if (!line.first(c)) return false;
-
-        if (c == '*') {
-            // nothing changed
-            line.stripFirst(c);
-            newPos.fromAddr = currentPos.fromAddr;
-            newPos.toAddr = currentPos.toAddr;
-        }
-        else if (c == '+') {
-            line.stripFirst(c);
-            line.stripUInt(diff, false);
-            newPos.fromAddr = currentPos.fromAddr + diff;
-            newPos.toAddr = newPos.fromAddr;
-        }
-        else if (c == '-') {
-            line.stripFirst(c);
-            line.stripUInt(diff, false);
-            newPos.fromAddr = currentPos.fromAddr - diff;
-            newPos.toAddr = newPos.fromAddr;
-        }
-        else if (c >= '0') {
-            uint64 v;
-            line.stripUInt64(v, false);
-            newPos.fromAddr = Addr(v);
-            newPos.toAddr = newPos.fromAddr;
-        }
-        else return false;
-
-        // Range specification
-        if (line.first(c)) {
-            if (c == '+') {
-                line.stripFirst(c);
-                line.stripUInt(diff);
-                newPos.toAddr = newPos.fromAddr + diff;
-            }
-            else if ((c == '-') || (c == ':')) {
-                line.stripFirst(c);
-                uint64 v;
-                line.stripUInt64(v);
-                newPos.toAddr = Addr(v);
-            }
-        }
-        line.stripSpaces();
+    if (negativeLine < 0)
+        error(QStringLiteral("Negative line number %1").arg(negativeLine));
 
 #if TRACE_LOADER
+    if (hasAddrInfo) {
         if (newPos.fromAddr == newPos.toAddr)
             qDebug() << " Got Addr " << newPos.fromAddr.toString();
         else
             qDebug() << " Got AddrRange " << newPos.fromAddr.toString()
                      << ":" << newPos.toAddr.toString();
-#endif
-
     }
-
     if (hasLineInfo) {
-
-        if (!line.first(c)) return false;
-
-        if (c > '9') return false;
-        else if (c == '*') {
-            // nothing changed
-            line.stripFirst(c);
-            newPos.fromLine = currentPos.fromLine;
-            newPos.toLine   = currentPos.toLine;
-        }
-        else if (c == '+') {
-            line.stripFirst(c);
-            line.stripUInt(diff, false);
-            newPos.fromLine = currentPos.fromLine + diff;
-            newPos.toLine = newPos.fromLine;
-        }
-        else if (c == '-') {
-            line.stripFirst(c);
-            line.stripUInt(diff, false);
-            if (currentPos.fromLine < diff) {
-                error(QStringLiteral("Negative line number %1")
-                      .arg((int)currentPos.fromLine - (int)diff));
-                diff = currentPos.fromLine;
-            }
-            newPos.fromLine = currentPos.fromLine - diff;
-            newPos.toLine = newPos.fromLine;
-        }
-        else if (c >= '0') {
-            line.stripUInt(newPos.fromLine, false);
-            newPos.toLine = newPos.fromLine;
-        }
-        else return false;
-
-        // Range specification
-        if (line.first(c)) {
-            if (c == '+') {
-                line.stripFirst(c);
-                line.stripUInt(diff);
-                newPos.toLine = newPos.fromLine + diff;
-            }
-            else if ((c == '-') || (c == ':')) {
-                line.stripFirst(c);
-                line.stripUInt(newPos.toLine);
-            }
-        }
-        line.stripSpaces();
-
-#if TRACE_LOADER
         if (newPos.fromLine == newPos.toLine)
             qDebug() << " Got Line " << newPos.fromLine;
         else
             qDebug() << " Got LineRange " << newPos.fromLine
                      << ":" << newPos.toLine;
-#endif
-
     }
+#endif
 
     return true;
 }
@@ -344,21 +321,39 @@ const QString& CachegrindLoader::checkUnknown(const QString& n)
     return n;
 }
 
-TraceObject* CachegrindLoader::compressedObject(const QString& name)
+/* Strip compression id "(<Integer>)" and following spaces from <name>.
+ * Works on the bytes of the line: QStrings are only needed for names.
+ * Returns the id, -1 for a regular name, or -2 if invalid.
+ */
+static int stripCompressionId(FixString& name)
 {
-    if ((name[0] != '(') || !name[1].isDigit()) return _data->object(checkUnknown(name));
+    char c;
+    uint index;
+
+    FixString s = name;
+    if (!s.stripFirst(c) || (c != '(')) return -1;
+    if (!s.first(c) || (c < '0') || (c > '9')) return -1;
+
+    s.stripUInt(index, false);
+    if (!s.stripFirst(c) || (c != ')')) return -2;
+    s.stripSpaces();
+
+    name = s;
+    return (int) index;
+}
+
+TraceObject* CachegrindLoader::compressedObject(FixString name)
+{
+    int index = stripCompressionId(name);
+    if (index == -1) return _data->object(checkUnknown(name));
 
     // compressed format using _objectVector
-    int p = name.indexOf(')');
-    if (p<2) {
+    if (index < 0) {
         error(QStringLiteral("Invalid compressed ELF object ('%1')").arg(name));
         return nullptr;
     }
-    int index = name.mid(1, p-1).toInt();
     TraceObject* o = nullptr;
-    p++;
-    while((name.length()>p) && name.at(p).isSpace()) p++;
-    if (name.length()>p) {
+    if (!name.isEmpty()) {
         if (_objectVector.size() <= index) {
             int newSize = index * 2;
 #if TRACE_LOADER
@@ -368,7 +363,7 @@ TraceObject* CachegrindLoader::compressedObject(const QString& name)
             _objectVector.resize(newSize);
         }
 
-        QString realName = checkUnknown(name.mid(p));
+        QString realName = checkUnknown(name);
         o = (TraceObject*) _objectVector.at(index);
         if (o && (o->name() != realName)) {
             error(QStringLiteral("Redefinition of compressed ELF object index %1 (was '%2') to %3")
@@ -381,8 +376,11 @@ TraceObject* CachegrindLoader::compressedObject(const QString& name)
     else {
         if ((_objectVector.size() <= index) ||
             ( (o=(TraceObject*)_objectVector.at(index)) == nullptr)) {
-            error(QStringLiteral("Undefined compressed ELF object index %1").arg(index));
-            return nullptr;
+            o = definedObject(index);
+            if (!o) {
+                error(QStringLiteral("Undefined compressed ELF object index %1").arg(index));
+                return nullptr;
+            }
         }
     }
 
@@ -392,21 +390,18 @@ TraceObject* CachegrindLoader::compressedObject(const QString& name)
 
 // Note: Callgrind sometimes gives different IDs for same file
 // (when references to same source file come from different ELF objects)
-TraceFile* CachegrindLoader::compressedFile(const QString& name)
+TraceFile* CachegrindLoader::compressedFile(FixString name)
 {
-    if ((name[0] != '(') || !name[1].isDigit()) return _data->file(checkUnknown(name));
+    int index = stripCompressionId(name);
+    if (index == -1) return _data->file(checkUnknown(name));
 
     // compressed format using _fileVector
-    int p = name.indexOf(')');
-    if (p<2) {
+    if (index < 0) {
         error(QStringLiteral("Invalid compressed file ('%1')").arg(name));
         return nullptr;
     }
-    int index = name.mid(1, p-1).toUInt();
     TraceFile* f = nullptr;
-    p++;
-    while((name.length()>p) && name.at(p).isSpace()) p++;
-    if (name.length()>p) {
+    if (!name.isEmpty()) {
         if (_fileVector.size() <= index) {
             int newSize = index * 2;
 #if TRACE_LOADER
@@ -416,7 +411,7 @@ TraceFile* CachegrindLoader::compressedFile(const QString& name)
             _fileVector.resize(newSize);
         }
 
-        QString realName = checkUnknown(name.mid(p));
+        QString realName = checkUnknown(name);
         f = (TraceFile*) _fileVector.at(index);
         if (f && (f->name() != realName)) {
             error(QStringLiteral("Redefinition of compressed file index %1 (was '%2') to %3")
@@ -429,8 +424,11 @@ TraceFile* CachegrindLoader::compressedFile(const QString& name)
     else {
         if ((_fileVector.size() <= index) ||
             ( (f=(TraceFile*)_fileVector.at(index)) == nullptr)) {
-            error(QStringLiteral("Undefined compressed file index %1").arg(index));
-            return nullptr;
+            f = definedFile(index);
+            if (!f) {
+                error(QStringLiteral("Undefined compressed file index %1").arg(index));
+                return nullptr;
+            }
         }
     }
 
@@ -440,26 +438,20 @@ TraceFile* CachegrindLoader::compressedFile(const QString& name)
 // Note: Callgrind gives different IDs even for same function
 // when parts of the function are from different source files.
 // Thus, it is no error when multiple indexes map to same function.
-TraceFunction* CachegrindLoader::compressedFunction(const QString& name,
+TraceFunction* CachegrindLoader::compressedFunction(FixString name,
                                                     TraceFile* file,
                                                     TraceObject* object)
 {
-    if (name.size() < 2 || (name[0] != '(') || !name[1].isDigit())
-        return _data->function(checkUnknown(name), file, object);
+    int index = stripCompressionId(name);
+    if (index == -1) return _data->function(checkUnknown(name), file, object);
 
     // compressed format using _functionVector
-    int p = name.indexOf(')');
-    if (p<2) {
+    if (index < 0) {
         error(QStringLiteral("Invalid compressed function ('%1')").arg(name));
         return nullptr;
     }
-
-
-    int index = name.mid(1, p-1).toUInt();
     TraceFunction* f = nullptr;
-    p++;
-    while((name.length()>p) && name.at(p).isSpace()) p++;
-    if (name.length()>p) {
+    if (!name.isEmpty()) {
         if (_functionVector.size() <= index) {
             int newSize = index * 2;
 #if TRACE_LOADER
@@ -469,7 +461,7 @@ TraceFunction* CachegrindLoader::compressedFunction(const QString& name,
             _functionVector.resize(newSize);
         }
 
-        QString realName = checkUnknown(name.mid(p));
+        QString realName = checkUnknown(name);
         f = (TraceFunction*) _functionVector.at(index);
         if (f && (f->name() != realName)) {
             error(QStringLiteral("Redefinition of compressed function index %1 (was '%2') to %3")
@@ -490,8 +482,11 @@ TraceFunction* CachegrindLoader::compressedFunction(const QString& name,
     else {
         if ((_functionVector.size() <= index) ||
             ( (f=(TraceFunction*)_functionVector.at(index)) == nullptr)) {
-            error(QStringLiteral("Undefined compressed function index %1").arg(index));
-            return nullptr;
+            f = definedFunction(index);
+            if (!f) {
+                error(QStringLiteral("Undefined compressed function index %1").arg(index));
+                return nullptr;
+            }
         }
 
         // there was a check if the used function (returned from KCachegrinds
@@ -504,6 +499,49 @@ TraceFunction* CachegrindLoader::compressedFunction(const QString& name,
 }
 
 
+// Lookup of compressed names defined before the chunk we are loading
+TraceObject* CachegrindLoader::definedObject(int index)
+{
+    if (!_nameDefinitions || (_nameDefinitions->objects.size() <= index))
+        return nullptr;
+    const QString& name = _nameDefinitions->objects.at(index);
+    if (name.isNull()) return nullptr;
+
+    TraceObject* o = _data->object(checkUnknown(name));
+    if (_objectVector.size() <= index) _objectVector.resize(index * 2);
+    _objectVector.replace(index, o);
+    return o;
+}
+
+TraceFile* CachegrindLoader::definedFile(int index)
+{
+    if (!_nameDefinitions || (_nameDefinitions->files.size() <= index))
+        return nullptr;
+    const QString& name = _nameDefinitions->files.at(index);
+    if (name.isNull()) return nullptr;
+
+    TraceFile* f = _data->file(checkUnknown(name));
+    if (_fileVector.size() <= index) _fileVector.resize(index * 2);
+    _fileVector.replace(index, f);
+    return f;
+}
+
+TraceFunction* CachegrindLoader::definedFunction(int index)
+{
+    if (!_nameDefinitions || (_nameDefinitions->functions.size() <= index))
+        return nullptr;
+    const QString& name = _nameDefinitions->functions.at(index);
+    if (name.isNull()) return nullptr;
+
+    TraceFile* file = _data->file(checkUnknown(_nameDefinitions->functionFiles.at(index)));
+    TraceObject* object = _data->object(checkUnknown(_nameDefinitions->functionObjects.at(index)));
+    TraceFunction* f = _data->function(checkUnknown(name), file, object);
+    if (_functionVector.size() <= index) _functionVector.resize(index * 2);
+    _functionVector.replace(index, f);
+    return f;
+}
+
+
 // make sure that a valid object is set, at least dummy with empty name
 void CachegrindLoader::ensureObject()
 {
@@ -513,7 +551,7 @@ void CachegrindLoader::ensureObject()
     currentPartObject = currentObject->partObject(_part);
 }
 
-void CachegrindLoader::setObject(const QString& name)
+void CachegrindLoader::setObject(FixString& name)
 {
     currentObject = compressedObject(name);
     if (!currentObject) {
@@ -527,7 +565,7 @@ void CachegrindLoader::setObject(const QString& name)
     currentPartFunction = nullptr;
 }
 
-void CachegrindLoader::setCalledObject(const QString& name)
+void CachegrindLoader::setCalledObject(FixString& name)
 {
     currentCalledObject = compressedObject(name);
 
@@ -550,7 +588,7 @@ void CachegrindLoader::ensureFile()
     currentPartFile = currentFile->partFile(_part);
 }
 
-void CachegrindLoader::setFile(const QString& name)
+void CachegrindLoader::setFile(FixString& name)
 {
     currentFile = compressedFile(name);
 
@@ -565,7 +603,7 @@ void CachegrindLoader::setFile(const QString& name)
     currentPartLine = nullptr;
 }
 
-void CachegrindLoader::setCalledFile(const QString& name)
+void CachegrindLoader::setCalledFile(FixString& name)
 {
     currentCalledFile = compressedFile(name);
 
@@ -596,7 +634,7 @@ void CachegrindLoader::ensureFunction()
                                                         currentPartObject);
 }
 
-void CachegrindLoader::setFunction(const QString& name)
+void CachegrindLoader::setFunction(FixString& name)
 {
     ensureFile();
     ensureObject();
@@ -622,7 +660,7 @@ void CachegrindLoader::setFunction(const QString& name)
     currentPartLine = nullptr;
 }
 
-void CachegrindLoader::setCalledFunction(const QString& name)
+void CachegrindLoader::setCalledFunction(FixString& name)
 {
     // if called object/file not set, use current object/file
     if (!currentCalledObject) {
@@ -688,6 +726,11 @@ void CachegrindLoader::clearPosition()
     jumpsFollowed = 0;
     jumpsExecuted = 0;
 
+    _lineCost = nullptr;
+    _lineCostFunction = nullptr;
+    _instrRange = nullptr;
+    _instrRangeFunction = nullptr;
+
     mapping = nullptr;
 }
 
@@ -732,27 +775,106 @@ int CachegrindLoader::loadInternal(TraceData* data,
         return 0;
     }
 
-    int statusProgress = 0;
+    // costs of instructions can be read again on demand from plain files only
+    _lazyDetail = GlobalConfig::lazyInstrDetail() &&
+                  (qobject_cast<QFile*>(device) != nullptr);
+    _detailFileSize = file.len();
+
+    // parse huge files in chunks by multiple threads, if possible.
+    // Not for staging traces: these already get loaded in parallel.
+    // Chunks need the whole file mapped
+    if (!_data->isStaging() && !file.isWindowed() &&
+        (file.len() >= CHUNKED_LOAD_MINSIZE)) {
+        int threads = GlobalConfig::loadThreads();
+        if (threads == 0) threads = QThread::idealThreadCount();
+        if (threads > 1) {
+            int partsLoaded = loadChunked(file, threads);
+            if (partsLoaded >= 0) {
+                device->close();
+                if (_data->isLoadCanceled()) return 0;
+                loadFinished();
+                writeCache(partsLoaded);
+                return partsLoaded;
+            }
+        }
+    }
+
+    _statusProgress = 0;
+    _nameDefinitions = nullptr;
 
 #if USE_FIXCOST
     // FixCost Memory Pool
-    FixPool* pool = _data->fixPool();
+    _pool = _data->fixPool();
 #endif
 
     _part = nullptr;
     partsAdded = 0;
     prepareNewPart();
 
-    FixString line;
-    char c;
-
     // current position
     nextLineType  = SelfCost;
     // default if there is no "positions:" line
     hasLineInfo = true;
     hasAddrInfo = false;
 
-    while (file.nextLine(line)) {
+    if (!parseLines(file)) return 0;
+
+    if (mapping) {
+        _part->invalidate();
+        _part->totals()->clear();
+        _part->totals()->addCost(_part);
+        data->addPart(_part);
+        partsAdded++;
+    }
+    else {
+        error(QStringLiteral("No data found. Skipping file"));
+        delete _part;
+    }
+
+    device->close();
+
+    // canceled after last function: parts get discarded with the trace
+    if (_data->isLoadCanceled()) return 0;
+
+    loadFinished();
+    writeCache(partsAdded);
+
+    return partsAdded;
+}
+
+// write cache file for fast reopening, with the parts just added
+void CachegrindLoader::writeCache(int parts)
+{
+    // never write parts of a canceled load
+    if ((parts <= 0) || _data->isLoadCanceled()) return;
+
+    TracePartList l = _data->parts();
+    CacheLoader::writeCache(_data, l.mid(l.count() - parts), _filename,
+                            _eventDefinitions);
+}
+
+/**
+ * Parse lines of <file> until its end
+ *
+ * Returns false on fatal error. Then, the current part is deleted.
+ * Also returns false on cancellation: then, the current part may be
+ * referenced by cost items already, and is added to the trace, which
+ * is to be discarded by the caller.
+ */
+bool CachegrindLoader::parseLines(FixFile& file)
+{
+    FixString line;
+    char c;
+
+#if USE_FIXCOST
+    FixPool* pool = _pool;
+    bool lazyDetail = false;
+    PositionSpec lastPos;
+#endif
+    uint64 lineStart;
+
+    for (lineStart = file.current(); file.nextLine(line);
+         lineStart = file.current()) {
 
         _lineNo++;
 
@@ -768,6 +890,11 @@ int CachegrindLoader::loadInternal(TraceData* data,
 
             if (c == '#') continue;
 
+#if USE_FIXCOST
+            lazyDetail = _lazyDetail && hasAddrInfo;
+            if (lazyDetail) lastPos = currentPos;
+#endif
+
             // parse position(s)
             if (!parsePosition(line, currentPos)) {
                 error(QStringLiteral("Invalid position specification '%1'").arg(line));
@@ -778,6 +905,12 @@ int CachegrindLoader::loadInternal(TraceData* data,
         }
         else { // if (c > '9')
 
+#if USE_FIXCOST
+            // calls and jumps do not change function or source file
+            if ((c != 'c') && (c != 'j') && (c != 'r'))
+                _instrRange = nullptr;
+#endif
+
             line.stripFirst(c);
 
             /* in order of probability */
@@ -809,17 +942,23 @@ int CachegrindLoader::loadInternal(TraceData* data,
                         currentFile = currentFunctionFile;
                     setFunction(line);
 
-                    // on a new function, update status
+                    // on a new function, check for cancellation
+                    if (_data->isLoadCanceled()) {
+                        _data->addPart(_part);
+                        return false;
+                    }
+
+                    // ... and update status
                     int progress = (int)(100.0 * file.current() / file.len() +.5);
-                    if (progress != statusProgress) {
-                        statusProgress = progress;
+                    if (progress != _statusProgress) {
+                        _statusProgress = progress;
 
                         /* When this signal is connected, it most probably
          * should lead to GUI update. Thus, when multiple
          * "long operations" (like file loading) are in progress,
          * this can temporarily switch to another operation.
          */
-                        loadProgress(statusProgress);
+                        loadProgress(_statusProgress);
                     }
 
                     continue;
@@ -851,7 +990,8 @@ int CachegrindLoader::loadInternal(TraceData* data,
                 // calls=
                 if (line.stripPrefix("alls=")) {
                     // ignore long lines...
-                    line.stripUInt64(currentCallCount);
+                    currentCallCount = 0;
+                    line.stripUInt64s(&currentCallCount.v, 1);
                     nextLineType = CallCost;
                     continue;
                 }
@@ -882,9 +1022,9 @@ int CachegrindLoader::loadInternal(TraceData* data,
                 if (line.stripPrefix("cnd=")) {
                     bool valid;
 
-                    valid = line.stripUInt64(jumpsFollowed) &&
+                    valid = (line.stripUInt64s(&jumpsFollowed.v, 1) == 1) &&
                             line.stripPrefix("/") &&
-                            line.stripUInt64(jumpsExecuted) &&
+                            (line.stripUInt64s(&jumpsExecuted.v, 1) == 1) &&
                             parsePosition(line, targetPos);
 
                     if (!valid) {
@@ -898,7 +1038,7 @@ int CachegrindLoader::loadInternal(TraceData* data,
                 if (line.stripPrefix("ump=")) {
                     bool valid;
 
-                    valid = line.stripUInt64(jumpsExecuted) &&
+                    valid = (line.stripUInt64s(&jumpsExecuted.v, 1) == 1) &&
                             parsePosition(line, targetPos);
 
                     if (!valid) {
@@ -1022,6 +1162,8 @@ int CachegrindLoader::loadInternal(TraceData* data,
                     // add to known cost types
                     if (line.isEmpty()) line = e;
                     EventType::add(new EventType(e,line,f));
+                    if (!f.isEmpty())
+                        _eventDefinitions.append({ e, line, f });
                     continue;
                 }
                 break;
@@ -1082,7 +1224,8 @@ int CachegrindLoader::loadInternal(TraceData* data,
                 if (line.stripPrefix("calls=")) {
                     // handle like normal calls: we need the sum of call count
                     // recursive cost is discarded in cycle detection
-                    line.stripUInt64(currentCallCount);
+                    currentCallCount = 0;
+                    line.stripUInt64s(&currentCallCount.v, 1);
                     nextLineType = CallCost;
 
                     warning(QStringLiteral("Old file format using deprecated 'rcalls'"));
@@ -1115,6 +1258,24 @@ int CachegrindLoader::loadInternal(TraceData* data,
                                                                 true);
         }
 
+#if USE_FIXCOST
+        if (lazyDetail) {
+            if (!_instrRange ||
+                (_instrRangeFunction != currentPartFunction) ||
+                (_instrRange->functionSource() != currentFunctionSource)) {
+                _instrRange = new (pool) FixInstrRange(_part, pool,
+                                                       currentFunctionSource,
+                                                       currentPartFunction,
+                                                       lineStart, lastPos,
+                                                       nextLineType == SelfCost,
+                                                       hasLineInfo);
+                _instrRangeFunction = currentPartFunction;
+                _part->setDetailFileSize(_detailFileSize);
+            }
+            _instrRange->setEnd(file.current());
+        }
+#endif
+
 #if !USE_FIXCOST
         if (hasAddrInfo) {
             if (!currentInstr ||
@@ -1165,11 +1326,32 @@ int CachegrindLoader::loadInternal(TraceData* data,
         if (nextLineType == SelfCost) {
 
 #if USE_FIXCOST
-            new (pool) FixCost(_part, pool,
-                               currentFunctionSource,
-                               currentPos,
-                               currentPartFunction,
-                               line);
+            if (lazyDetail) {
+                // self cost per source line, see FixInstrRange
+                if (!_lineCost ||
+                    (_lineCostFunction != currentPartFunction) ||
+                    (_lineCost->functionSource() != currentFunctionSource) ||
+                    (_lineCost->fromLine() != currentPos.fromLine) ||
+                    (_lineCost->toLine() != currentPos.toLine)) {
+                    PositionSpec linePos(currentPos.fromLine, currentPos.toLine,
+                                         0, 0);
+                    _zeroCost.fill(0, mapping->count());
+                    _lineCost = new (pool) FixCost(_part, pool,
+                                                   currentFunctionSource,
+                                                   linePos,
+                                                   currentPartFunction,
+                                                   _zeroCost.constData(),
+                                                   _zeroCost.count());
+                    _lineCostFunction = currentPartFunction;
+                }
+                _lineCost->addCost(line);
+            }
+            else
+                new (pool) FixCost(_part, pool,
+                                   currentFunctionSource,
+                                   currentPos,
+                                   currentPartFunction,
+                                   line);
 #else
             if (hasAddrInfo) {
                 TracePartInstr* partInstr;
@@ -1348,22 +1530,479 @@ int CachegrindLoader::loadInternal(TraceData* data,
         }
     }
 
-    loadFinished();
+    return true;
+}
 
-    if (mapping) {
-        _part->invalidate();
-        _part->totals()->clear();
-        _part->totals()->addCost(_part);
-        data->addPart(_part);
-        partsAdded++;
+
+
+/*
+ * Support for parsing in chunks
+ */
+
+/* Resolve name specification <spec> into <name> for the pre-pass,
+ * recording definitions of compressed names in <table>. <defined> is
+ * set to the index of a definition, otherwise to -1.
+ * Returns false for invalid or undefined compressed names.
+ */
+static bool resolveName(FixString spec, QVector<QString>& table,
+                        QString& name, int& defined)
+{
+    defined = -1;
+    int index = stripCompressionId(spec);
+    if (index == -1) {
+        name = spec;
+        return true;
     }
-    else {
+    if (index < 0) return false;
+
+    if (!spec.isEmpty()) {
+        if (table.size() <= index) table.resize(index * 2 + 1);
+        table[index] = spec;
+        defined = index;
+    }
+    else if ((table.size() <= index) || table.at(index).isNull())
+        return false;
+
+    name = table.at(index);
+    return true;
+}
+
+// true if the position of cost line <line> does not depend on previous lines
+static bool isAbsolutePosition(FixString line, bool hasAddrInfo, bool hasLineInfo)
+{
+    char c;
+
+    if (hasAddrInfo) {
+        if (!line.first(c) || (c < '0') || (c > '9')) return false;
+        if (!hasLineInfo) return true;
+
+        // skip address (range)
+        while(line.first(c) && (c != ' ') && (c != '\t'))
+            line.stripFirst(c);
+        line.stripSpaces();
+    }
+
+    if (hasLineInfo) {
+        if (!line.first(c) || (c < '0') || (c > '9')) return false;
+    }
+
+    return true;
+}
+
+/**
+ * Pre-pass over <file>, looking at name specification lines only.
+ *
+ * Splits the file into at most <count> chunks of about same size.
+ * Chunks start at "fn=" lines with the first cost line afterwards
+ * having an absolute position and no jump in between, as parsing
+ * relative positions and jumps needs the state of previous lines.
+ * Sets <headerEnd> to the offset of the first line with data.
+ *
+ * Returns false if the file cannot be split: this is the case with
+ * multiple parts, as header lines after data start a new part.
+ * Also returns false if loading gets canceled.
+ */
+bool CachegrindLoader::scanChunks(FixFile& file, int count,
+                                  uint64& headerEnd,
+                                  QVector<Chunk>& chunks,
+                                  NameDefinitions& defs)
+{
+    FixString line;
+    char c;
+    QString name;
+    int lineNo = 0, defined;
+    bool inData = false, lineInfo = true, addrInfo = false;
+    bool pendingCall = false, pendingJump = false;
+
+    // names currently set, as the parser would have them
+    QString object, fileName, functionFile;
+    QString calledObject, calledFile, jumpFile;
+    bool hasObject = false, hasFile = false, hasFunctionFile = false;
+    bool hasCalledObject = false, hasCalledFile = false, hasJumpFile = false;
+
+    // start of next chunk, to be validated with the next cost line
+    Chunk chunk;
+    bool hasCandidate = false;
+    uint64 next = file.len() / count;
+
+    chunk.start = 0;
+    chunk.lineNo = 0;
+    chunk.hasObject = false;
+    chunk.hasFunctionFile = false;
+    chunks.clear();
+    chunks.append(chunk);
+    headerEnd = 0;
+
+    while(1) {
+        uint64 pos = file.current();
+        if (!file.nextLine(line)) break;
+        lineNo++;
+
+        if (!line.first(c) || (c == '#')) continue;
+
+        if (c <= '9') {
+            // cost line
+            if (!inData) {
+                inData = true;
+                headerEnd = pos;
+            }
+            if (hasCandidate) {
+                if (isAbsolutePosition(line, addrInfo, lineInfo)) {
+                    chunks.last().end = chunk.start;
+                    chunks.append(chunk);
+                    next = file.len() * chunks.count() / count;
+                }
+                hasCandidate = false;
+            }
+            if (pendingCall) {
+                hasCalledObject = false;
+                hasCalledFile = false;
+                pendingCall = false;
+            }
+            if (pendingJump) {
+                hasJumpFile = false;
+                pendingJump = false;
+            }
+            continue;
+        }
+
+        line.stripFirst(c);
+
+        // header lines are allowed after data only if not starting a new part
+        bool isHeader = false, isHeaderAnywhere = false;
+
+        switch(c) {
+
+        case 'f':
+            if (line.stripPrefix("l=")) {
+                hasFile = resolveName(line, defs.files, fileName, defined);
+                hasFunctionFile = hasFile;
+                functionFile = fileName;
+            }
+            else if (line.stripPrefix("i=") || line.stripPrefix("e=")) {
+                hasFile = resolveName(line, defs.files, fileName, defined);
+            }
+            else if (line.stripPrefix("n=")) {
+                if (_data->isLoadCanceled()) {
+                    file.rewind();
+                    return false;
+                }
+
+                if (!hasCandidate && (pos >= next) &&
+                    (chunks.count() < count)) {
+                    chunk.start = pos;
+                    chunk.lineNo = lineNo - 1;
+                    chunk.hasObject = hasObject;
+                    chunk.object = object;
+                    chunk.hasFunctionFile = hasFunctionFile;
+                    chunk.functionFile = functionFile;
+                    hasCandidate = true;
+                }
+
+                hasFile = hasFunctionFile;
+                fileName = functionFile;
+                resolveName(line, defs.functions, name, defined);
+                if (defined >= 0) {
+                    if (defs.functionFiles.size() <= defined) {
+                        defs.functionFiles.resize(defs.functions.size());
+                        defs.functionObjects.resize(defs.functions.size());
+                    }
+                    defs.functionFiles[defined] = hasFile ? fileName : QString();
+                    defs.functionObjects[defined] = hasObject ? object : QString();
+                }
+            }
+            break;
+
+        case 'c':
+            if (line.stripPrefix("ob=")) {
+                hasCalledObject = resolveName(line, defs.objects, calledObject, defined);
+            }
+            else if (line.stripPrefix("fl=") || line.stripPrefix("fi=")) {
+                hasCalledFile = resolveName(line, defs.files, calledFile, defined);
+            }
+            else if (line.stripPrefix("fn=")) {
+                // if called object/file not set, the current ones are used
+                if (!hasCalledObject) {
+                    hasCalledObject = hasObject;
+                    calledObject = object;
+                }
+                if (!hasCalledFile) {
+                    hasCalledFile = hasFile;
+                    calledFile = fileName;
+                }
+                resolveName(line, defs.functions, name, defined);
+                if (defined >= 0) {
+                    if (defs.functionFiles.size() <= defined) {
+                        defs.functionFiles.resize(defs.functions.size());
+                        defs.functionObjects.resize(defs.functions.size());
+                    }
+                    defs.functionFiles[defined] = hasCalledFile ? calledFile : QString();
+                    defs.functionObjects[defined] = hasCalledObject ? calledObject : QString();
+                }
+            }
+            else if (line.stripPrefix("alls=")) {
+                pendingCall = true;
+            }
+            else {
+                // cmd:, creator:
+                isHeader = true;
+                isHeaderAnywhere = true;
+            }
+            break;
+
+        case 'j':
+            // jump targets need the state of previous lines
+            hasCandidate = false;
+
+            if (line.stripPrefix("fi=")) {
+                hasJumpFile = resolveName(line, defs.files, jumpFile, defined);
+            }
+            else if (line.stripPrefix("fn=")) {
+                if (!hasJumpFile) {
+                    hasJumpFile = hasFile;
+                    jumpFile = fileName;
+                }
+                resolveName(line, defs.functions, name, defined);
+                if (defined >= 0) {
+                    if (defs.functionFiles.size() <= defined) {
+                        defs.functionFiles.resize(defs.functions.size());
+                        defs.functionObjects.resize(defs.functions.size());
+                    }
+                    defs.functionFiles[defined] = hasJumpFile ? jumpFile : QString();
+                    defs.functionObjects[defined] = hasObject ? object : QString();
+                }
+            }
+            else {
+                // jump=, jcnd=
+                pendingJump = true;
+            }
+            break;
+
+        case 'o':
+            if (line.stripPrefix("b=")) {
+                hasObject = resolveName(line, defs.objects, object, defined);
+            }
+            break;
+
+        case 'r':
+            // rcalls= (deprecated)
+            if (line.stripPrefix("calls=")) pendingCall = true;
+            break;
+
+        case 't':
+            isHeader = true;
+            isHeaderAnywhere = line.stripPrefix("otals:");
+            break;
+
+        case 's':
+            // summary is overwritten by totals calculated when loading
+            isHeader = true;
+            isHeaderAnywhere = line.stripPrefix("ummary:");
+            break;
+
+        case 'p':
+            if (line.stripPrefix("ositions:")) {
+                QString positions(line);
+                lineInfo = positions.contains(QLatin1String("line"));
+                addrInfo = positions.contains(QLatin1String("instr"));
+            }
+            isHeader = true;
+            break;
+
+        default:
+            isHeader = true;
+            break;
+        }
+
+        if (isHeader) {
+            if (inData && !isHeaderAnywhere) {
+                file.rewind();
+                return false;
+            }
+            continue;
+        }
+
+        if (!inData) {
+            inData = true;
+            headerEnd = pos;
+        }
+    }
+
+    chunks.last().end = file.len();
+    file.rewind();
+
+    return (chunks.count() > 1);
+}
+
+/**
+ * Load <file> in chunks by <count> threads into staging traces,
+ * merged in order into one new part afterwards.
+ *
+ * Returns the number of parts added, or -1 if the file cannot
+ * be split into chunks.
+ */
+int CachegrindLoader::loadChunked(FixFile& file, int count)
+{
+    uint64 headerEnd;
+    QVector<Chunk> chunks;
+    NameDefinitions defs;
+
+    if (!scanChunks(file, count, headerEnd, chunks, defs))
+        return _data->isLoadCanceled() ? 0 : -1;
+
+    if (0) qDebug("Loading '%s' in %d chunks",
+                  qPrintable(_filename), (int) chunks.count());
+
+    struct ChunkLoad {
+        Chunk chunk;
+        BufferedLogger logger;
+        TraceData* data;
+        QList<CacheLoader::EventDefinition> eventDefinitions;
+        QSemaphore done;
+        bool merged;
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(count);
+
+    QList<ChunkLoad*> loads;
+    foreach(const Chunk& chunk, chunks) {
+        ChunkLoad* load = new ChunkLoad;
+        load->chunk = chunk;
+        load->data = nullptr;
+        load->merged = false;
+        loads.append(load);
+
+        const QString filename = _filename;
+        const bool lazyDetail = _lazyDetail;
+        const QAtomicInt* cancel = _data->loadCancel();
+        pool.start([load, &file, filename, headerEnd, &defs, lazyDetail,
+                    cancel]() {
+            CachegrindLoader l;
+            l.setLogger(&load->logger);
+            l._lazyDetail = lazyDetail;
+            l._detailFileSize = file.len();
+            load->data = new TraceData(&load->logger);
+            load->data->setStaging(true);
+            load->data->setLoadCancel(cancel);
+            l.loadChunk(load->data, file, filename, headerEnd, load->chunk, &defs);
+            load->eventDefinitions = l._eventDefinitions;
+            load->done.release();
+        });
+    }
+
+    // overall progress from the file positions reached by the chunks
+    auto chunkProgress = [&loads, &file]() {
+        uint64 loaded = 0;
+        foreach(ChunkLoad* load, loads) {
+            uint64 pos = load->chunk.end;
+            if (!load->merged && load->done.available() == 0)
+                pos = file.len() / 100 * load->logger.progress();
+            if (pos > load->chunk.end) pos = load->chunk.end;
+            if (pos > load->chunk.start) loaded += pos - load->chunk.start;
+        }
+        return (int)(100.0 * loaded / file.len());
+    };
+
+    // merge in order of chunks, as soon as available
+    TracePart* part = nullptr;
+    foreach(ChunkLoad* load, loads) {
+        // report progress of chunks still loading
+        while (!load->done.tryAcquire(1, 100))
+            loadProgress(chunkProgress());
+        load->logger.forward(_logger);
+        // all chunks parse the header with its event declarations
+        if (load == loads.first())
+            _eventDefinitions = load->eventDefinitions;
+        if (!_data->isLoadCanceled()) {
+            if (part)
+                _data->mergeStaged(load->data, part);
+            else if (_data->mergeStaged(load->data) > 0)
+                part = _data->parts().last();
+        }
+        delete load->data;
+        load->merged = true;
+    }
+    loadProgress(100);
+    pool.waitForDone();
+    qDeleteAll(loads);
+
+    // parts merged before are discarded with the canceled trace
+    if (_data->isLoadCanceled()) return 0;
+
+    if (!part) {
         error(QStringLiteral("No data found. Skipping file"));
-        delete _part;
+        return 0;
     }
 
-    device->close();
+    // totals of first chunk only up to now
+    part->invalidate();
+    part->totals()->clear();
+    part->totals()->addCost(part);
 
-    return partsAdded;
+    return 1;
 }
 
+/**
+ * Load one chunk of <file> into staging trace <data>.
+ *
+ * For chunks not at file start, the header is parsed first to
+ * get event types and positions, and the names set at chunk start
+ * are restored. Notifications about the header are given by the
+ * first chunk only.
+ */
+void CachegrindLoader::loadChunk(TraceData* data, FixFile& file,
+                                 const QString& filename,
+                                 uint64 headerEnd, const Chunk& chunk,
+                                 const NameDefinitions* defs)
+{
+    _data = data;
+    _filename = filename;
+    _lineNo = 0;
+    _statusProgress = 0;
+    _nameDefinitions = nullptr;
+    _pool = _data->fixPool();
+
+    _part = nullptr;
+    partsAdded = 0;
+    prepareNewPart();
+
+    nextLineType  = SelfCost;
+    hasLineInfo = true;
+    hasAddrInfo = false;
+
+    if (chunk.start > 0) {
+        Logger* logger = _logger;
+        _logger = nullptr;
+        FixFile header(file, 0, headerEnd);
+        bool ok = parseLines(header);
+        _logger = logger;
+        if (!ok) return;
+
+        _nameDefinitions = defs;
+        _lineNo = chunk.lineNo;
+
+        if (chunk.hasObject) {
+            currentObject = _data->object(checkUnknown(chunk.object));
+            currentPartObject = currentObject->partObject(_part);
+        }
+        if (chunk.hasFunctionFile) {
+            currentFunctionFile = _data->file(checkUnknown(chunk.functionFile));
+            currentFile = currentFunctionFile;
+            currentPartFile = currentFile->partFile(_part);
+        }
+    }
+
+    FixFile view(file, chunk.start, chunk.end);
+    if (!parseLines(view)) return;
+
+    if (!mapping) {
+        delete _part;
+        return;
+    }
+
+    _part->invalidate();
+    _part->totals()->clear();
+    _part->totals()->addCost(_part);
+    _data->addPart(_part);
+}
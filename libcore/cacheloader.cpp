@@ -0,0 +1,672 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind developers
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Loader/writer of binary cache files
+ */
+
+#include "cacheloader.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QVector>
+
+#include "addr.h"
+#include "fixcost.h"
+#include "globalconfig.h"
+#include "utils.h"
+
+#define TRACE_CACHELOADER 0
+
+// cache files are only written for profile data files at least this big
+#define CACHE_MINSIZE (16*1024*1024)
+
+// "KCGC", and the version of the format
+#define CACHE_MAGIC   0x4b434743
+#define CACHE_VERSION 2
+
+// size of blocks at start and end of a profile data file used for its hash
+#define CACHE_HASHBLOCK (1024*1024)
+
+
+/*
+ * Hash of a profile data file, to detect modifications.
+ * Hashing a multi-GB file completely would take longer than loading
+ * from the cache, so only blocks at start and end are used. Together
+ * with size and modification time, this is good enough.
+ */
+static quint64 sourceHash(const QString& file, quint64 size)
+{
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) return 0;
+
+    // FNV-1a
+    quint64 h = 14695981039346656037ULL;
+    auto add = [&h](const QByteArray& data) {
+        for (char c : data) {
+            h ^= (uchar) c;
+            h *= 1099511628211ULL;
+        }
+    };
+
+    add(f.read(CACHE_HASHBLOCK));
+    if (size > 2*CACHE_HASHBLOCK) {
+        f.seek(size - CACHE_HASHBLOCK);
+        add(f.read(CACHE_HASHBLOCK));
+    }
+    h ^= size;
+
+    return h;
+}
+
+// header of a cache file, checked against the profile data file
+struct CacheHeader
+{
+    quint32 magic, version;
+    quint8 littleEndian, costSize;
+    quint64 size, hash;
+    qint64 modified;
+
+    void setFromSource(const QString& file)
+    {
+        QFileInfo info(file);
+        magic = CACHE_MAGIC;
+        version = CACHE_VERSION;
+        littleEndian = (QSysInfo::ByteOrder == QSysInfo::LittleEndian);
+        costSize = sizeof(SubCost);
+        size = info.size();
+        modified = info.lastModified().toMSecsSinceEpoch();
+        hash = sourceHash(file, size);
+    }
+
+    bool operator==(const CacheHeader& h) const
+    {
+        return (magic == h.magic) && (version == h.version) &&
+               (littleEndian == h.littleEndian) && (costSize == h.costSize) &&
+               (size == h.size) && (modified == h.modified) &&
+               (hash == h.hash);
+    }
+};
+
+static QDataStream& operator<<(QDataStream& s, const CacheHeader& h)
+{
+    return s << h.magic << h.version << h.littleEndian << h.costSize
+             << h.size << h.modified << h.hash;
+}
+
+static QDataStream& operator>>(QDataStream& s, CacheHeader& h)
+{
+    return s >> h.magic >> h.version >> h.littleEndian >> h.costSize
+             >> h.size >> h.modified >> h.hash;
+}
+
+// cost arrays are stored raw, aligned to their size
+static void writeCosts(QDataStream& s, const SubCost* cost, int count)
+{
+    static const char zeros[sizeof(SubCost)] = { 0 };
+    int pad = (sizeof(SubCost) - s.device()->pos() % sizeof(SubCost)) % sizeof(SubCost);
+    s.writeRawData(zeros, pad);
+    s.writeRawData((const char*) cost, count * sizeof(SubCost));
+}
+
+static const SubCost* readCosts(QDataStream& s, const char* base, int count)
+{
+    if ((count < 0) || (count > ProfileCostArray::MaxRealIndex)) return nullptr;
+
+    int pad = (sizeof(SubCost) - s.device()->pos() % sizeof(SubCost)) % sizeof(SubCost);
+    s.skipRawData(pad);
+    const SubCost* cost = (const SubCost*) (base + s.device()->pos());
+    if (s.skipRawData(count * sizeof(SubCost)) != (int)(count * sizeof(SubCost)))
+        return nullptr;
+    return cost;
+}
+
+
+/**********************************************************
+ * CacheLoader
+ */
+
+CacheLoader::CacheLoader()
+    : Loader(QStringLiteral("Cache"),
+             QObject::tr( "Import filter for binary cache files of profile data files") )
+{
+}
+
+QString CacheLoader::cacheFileName(const QString& file)
+{
+    // hidden, so not matched when looking for files with a given prefix
+    QFileInfo info(file);
+    return info.dir().filePath(QStringLiteral(".%1.kcgcache").arg(info.fileName()));
+}
+
+bool CacheLoader::canLoad(QIODevice* file)
+{
+    if (!GlobalConfig::useCacheFiles()) return false;
+
+    QFile* f = qobject_cast<QFile*>(file);
+    if (!f || (f->size() < CACHE_MINSIZE)) return false;
+
+    QFile cache(cacheFileName(f->fileName()));
+    if (!cache.open(QIODevice::ReadOnly)) return false;
+
+    CacheHeader h, expected;
+    QDataStream s(&cache);
+    s.setVersion(QDataStream::Qt_5_15);
+    s >> h;
+    if (s.status() != QDataStream::Ok) return false;
+    expected.setFromSource(f->fileName());
+
+    return (h == expected);
+}
+
+Loader* CacheLoader::clone() const
+{
+    return new CacheLoader();
+}
+
+Loader* createCacheLoader()
+{
+    return new CacheLoader();
+}
+
+/*
+ * Read contents of a cache file following the header from <s>, with
+ * cost arrays referenced in <base>, adding parts to <data>.
+ * Without <data>, contents only are checked, so that a corrupt cache
+ * file is detected before anything gets added to a trace.
+ *
+ * Returns the number of parts, or -1 if the cache file is corrupt.
+ * On cancellation, the part read is added incomplete, to be discarded
+ * with the canceled trace.
+ */
+static int readCache(QDataStream& s, const char* base,
+                     TraceData* data, const QString& filename)
+{
+    QString command;
+    qint32 arch;
+    s >> command >> arch;
+    if (data && !command.isEmpty()) data->setCommand(command);
+    if (data && (arch != TraceData::ArchUnknown))
+        data->setArchitecture((TraceData::Arch) arch);
+
+    // event types: keep long names
+    quint32 count, i, j, k;
+    QString name, longName;
+    s >> count;
+    for (i = 0; (i < count) && (s.status() == QDataStream::Ok); i++) {
+        s >> name >> longName;
+        if (data && !longName.isEmpty() && (longName != name))
+            EventType::add(new EventType(name, longName));
+    }
+
+    // derived event types, added as when parsing the profile data file
+    QString formula;
+    s >> count;
+    for (i = 0; (i < count) && (s.status() == QDataStream::Ok); i++) {
+        s >> name >> longName >> formula;
+        if (data)
+            EventType::add(new EventType(name, longName, formula));
+    }
+
+    // name tables; when checking, only the sizes are of interest
+    QVector<TraceObject*> objects;
+    s >> count;
+    for (i = 0; (i < count) && (s.status() == QDataStream::Ok); i++) {
+        s >> name;
+        objects.append(data ? data->object(name) : nullptr);
+    }
+
+    QVector<TraceFile*> files;
+    s >> count;
+    for (i = 0; (i < count) && (s.status() == QDataStream::Ok); i++) {
+        s >> name;
+        files.append(data ? data->file(name) : nullptr);
+    }
+
+    auto valid = [](qint32 index, int size) { return (index >= 0) && (index < size); };
+
+    QVector<TraceFunction*> functions;
+    qint32 fileIndex, objectIndex, functionIndex;
+    s >> count;
+    for (i = 0; (i < count) && (s.status() == QDataStream::Ok); i++) {
+        s >> name >> fileIndex >> objectIndex;
+        if (!valid(fileIndex, files.size()) ||
+            !valid(objectIndex, objects.size())) return -1;
+        functions.append(data ? data->function(name, files[fileIndex],
+                                               objects[objectIndex]) : nullptr);
+    }
+
+    QVector<TraceFunctionSource*> sources;
+    s >> count;
+    for (i = 0; (i < count) && (s.status() == QDataStream::Ok); i++) {
+        s >> functionIndex >> fileIndex;
+        if (!valid(functionIndex, functions.size()) ||
+            !valid(fileIndex, files.size())) return -1;
+        sources.append(data ? functions[functionIndex]->sourceFile(files[fileIndex], true)
+                            : nullptr);
+    }
+
+    auto source = [&sources](qint32 i) -> TraceFunctionSource* {
+        return ((i >= 0) && (i < sources.size())) ? sources[i] : nullptr;
+    };
+    auto function = [&functions](qint32 i) -> TraceFunction* {
+        return ((i >= 0) && (i < functions.size())) ? functions[i] : nullptr;
+    };
+
+    FixPool* pool = data ? data->fixPool() : nullptr;
+    int partsAdded = 0;
+
+    quint32 partCount;
+    s >> partCount;
+    for (quint32 p = 0; (p < partCount) && (s.status() == QDataStream::Ok); p++) {
+        QString description, trigger, timeframe, version;
+        qint32 number, tid, pid;
+        QStringList events;
+        s >> description >> trigger >> timeframe >> version
+          >> number >> tid >> pid >> events;
+
+        // named after the profile data file, as with the Callgrind loader
+        TracePart* part = nullptr;
+        if (data) {
+            part = new TracePart(data);
+            part->setName(filename);
+            part->setDescription(description);
+            part->setTrigger(trigger);
+            part->setTimeframe(timeframe);
+            part->setVersion(version);
+            part->setPartNumber(number);
+            part->setThreadID(tid);
+            part->setProcessID(pid);
+            part->setEventMapping(data->eventTypes()->createMapping(events.join(' ')));
+        }
+
+        // part functions, created first with partFile/partObject as written
+        QVector<TracePartFunction*> partFunctions;
+        s >> count;
+        for (i = 0; (i < count) && (s.status() == QDataStream::Ok); i++) {
+            s >> functionIndex >> fileIndex >> objectIndex;
+            if (!valid(functionIndex, functions.size()) ||
+                !valid(fileIndex, files.size()) ||
+                (objectIndex >= objects.size())) return -1;
+            if (!data) {
+                partFunctions.append(nullptr);
+                continue;
+            }
+            TraceFunction* f = function(functionIndex);
+            TracePartObject* partObject = (objectIndex < 0) ? nullptr :
+                                              objects[objectIndex]->partObject(part);
+            partFunctions.append(f->partFunction(part,
+                                                 files[fileIndex]->partFile(part),
+                                                 partObject));
+        }
+        // fix costs of part functions
+        for (k = 0; (k < count) && (s.status() == QDataStream::Ok); k++) {
+            if (data && data->isLoadCanceled()) {
+                data->addPart(part);
+                return partsAdded;
+            }
+
+            TracePartFunction* pf = partFunctions[k];
+            quint32 n;
+            qint32 sourceIndex, costCount;
+            PositionSpec pos;
+            quint64 fromAddr, toAddr;
+
+            s >> n;
+            for (j = 0; (j < n) && (s.status() == QDataStream::Ok); j++) {
+                s >> sourceIndex >> pos.fromLine >> pos.toLine
+                  >> fromAddr >> toAddr >> costCount;
+                pos.fromAddr = Addr(fromAddr);
+                pos.toAddr = Addr(toAddr);
+                const SubCost* cost = readCosts(s, base, costCount);
+                if (!cost || !valid(sourceIndex, sources.size())) return -1;
+                if (data)
+                    new (pool) FixCost(part, pool, source(sourceIndex), pos,
+                                       pf, cost, costCount);
+            }
+
+            s >> n;
+            for (j = 0; (j < n) && (s.status() == QDataStream::Ok); j++) {
+                quint32 line, targetLine;
+                quint64 addr, targetAddr, executed, followed;
+                qint32 targetFunction, targetSource;
+                quint8 isCondJump;
+                s >> line >> addr >> sourceIndex
+                  >> targetLine >> targetAddr >> targetFunction >> targetSource
+                  >> isCondJump >> executed >> followed;
+                if (!valid(sourceIndex, sources.size()) ||
+                    !valid(targetFunction, functions.size())) return -1;
+                if (data)
+                    new (pool) FixJump(part, pool,
+                                       line, Addr(addr), pf, source(sourceIndex),
+                                       targetLine, Addr(targetAddr),
+                                       function(targetFunction),
+                                       source(targetSource),
+                                       isCondJump != 0,
+                                       executed, followed);
+            }
+
+            s >> n;
+            for (j = 0; (j < n) && (s.status() == QDataStream::Ok); j++) {
+                qint32 calledIndex;
+                quint32 m;
+                s >> calledIndex >> m;
+                if (!valid(calledIndex, partFunctions.size())) return -1;
+                TracePartCall* pc = nullptr;
+                if (data) {
+                    TracePartFunction* pfCalled = partFunctions[calledIndex];
+                    TraceCall* call = pf->function()->calling(pfCalled->function());
+                    pc = call->partCall(part, pf, pfCalled);
+                }
+
+                for (quint32 l = 0; (l < m) && (s.status() == QDataStream::Ok); l++) {
+                    quint32 line;
+                    quint64 addr, callCount;
+                    s >> sourceIndex >> line >> addr >> callCount >> costCount;
+                    const SubCost* cost = readCosts(s, base, costCount);
+                    if (!cost || !valid(sourceIndex, sources.size())) return -1;
+                    if (!data) continue;
+                    FixCallCost* fcc;
+                    fcc = new (pool) FixCallCost(part, pool, source(sourceIndex),
+                                                 line, Addr(addr), pc,
+                                                 callCount, cost, costCount);
+                    fcc->setMax(data->callMax());
+                    data->updateMaxCallCount(fcc->callCount());
+                }
+            }
+        }
+        if (s.status() != QDataStream::Ok) return -1;
+
+        if (data) {
+            part->invalidate();
+            part->totals()->clear();
+            part->totals()->addCost(part);
+            data->addPart(part);
+        }
+        partsAdded++;
+    }
+
+    return (s.status() == QDataStream::Ok) ? partsAdded : -1;
+}
+
+int CacheLoader::load(TraceData* data,
+                      QIODevice* device, const QString& filename)
+{
+    QFile* f = qobject_cast<QFile*>(device);
+    if (!data || !f) return 0;
+
+    loadStart(filename);
+
+    QFile cache(cacheFileName(f->fileName()));
+    uchar* base = nullptr;
+    if (cache.open(QIODevice::ReadOnly))
+        base = cache.map(0, cache.size());
+    if (!base) {
+        loadFinished(QStringLiteral("Cannot map cache file"));
+        return 0;
+    }
+
+    QByteArray raw = QByteArray::fromRawData((const char*) base, cache.size());
+    QBuffer buffer(&raw);
+    buffer.open(QIODevice::ReadOnly);
+    QDataStream s(&buffer);
+    s.setVersion(QDataStream::Qt_5_15);
+
+    CacheHeader h;
+    s >> h;
+    qint64 contents = buffer.pos();
+
+    // check everything first: a corrupt cache must not add anything
+    int partsAdded = readCache(s, raw.constData(), nullptr, filename);
+    if ((partsAdded >= 0) && !data->isLoadCanceled()) {
+        buffer.seek(contents);
+        s.resetStatus();
+        partsAdded = readCache(s, raw.constData(), data, filename);
+    }
+
+    buffer.close();
+    cache.unmap(base);
+
+    if (data->isLoadCanceled()) return 0;
+
+    if (partsAdded < 0) {
+        // corrupt: do not use again, and parse the profile data file
+        cache.remove();
+        loadWarning(0, QStringLiteral("Corrupt cache file removed"));
+        Loader* l = Loader::loader(QStringLiteral("Callgrind"));
+        if (!l) {
+            loadFinished(QStringLiteral("Corrupt cache file"));
+            return 0;
+        }
+        l = l->clone();
+        l->setLogger(_logger);
+        partsAdded = l->load(data, device, filename);
+        delete l;
+        return partsAdded;
+    }
+
+#if TRACE_CACHELOADER
+    qDebug() << "CacheLoader: loaded" << partsAdded << "parts from"
+             << cache.fileName();
+#endif
+
+    loadFinished();
+
+    return partsAdded;
+}
+
+bool CacheLoader::writeCache(TraceData* data, const TracePartList& parts,
+                             const QString& file,
+                             const QList<EventDefinition>& events)
+{
+    if (!GlobalConfig::useCacheFiles() || parts.isEmpty()) return false;
+    if (QFileInfo(file).size() < CACHE_MINSIZE) return false;
+
+    // costs of instructions read on demand would get lost
+    foreach(TracePart* part, parts)
+        if (part->detailFileSize() > 0) return false;
+
+    // ids of items referenced by the parts, in order of first use
+    QHash<TraceObject*, qint32> objectIds;
+    QHash<TraceFile*, qint32> fileIds;
+    QHash<TraceFunction*, qint32> functionIds;
+    QHash<TraceFunctionSource*, qint32> sourceIds;
+    QList<TraceObject*> objects;
+    QList<TraceFile*> files;
+    QList<TraceFunction*> functions;
+    QList<TraceFunctionSource*> sources;
+
+    auto objectId = [&](TraceObject* o) -> qint32 {
+        if (!o) return -1;
+        if (!objectIds.contains(o)) {
+            objectIds.insert(o, objects.count());
+            objects.append(o);
+        }
+        return objectIds.value(o);
+    };
+    auto fileId = [&](TraceFile* f) -> qint32 {
+        if (!f) return -1;
+        if (!fileIds.contains(f)) {
+            fileIds.insert(f, files.count());
+            files.append(f);
+        }
+        return fileIds.value(f);
+    };
+    auto functionId = [&](TraceFunction* f) -> qint32 {
+        if (!f) return -1;
+        if (!functionIds.contains(f)) {
+            functionIds.insert(f, functions.count());
+            functions.append(f);
+            fileId(f->file());
+            objectId(f->object());
+        }
+        return functionIds.value(f);
+    };
+
+    // part functions of each part: every function has at most one
+    QHash<TracePart*, QList<TracePartFunction*> > partFunctions;
+    QHash<TracePartFunction*, qint32> partFunctionIds;
+    TraceFunctionMap::Iterator it;
+    for ( it = data->functionMap().begin();
+          it != data->functionMap().end(); ++it ) {
+        foreach(TraceInclusiveCost* item, (*it).deps()) {
+            TracePartFunction* pf = (TracePartFunction*) item;
+            TracePart* part = (TracePart*) pf->part();
+            if (!parts.contains(part)) continue;
+
+            QList<TracePartFunction*>& list = partFunctions[part];
+            partFunctionIds.insert(pf, list.count());
+            list.append(pf);
+
+            functionId(pf->function());
+            fileId(pf->partFile()->file());
+            if (pf->partObject()) objectId(pf->partObject()->object());
+
+            FixJump* fj = pf->firstFixJump();
+            for (; fj; fj = fj->nextJumpOfPartFunction())
+                functionId(fj->targetFunction());
+        }
+    }
+
+    // all source files of used functions, in order of creation
+    for (int i = 0; i < functions.count(); i++) {
+        foreach(TraceFunctionSource* fs, functions[i]->sourceFiles()) {
+            sourceIds.insert(fs, sources.count());
+            sources.append(fs);
+            fileId(fs->file());
+        }
+    }
+    auto sourceId = [&sourceIds](TraceFunctionSource* fs) -> qint32 {
+        return sourceIds.value(fs, -1);
+    };
+
+    QSaveFile cache(cacheFileName(file));
+    if (!cache.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream s(&cache);
+    s.setVersion(QDataStream::Qt_5_15);
+    CacheHeader h;
+    h.setFromSource(file);
+    s << h;
+
+    s << data->command() << (qint32) data->architecture();
+
+    EventTypeSet* set = data->eventTypes();
+    s << (quint32) set->realCount();
+    for (int i = 0; i < set->realCount(); i++)
+        s << set->realType(i)->name() << set->realType(i)->longName();
+
+    s << (quint32) events.count();
+    foreach(const EventDefinition& e, events)
+        s << e.name << e.longName << e.formula;
+
+    s << (quint32) objects.count();
+    foreach(TraceObject* o, objects)
+        s << o->name();
+
+    s << (quint32) files.count();
+    foreach(TraceFile* f, files)
+        s << f->name();
+
+    s << (quint32) functions.count();
+    foreach(TraceFunction* f, functions)
+        s << f->name() << fileIds.value(f->file()) << objectIds.value(f->object());
+
+    s << (quint32) sources.count();
+    foreach(TraceFunctionSource* fs, sources)
+        s << functionIds.value(fs->function()) << fileIds.value(fs->file());
+
+    s << (quint32) parts.count();
+    foreach(TracePart* part, parts) {
+        EventTypeMapping* mapping = part->eventTypeMapping();
+        QStringList events;
+        for (int i = 0; mapping && (i < mapping->count()); i++)
+            events << set->realType(mapping->realIndex(i))->name();
+
+        s << part->description() << part->trigger()
+          << part->timeframe() << part->version()
+          << (qint32) part->partNumber() << (qint32) part->threadID()
+          << (qint32) part->processID() << events;
+
+        const QList<TracePartFunction*>& list = partFunctions[part];
+        s << (quint32) list.count();
+        foreach(TracePartFunction* pf, list)
+            s << functionIds.value(pf->function())
+              << fileIds.value(pf->partFile()->file())
+              << (pf->partObject() ? objectIds.value(pf->partObject()->object()) : -1);
+
+        // fix cost lists are written oldest first: loading prepends
+        foreach(TracePartFunction* pf, list) {
+            QVector<FixCost*> costs;
+            for (FixCost* fc = pf->firstFixCost(); fc; fc = fc->nextCostOfPartFunction())
+                costs.append(fc);
+            s << (quint32) costs.count();
+            for (int i = costs.count() - 1; i >= 0; i--) {
+                FixCost* fc = costs[i];
+                const PositionSpec& pos = fc->position();
+                s << sourceId(fc->functionSource()) << pos.fromLine << pos.toLine
+                  << (quint64) pos.fromAddr.v() << (quint64) pos.toAddr.v()
+                  << (qint32) fc->count();
+                writeCosts(s, fc->cost(), fc->count());
+            }
+
+            QVector<FixJump*> jumps;
+            for (FixJump* fj = pf->firstFixJump(); fj; fj = fj->nextJumpOfPartFunction())
+                jumps.append(fj);
+            s << (quint32) jumps.count();
+            for (int i = jumps.count() - 1; i >= 0; i--) {
+                FixJump* fj = jumps[i];
+                s << fj->line() << (quint64) fj->addr().v() << sourceId(fj->source())
+                  << fj->targetLine() << (quint64) fj->targetAddr().v()
+                  << functionIds.value(fj->targetFunction())
+                  << sourceId(fj->targetSource())
+                  << (quint8) fj->isCondJump()
+                  << (quint64) fj->executedCount() << (quint64) fj->followedCount();
+            }
+
+            s << (quint32) pf->partCallings().count();
+            foreach(TracePartCall* pc, pf->partCallings()) {
+                TracePartFunction* pfCalled = (TracePartFunction*)
+                        pc->call()->called()->findDepFromPart(part);
+                QVector<FixCallCost*> callCosts;
+                for (FixCallCost* fcc = pc->firstFixCallCost(); fcc;
+                     fcc = fcc->nextCostOfPartCall())
+                    callCosts.append(fcc);
+
+                s << partFunctionIds.value(pfCalled, -1)
+                  << (quint32) callCosts.count();
+                for (int i = callCosts.count() - 1; i >= 0; i--) {
+                    FixCallCost* fcc = callCosts[i];
+                    s << sourceId(fcc->functionSource()) << fcc->line()
+                      << (quint64) fcc->addr().v() << (quint64) fcc->callCount()
+                      << (qint32) fcc->count();
+                    writeCosts(s, fcc->cost(), fcc->count());
+                }
+            }
+        }
+    }
+
+    if (s.status() != QDataStream::Ok) {
+        cache.cancelWriting();
+        return false;
+    }
+
+#if TRACE_CACHELOADER
+    qDebug() << "CacheLoader: written" << cache.fileName();
+#endif
+
+    return cache.commit();
+}
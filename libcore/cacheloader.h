@@ -0,0 +1,60 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-FileCopyrightText: 2026 KCachegrind developers
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Binary cache files for fast reopening of profile data files
+ */
+
+#ifndef CACHELOADER_H
+#define CACHELOADER_H
+
+#include "loader.h"
+#include "tracedata.h"
+
+/**
+ * Loader for binary cache files written after loading a big profile
+ * data file. A cache file is stored as hidden file next to the profile
+ * data file, and is only used as long as size, modification time and
+ * a hash of the profile data file match.
+ *
+ * The cache contains the derived event types declared in the profile
+ * data file, the name tables, the call graph and the cost arrays of the
+ * fix costs of the parts loaded, to be replayed into a TraceData
+ * without parsing.
+ *
+ * Cache files are only written if enabled in GlobalConfig.
+ */
+class CacheLoader: public Loader
+{
+public:
+    CacheLoader();
+
+    // derived event type declared in a profile data file
+    struct EventDefinition {
+        QString name, longName, formula;
+    };
+
+    bool canLoad(QIODevice* file) override;
+    int  load(TraceData*, QIODevice* file, const QString& filename) override;
+    Loader* clone() const override;
+
+    // name of the cache file for profile data file <file>
+    static QString cacheFileName(const QString& file);
+
+    /**
+     * Write cache file for profile data file <file>, with <parts> of
+     * <data> loaded from that file, and derived event types <events>
+     * declared in it.
+     * Does nothing for small files or if disabled in GlobalConfig.
+     */
+    static bool writeCache(TraceData* data, const TracePartList& parts,
+                           const QString& file,
+                           const QList<EventDefinition>& events);
+};
+
+#endif // CACHELOADER_H
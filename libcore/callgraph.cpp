@@ -0,0 +1,189 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Compact call graph for graph algorithms
+ */
+
+#include "callgraph.h"
+
+#include <QHash>
+
+
+//---------------------------------------------------
+// CallGraph
+
+CallGraph::CallGraph()
+{
+}
+
+void CallGraph::clear()
+{
+    _functions.clear();
+    _calls.clear();
+    _cyclic.clear();
+    _callingStart.clear();
+    _callerStart.clear();
+    _callings.clear();
+    _callers.clear();
+}
+
+int CallGraph::id(const TraceFunction* f) const
+{
+    int id = f->graphId();
+    if ((id < 0) || (id >= _functions.count()) ||
+        (_functions[id] != f)) return -1;
+    return id;
+}
+
+int CallGraph::addCall(TraceCall* c, QHash<TraceCall*, int>& callIds)
+{
+    int id = callIds.value(c, -1);
+    if (id >= 0) return id;
+
+    id = _calls.count();
+    _calls.append(c);
+    _cyclic.append((c->inCycle() > 0) || c->isRecursion());
+    callIds.insert(c, id);
+    return id;
+}
+
+void CallGraph::build(TraceData* data)
+{
+    clear();
+
+    TraceFunctionMap::Iterator it;
+    TraceFunctionMap& map = data->functionMap();
+    const TraceFunctionCycleList& cycles = data->functionCycles();
+    _functions.reserve(map.count() + cycles.count());
+    for ( it = map.begin(); it != map.end(); ++it )
+        _functions.append(&(*it));
+    foreach(TraceFunctionCycle* cycle, cycles)
+        _functions.append(cycle);
+
+    int n = _functions.count();
+    for (int i = 0; i < n; i++)
+        _functions[i]->setGraphId(i);
+
+    QHash<TraceCall*, int> callIds;
+    _callingStart.resize(n + 1);
+    _callerStart.resize(n + 1);
+    for (int i = 0; i < n; i++) {
+        TraceFunction* f = _functions[i];
+
+        _callingStart[i] = _callings.count();
+        foreach(TraceCall* c, f->callings(false)) {
+            int target = id(c->called(false));
+            if (target < 0) continue;
+            Edge e = { (quint32) target, (quint32) addCall(c, callIds) };
+            _callings.append(e);
+        }
+
+        _callerStart[i] = _callers.count();
+        foreach(TraceCall* c, f->callers(false)) {
+            int source = id(c->caller(false));
+            if (source < 0) continue;
+            Edge e = { (quint32) source, (quint32) addCall(c, callIds) };
+            _callers.append(e);
+        }
+    }
+    _callingStart[n] = _callings.count();
+    _callerStart[n] = _callers.count();
+
+    _callings.squeeze();
+    _callers.squeeze();
+    _calls.squeeze();
+    _cyclic.squeeze();
+
+    if (0) qDebug("CallGraph: %d functions, %d calls, %d/%d edges",
+                  n, _calls.count(), _callings.count(), _callers.count());
+}
+
+uint64 CallGraph::memorySize() const
+{
+    return _functions.capacity() * sizeof(TraceFunction*) +
+           _calls.capacity() * sizeof(TraceCall*) +
+           _cyclic.capacity() * sizeof(bool) +
+           (_callingStart.capacity() + _callerStart.capacity()) * sizeof(int) +
+           (_callings.capacity() + _callers.capacity()) * sizeof(Edge);
+}
+
+
+//---------------------------------------------------
+// StronglyConnectedComponents
+
+StronglyConnectedComponents::StronglyConnectedComponents(
+        const QVector<int>& start, const QVector<int>& targets)
+{
+    int n = start.count() - 1;
+    if (n <= 0) {
+        _start.append(0);
+        return;
+    }
+
+    // DFS number (0: not visited yet) and lowest reachable DFS number
+    QVector<int> index(n, 0), low(n, 0);
+    QVector<bool> onStack(n, false);
+    // Tarjan stack of visited nodes not assigned to a component yet
+    QVector<int> stack;
+    // DFS path, with the next edge to follow for each node on it
+    QVector<int> path, nextEdge;
+
+    _component.fill(-1, n);
+    _members.reserve(n);
+    _start.append(0);
+
+    int counter = 0;
+    for (int r = 0; r < n; r++) {
+        if (index[r] != 0) continue;
+
+        index[r] = low[r] = ++counter;
+        stack.append(r);
+        onStack[r] = true;
+        path.append(r);
+        nextEdge.append(start[r]);
+
+        while (!path.isEmpty()) {
+            int v = path.last();
+            int& e = nextEdge.last();
+
+            if (e < start[v+1]) {
+                int w = targets[e++];
+                if (index[w] == 0) {
+                    // descend
+                    index[w] = low[w] = ++counter;
+                    stack.append(w);
+                    onStack[w] = true;
+                    path.append(w);
+                    nextEdge.append(start[w]);
+                }
+                else if (onStack[w] && (index[w] < low[v]))
+                    low[v] = index[w];
+                continue;
+            }
+
+            // all edges of v done
+            path.removeLast();
+            nextEdge.removeLast();
+            if (!path.isEmpty() && (low[v] < low[path.last()]))
+                low[path.last()] = low[v];
+
+            if (low[v] != index[v]) continue;
+
+            // v is root of a component: take it from the stack
+            int c = _root.count();
+            int w;
+            do {
+                w = stack.takeLast();
+                onStack[w] = false;
+                _component[w] = c;
+                _members.append(w);
+            } while (w != v);
+            _root.append(v);
+            _start.append(_members.count());
+        }
+    }
+}
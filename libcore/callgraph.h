@@ -0,0 +1,123 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Compact call graph for graph algorithms
+ */
+
+#ifndef CALLGRAPH_H
+#define CALLGRAPH_H
+
+#include <QVector>
+
+#include "tracedata.h"
+
+/**
+ * A frozen snapshot of the call graph of a TraceData in compressed
+ * sparse row (CSR) format, for fast traversal in analyses like
+ * Coverage or call graph layout.
+ *
+ * Functions and function cycles get 32-bit ids, as do calls. For each
+ * function, its calls to callees and from callers are stored as
+ * contiguous ranges of edges. Calls are attributed as seen with cycles
+ * applied, i.e. as returned by TraceFunction::callings(false) and
+ * TraceFunction::callers(false), in the same order.
+ *
+ * The graph is built by TraceData::callGraph() and gets invalid when
+ * cycles are updated, see TraceData::updateFunctionCycles().
+ */
+class CallGraph
+{
+public:
+    struct Edge {
+        // id of the function at other end of the call
+        quint32 function;
+        quint32 call;
+    };
+
+    CallGraph();
+
+    void build(TraceData*);
+    void clear();
+
+    int functionCount() const { return _functions.count(); }
+    int callCount() const { return _calls.count(); }
+
+    TraceFunction* function(int id) const { return _functions[id]; }
+    // id of function @p f, or -1 if not in this graph
+    int id(const TraceFunction* f) const;
+
+    TraceCall* call(int callId) const { return _calls[callId]; }
+    // true if call is a recursion or inside of a cycle
+    bool isCyclic(int callId) const { return _cyclic[callId]; }
+
+    // calls from function with id @p id to called functions
+    const Edge* callingsBegin(int id) const
+    { return _callings.constData() + _callingStart[id]; }
+    const Edge* callingsEnd(int id) const
+    { return _callings.constData() + _callingStart[id+1]; }
+    // calls to function with id @p id from callers
+    const Edge* callersBegin(int id) const
+    { return _callers.constData() + _callerStart[id]; }
+    const Edge* callersEnd(int id) const
+    { return _callers.constData() + _callerStart[id+1]; }
+
+    // bytes allocated
+    uint64 memorySize() const;
+
+private:
+    int addCall(TraceCall*, QHash<TraceCall*, int>&);
+
+    QVector<TraceFunction*> _functions;
+    QVector<TraceCall*> _calls;
+    QVector<bool> _cyclic;
+
+    // edges of function i are in [start[i], start[i+1])
+    QVector<int> _callingStart, _callerStart;
+    QVector<Edge> _callings, _callers;
+};
+
+
+/**
+ * Strongly connected components of a directed graph given in CSR
+ * format, found with Tarjan's algorithm on an explicit stack. This
+ * runs in time linear to the number of nodes and edges, independent
+ * of the depth of the graph.
+ *
+ * Nodes are used as DFS roots in order of their ids, and edges are
+ * followed in given order. Components are numbered in order of their
+ * completion. Used for recursion cycles, see
+ * TraceData::updateFunctionCycles().
+ */
+class StronglyConnectedComponents
+{
+public:
+    /**
+     * Find components of a graph with start.count()-1 nodes, where
+     * targets of edges from node i are in
+     * targets[start[i]] ... targets[start[i+1]-1].
+     */
+    StronglyConnectedComponents(const QVector<int>& start,
+                                const QVector<int>& targets);
+
+    int count() const { return _root.count(); }
+    // node at which the DFS entered component @p c
+    int root(int c) const { return _root[c]; }
+    int size(int c) const { return _start[c+1] - _start[c]; }
+    // nodes of component @p c, in order of removal from the
+    // Tarjan stack, i.e. with root() last
+    const int* membersBegin(int c) const
+    { return _members.constData() + _start[c]; }
+    const int* membersEnd(int c) const
+    { return _members.constData() + _start[c+1]; }
+    // component of node @p n
+    int component(int n) const { return _component[n]; }
+
+private:
+    QVector<int> _root, _start, _members, _component;
+};
+
+#endif // CALLGRAPH_H
@@ -0,0 +1,40 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Column-wise storage of costs of a list of cost items
+ */
+
+#include "costcolumns.h"
+
+
+//---------------------------------------------------
+// CostColumns
+
+CostColumns::CostColumns(EventTypeSet* set, int count)
+{
+    _set = set;
+    _count = count;
+    _costs.fill(0, (qsizetype)set->realCount() * count);
+}
+
+void CostColumns::set(int index, ProfileCostArray* item)
+{
+    if (index < 0 || index >= _count || !item) return;
+
+    int rc = _set->realCount();
+    for (int i = 0; i<rc; i++)
+        _costs[(qsizetype)i * _count + index] = item->subCost(_set->realType(i));
+}
+
+QVector<SubCost> CostColumns::subCosts(EventType* et)
+{
+    QVector<SubCost> result(_count);
+    if (et && _count > 0)
+        et->subCosts(_costs.constData(), _count, result.data());
+
+    return result;
+}
@@ -0,0 +1,55 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Column-wise storage of costs of a list of cost items
+ */
+
+#ifndef COSTCOLUMNS_H
+#define COSTCOLUMNS_H
+
+#include <QVector>
+
+#include "costitem.h"
+#include "eventtype.h"
+
+/**
+ * Copy of the costs of a list of cost items, stored column-wise:
+ * for every real event type, the costs of all items are contiguous.
+ *
+ * The costs of a (real or derived) event type for all items then are
+ * calculated with a linear scan over the columns of the real types
+ * used, instead of calling ProfileCostArray::subCost() per item,
+ * which chases pointers and evaluates formulas per item.
+ * This is for sorting long lists of items by cost, see
+ * FunctionListModel.
+ *
+ * This is a snapshot, filled from the cost arrays of the items: it has
+ * to be rebuilt if costs change. Cost items keep their own cost arrays,
+ * and their aggregation (e.g. in TraceFunction::update()) does not use
+ * columns.
+ */
+class CostColumns
+{
+public:
+    CostColumns(EventTypeSet* set, int count);
+
+    int count() const { return _count; }
+
+    // copy costs of <item> into position <index>
+    void set(int index, ProfileCostArray* item);
+
+    // costs of event type <et> for all items
+    QVector<SubCost> subCosts(EventType* et);
+
+private:
+    EventTypeSet* _set;
+    int _count;
+    // _set->realCount() columns of _count costs
+    QVector<SubCost> _costs;
+};
+
+#endif // COSTCOLUMNS_H
@@ -215,7 +215,8 @@ void ProfileCostArray::set(EventTypeMapping* mapping, FixString & s)
     reserve(mapping->set()->realCount());
 
     if (mapping->isIdentity()) {
-        int i = 0;
+        // SubCost just wraps an uint64
+        int i = s.stripUInt64s((uint64*) _cost, mapping->count());
         while(i<mapping->count()) {
             if (!s.stripUInt64(_cost[i])) break;
             i++;
@@ -439,6 +440,43 @@ void ProfileCostArray::addCost(ProfileCostArray* item)
 #endif
 }
 
+void ProfileCostArray::subtractCost(ProfileCostArray* item)
+{
+    int i;
+    if (!item) return;
+
+    // we have to update the other item if needed
+    // because we access the item costs directly
+    if (item->_dirty) item->update();
+
+    // make sure we have enough space allocated
+    reserve(item->_count);
+
+    for (i = _count; i<item->_count; ++i)
+        _cost[i] = 0;
+    if (item->_count > _count)
+        _count = item->_count;
+
+    for (i = 0; i<item->_count; ++i)
+        _cost[i] -= item->_cost[i];
+
+    Q_ASSERT(_count <= _allocCount);
+    invalidate();
+}
+
+void ProfileCostArray::setCost(const SubCost* cost, int count)
+{
+    reserve(count);
+    for (int i = 0; i<count; i++)
+        _cost[i] = cost[i];
+    _count = count;
+
+    Q_ASSERT(_count <= _allocCount);
+    _cachedType = nullptr;
+    // no update from dependencies needed
+    _dirty = false;
+}
+
 void ProfileCostArray::maxCost(ProfileCostArray* item)
 {
     int i;
@@ -566,6 +604,20 @@ void ProfileCostArray::update()
     _dirty = false;
 }
 
+bool ProfileCostArray::applyDelta(ProfileCostArray* item, bool subtract)
+{
+    if (_dirty) return false;
+
+    if (subtract)
+        subtractCost(item);
+    else
+        addCost(item);
+
+    // still up-to-date
+    _dirty = false;
+    return true;
+}
+
 // this is only for real types
 SubCost ProfileCostArray::subCost(int idx)
 {
@@ -161,6 +161,10 @@ public:
     // add the cost of another item
     void addCost(ProfileCostArray* item);
     void addCost(int index, SubCost value);
+    // subtract the cost of another item
+    void subtractCost(ProfileCostArray* item);
+    // set the costs to given values, this item is up-to-date afterwards
+    void setCost(const SubCost* cost, int count);
 
     // maximal cost
     void maxCost(EventTypeMapping*, FixString&);
@@ -170,6 +174,14 @@ public:
 
     void invalidate() override;
 
+    /**
+     * Add the cost of <item> to this item without invalidating it,
+     * or subtract it if <subtract> is true. Used to incrementally apply
+     * activation changes of trace parts.
+     * Returns false and changes nothing if this item is not up-to-date.
+     */
+    virtual bool applyDelta(ProfileCostArray* item, bool subtract);
+
     /** Returns a sub cost. This automatically triggers
      * a call to update() if needed.
      */
@@ -182,6 +194,10 @@ public:
 
     QString prettySubCostPerCall(EventType* t, uint64 calls);
 
+    // bytes allocated for cost values
+    virtual int costMemory() const
+    { return _allocCount * (int)sizeof(SubCost); }
+
 protected:
     void update() override;
 
@@ -12,9 +12,13 @@
 
 #include "coverage.h"
 
+#include <algorithm>
+
 //#define DEBUG_COVERAGE 1
 
 EventType* Coverage::_costType;
+CallGraph* Coverage::_graph;
+QVector<int> Coverage::_postOrder;
 
 const int Coverage::maxHistogramDepth = maxHistogramDepthValue;
 const int Coverage::Rtti = 1;
@@ -34,6 +38,7 @@ void Coverage::init()
     _maxDistance = 0;
     _active = false;
     _inRecursion = false;
+    _pathWeight = 0.0;
     for (int i = 0;i<maxHistogramDepth;i++) {
         _selfHisto[i] = 0.0;
         _inclHisto[i] = 0.0;
@@ -74,6 +79,7 @@ TraceFunctionList Coverage::coverage(TraceFunction* f, CoverageMode m,
     invalidate(f->data(), Coverage::Rtti);
 
     _costType = ct;
+    _graph = f->data()->callGraph();
 
     // function f takes ownership over c!
     Coverage* c = new Coverage();
@@ -82,228 +88,167 @@ TraceFunctionList Coverage::coverage(TraceFunction* f, CoverageMode m,
 
     TraceFunctionList l;
 
-    if (m == Caller)
-        c->addCallerCoverage(l, 1.0, 0);
-    else
-        c->addCallingCoverage(l, 1.0, 1.0, 0);
+    int root = _graph->id(f);
+    if (root < 0) return l;
+
+    c->_minDistance = 0;
+    c->_inclHisto[0] = 1.0;
+    c->_pathWeight = 1.0;
+
+    QVector<int> order = topologicalOrder(root, m);
+    foreach(int id, order)
+        propagate(id, m, l);
 
     return l;
 }
 
-void Coverage::addCallerCoverage(TraceFunctionList& fList,
-                                 double pBack, int d)
+/**
+ * Edges followed in coverage mode @p m, i.e. calls to callers
+ * or callees with cost, excluding recursion and calls inside of cycles
+ */
+const CallGraph::Edge* Coverage::edgesBegin(int id, CoverageMode m)
 {
-    if (_inRecursion) return;
-
-    double incl;
-    incl  = (double) (_function->inclusive()->subCost(_costType));
-
-    if (_active) {
-#ifdef DEBUG_COVERAGE
-        qDebug("CallerCov: D %d, %s (was active, incl %f, self %f): newP %f", d,
-               qPrintable(_function->prettyName()), _incl, _self, pBack);
-#endif
-        _inRecursion = true;
-    }
-    else {
-        _active = true;
-
-        // only add cost if this is no recursion
-
-        _incl += pBack;
-        _firstPercentage = pBack;
-
-        if (_minDistance > d) _minDistance = d;
-        if (_maxDistance < d) _maxDistance = d;
-        if (d<maxHistogramDepth) {
-            _inclHisto[d] += pBack;
-        }
-        else {
-            _inclHisto[maxHistogramDepth-1] += pBack;
-        }
-
-#ifdef DEBUG_COVERAGE
-        qDebug("CallerCov: D %d, %s (now active, new incl %f): newP %f",
-               d, qPrintable(_function->prettyName()), _incl, pBack);
-#endif
-    }
-
-    double callVal, pBackNew;
-
-    foreach(TraceCall* call, _function->callers()) {
-        if (call->inCycle()>0) continue;
-        if (call->isRecursion()) continue;
-
-        if (call->subCost(_costType)>0) {
-            TraceFunction* caller = call->caller();
-
-            Coverage* c = (Coverage*) caller->association(rtti());
-            if (!c) {
-                c = new Coverage();
-                c->setFunction(caller);
-            }
-            if (!c->isValid()) {
-                c->init();
-                fList.append(caller);
-            }
-
-            if (c->isActive()) continue;
-            if (c->inRecursion()) continue;
+    return (m == Caller) ? _graph->callersBegin(id) : _graph->callingsBegin(id);
+}
 
-            callVal = (double) call->subCost(_costType);
-            pBackNew = pBack * (callVal / incl);
+const CallGraph::Edge* Coverage::edgesEnd(int id, CoverageMode m)
+{
+    return (m == Caller) ? _graph->callersEnd(id) : _graph->callingsEnd(id);
+}
 
-            // FIXME ?!?
+SubCost Coverage::edgeCost(const CallGraph::Edge* e)
+{
+    if (_graph->isCyclic(e->call)) return 0;
+    return _graph->call(e->call)->subCost(_costType);
+}
 
-            if (!c->isActive()) {
-                if (d>=0)
-                    c->callCount() += (double)call->callCount();
-                else
-                    c->callCount() += _callCount;
-            }
-            else {
-                // adjust pNew by sum of geometric series of recursion factor.
-                // Thus we can avoid endless recursion here
-                pBackNew *= 1.0 / (1.0 - pBackNew / c->firstPercentage());
+/**
+ * Functions reachable from @p root in topological order, and their
+ * DFS postorder numbers in _postOrder. Edges to functions on the DFS
+ * path are back edges: dropping these gives a DAG, where an edge
+ * from u to v is kept iff v is finished before u.
+ * This replaces the check for functions active on the current
+ * path when following all paths.
+ */
+QVector<int> Coverage::topologicalOrder(int root, CoverageMode m)
+{
+    _postOrder.fill(-1, _graph->functionCount());
+    QVector<int> order;
+    QVector<bool> visited(_graph->functionCount(), false);
+    // DFS path, with the next edge to follow for each function on it
+    QVector<int> path;
+    QVector<const CallGraph::Edge*> nextEdge;
+
+    visited[root] = true;
+    path.append(root);
+    nextEdge.append(edgesBegin(root, m));
+    while (!path.isEmpty()) {
+        int u = path.last();
+        const CallGraph::Edge*& e = nextEdge.last();
+
+        if (e != edgesEnd(u, m)) {
+            const CallGraph::Edge* edge = e++;
+            if ((edgeCost(edge) > 0) && !visited[edge->function]) {
+                visited[edge->function] = true;
+                path.append(edge->function);
+                nextEdge.append(edgesBegin(edge->function, m));
             }
-
-            // Limit depth
-            if (pBackNew > 0.0001)
-                c->addCallerCoverage(fList, pBackNew, d+1);
+            continue;
         }
+
+        _postOrder[u] = order.count();
+        order.append(u);
+        path.removeLast();
+        nextEdge.removeLast();
     }
 
-    if (_inRecursion)
-        _inRecursion = false;
-    else if (_active)
-        _active = false;
+    std::reverse(order.begin(), order.end());
+    return order;
 }
 
 /**
- * pForward is time on percent used,
- * pBack is given to allow for calculation of call counts
+ * Finish coverage of function @p id with all contributions of
+ * callers (mode Called) or callees (mode Caller) given, and
+ * propagate to its neighbors in the DAG.
+ *
+ * Instead of following each path separately, the percentages of
+ * all paths arriving at a function are summed up per distance in
+ * the distance histogram, giving the same sums. Thus, each DAG edge
+ * is processed once with all distances.
+ * For call counts, _pathWeight is the number of paths (mode Caller)
+ * or the sum of the backward percentages of paths (mode Called).
  */
-void Coverage::addCallingCoverage(TraceFunctionList& fList,
-                                  double pForward, double pBack, int d)
+void Coverage::propagate(int id, CoverageMode m, TraceFunctionList& fList)
 {
-    if (_inRecursion) return;
-
-#ifdef DEBUG_COVERAGE
-    static const char* spaces = "                                            ";
-#endif
-
-    double self, incl;
-    incl  = (double) (_function->inclusive()->subCost(_costType));
-
-#ifdef DEBUG_COVERAGE
-    qDebug("CngCov:%s - %s (incl %f, self %f): forward %f, back %f",
-           spaces+strlen(spaces)-d,
-           qPrintable(_function->prettyName()), _incl, _self, pForward, pBack);
-#endif
-
-
-    if (_active) {
-        _inRecursion = true;
-
-#ifdef DEBUG_COVERAGE
-        qDebug("CngCov:%s < %s: STOP (is active)",
-               spaces+strlen(spaces)-d,
-               qPrintable(_function->prettyName()));
-#endif
-
-    }
-    else {
-        _active = true;
-
-        // only add cost if this is no recursion
-        self = pForward * (_function->subCost(_costType)) / incl;
-        _incl += pForward;
-        _self += self;
-        _firstPercentage = pForward;
-
-        if (_minDistance > d) _minDistance = d;
-        if (_maxDistance < d) _maxDistance = d;
-        if (d<maxHistogramDepth) {
-            _inclHisto[d] += pForward;
-            _selfHisto[d] += self;
-        }
-        else {
-            _inclHisto[maxHistogramDepth-1] += pForward;
-            _selfHisto[maxHistogramDepth-1] += self;
+    TraceFunction* f = _graph->function(id);
+    Coverage* c = (Coverage*) f->association(Rtti);
+    // not reached with percentage above limit
+    if (!c || !c->isValid()) return;
+
+    double incl = (double) (f->inclusive()->subCost(_costType));
+    double selfRatio = (m == Called) ? f->subCost(_costType) / incl : 0.0;
+
+    c->_firstPercentage = c->_inclHisto[c->_minDistance < maxHistogramDepth ?
+                                        c->_minDistance : maxHistogramDepth-1];
+    for (int d = 0;d<maxHistogramDepth;d++) {
+        c->_incl += c->_inclHisto[d];
+        if (m == Called) {
+            c->_selfHisto[d] = c->_inclHisto[d] * selfRatio;
+            c->_self += c->_selfHisto[d];
         }
+    }
 
 #ifdef DEBUG_COVERAGE
-        qDebug("CngCov:%s < %s (incl %f, self %f)",
-               spaces+strlen(spaces)-d,
-               qPrintable(_function->prettyName()), _incl, _self);
+    qDebug("Coverage: %s (incl %f, self %f, distance %d - %d)",
+           qPrintable(f->prettyName()), c->_incl, c->_self,
+           c->_minDistance, c->_maxDistance);
 #endif
-    }
 
-    double callVal, pForwardNew, pBackNew;
+    if (incl <= 0) return;
 
-    foreach(TraceCall* call, _function->callings()) {
-        if (call->inCycle()>0) continue;
-        if (call->isRecursion()) continue;
+    const CallGraph::Edge* end = edgesEnd(id, m);
+    for(const CallGraph::Edge* e = edgesBegin(id, m); e != end; ++e) {
+        // only DAG edges, see topologicalOrder()
+        if (_postOrder[e->function] >= _postOrder[id]) continue;
 
-        if (call->subCost(_costType)>0) {
-            TraceFunction* calling = call->called();
+        double callVal = (double) edgeCost(e);
+        if (callVal <= 0) continue;
 
-            Coverage* c = (Coverage*) calling->association(rtti());
-            if (!c) {
-                c = new Coverage();
-                c->setFunction(calling);
-            }
-            if (!c->isValid()) {
-                c->init();
-                fList.append(calling);
-            }
-
-            if (c->isActive()) continue;
-            if (c->inRecursion()) continue;
+        TraceFunction* next = _graph->function(e->function);
+        Coverage* cn = (Coverage*) next->association(Rtti);
 
-            callVal = (double) call->subCost(_costType);
-            pForwardNew = pForward * (callVal / incl);
-            pBackNew    = pBack * (callVal /
-                                   calling->inclusive()->subCost(_costType));
+        double factor = callVal / incl;
+        bool used = false;
+        for (int d = 0;d<maxHistogramDepth;d++) {
+            double p = c->_inclHisto[d] * factor;
 
-            if (!c->isActive()) {
-                c->callCount() += pBack * call->callCount();
+            // Limit depth
+            if (p <= 0.0001) continue;
 
-#ifdef DEBUG_COVERAGE
-                qDebug("CngCov:%s  > %s: forward %f, back %f, calls %f -> %f, now %f",
-                       spaces+strlen(spaces)-d,
-                       qPrintable(calling->prettyName()),
-                       pForwardNew, pBackNew,
-                       (double)call->callCount(),
-                       pBack * call->callCount(),
-                       c->callCount());
-#endif
+            if (!cn) {
+                cn = new Coverage();
+                cn->setFunction(next);
             }
-            else {
-                // adjust pNew by sum of geometric series of recursion factor.
-                // Thus we can avoid endless recursion here
-                double fFactor = 1.0 / (1.0 - pForwardNew / c->firstPercentage());
-                double bFactor = 1.0 / (1.0 - pBackNew);
-#ifdef DEBUG_COVERAGE
-                qDebug("CngCov:%s Recursion - origP %f, actP %f => factor %f, newP %f",
-                       spaces+strlen(spaces)-d,
-                       c->firstPercentage(), pForwardNew,
-                       fFactor, pForwardNew * fFactor);
-#endif
-                pForwardNew *= fFactor;
-                pBackNew *= bFactor;
-
+            if (!cn->isValid()) {
+                cn->init();
+                fList.append(next);
             }
-
-            // Limit depth
-            if (pForwardNew > 0.0001)
-                c->addCallingCoverage(fList, pForwardNew, pBackNew, d+1);
+            cn->_inclHisto[d+1 < maxHistogramDepth ? d+1 : d] += p;
+            used = true;
         }
+        if (!used) continue;
+
+        if (cn->_minDistance > c->_minDistance+1)
+            cn->_minDistance = c->_minDistance+1;
+        if (cn->_maxDistance < c->_maxDistance+1)
+            cn->_maxDistance = c->_maxDistance+1;
+
+        TraceCall* call = _graph->call(e->call);
+        cn->_callCount += c->_pathWeight * call->callCount();
+        if (m == Caller)
+            cn->_pathWeight += c->_pathWeight;
+        else
+            cn->_pathWeight += c->_pathWeight *
+                               (callVal / next->inclusive()->subCost(_costType));
     }
-
-    if (_inRecursion)
-        _inRecursion = false;
-    else if (_active)
-        _active = false;
 }
-
@@ -13,7 +13,10 @@
 #ifndef COVERAGE_H
 #define COVERAGE_H
 
+#include <QVector>
+
 #include "tracedata.h"
+#include "callgraph.h"
 
 /**
  * Coverage of a function.
@@ -75,10 +78,15 @@ public:
                                       EventType* ct);
 
 private:
-    void addCallerCoverage(TraceFunctionList& l, double, int d);
-    void addCallingCoverage(TraceFunctionList& l, double, double, int d);
+    static const CallGraph::Edge* edgesBegin(int id, CoverageMode m);
+    static const CallGraph::Edge* edgesEnd(int id, CoverageMode m);
+    static SubCost edgeCost(const CallGraph::Edge* e);
+    static QVector<int> topologicalOrder(int root, CoverageMode m);
+    static void propagate(int id, CoverageMode m, TraceFunctionList& l);
 
     double _self, _incl, _firstPercentage, _callCount;
+    // call count weight of paths from start, see propagate()
+    double _pathWeight;
     int _minDistance, _maxDistance;
     bool _active, _inRecursion;
     double _selfHisto[maxHistogramDepthValue];
@@ -86,6 +94,9 @@ private:
 
     // temporary set for one coverage analysis
     static EventType* _costType;
+    static CallGraph* _graph;
+    // DFS postorder number of functions in _graph
+    static QVector<int> _postOrder;
 };
 
 #endif
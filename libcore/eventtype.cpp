@@ -9,6 +9,7 @@
 #include "eventtype.h"
 
 #include <QRegularExpression>
+#include <QMutex>
 #include <QDebug>
 
 #include "globalconfig.h"
@@ -18,6 +19,10 @@
 
 QList<EventType*>* EventType::_knownTypes = nullptr;
 
+// profile data files may be loaded in parallel, each loader possibly
+// registering event types from "event:" lines
+static QMutex knownTypesMutex;
+
 EventType::EventType(const QString& name, const QString& longName,
                      const QString& formula)
 {
@@ -200,6 +205,34 @@ SubCost EventType::subCost(ProfileCostArray* c)
     return res;
 }
 
+void EventType::subCosts(const SubCost* costs, int count, SubCost* result)
+{
+    if (_realIndex != ProfileCostArray::InvalidIndex) {
+        const SubCost* column = costs + (qsizetype)_realIndex * count;
+        for (int n = 0; n<count; n++)
+            result[n] = column[n];
+        return;
+    }
+
+    for (int n = 0; n<count; n++)
+        result[n] = 0;
+
+    if (!_parsed) {
+        if (!parseFormula()) return;
+    }
+
+    // one linear scan per real type used in the formula
+    int rc = _set->realCount();
+    for (int i = 0;i<rc;i++) {
+        if (_coefficient[i] == 0) continue;
+
+        uint64 coefficient = _coefficient[i];
+        const SubCost* column = costs + (qsizetype)i * count;
+        for (int n = 0; n<count; n++)
+            result[n].v += coefficient * column[n].v;
+    }
+}
+
 int EventType::histCost(ProfileCostArray* c, double total, double* hist)
 {
     if (total == 0.0) return 0;
@@ -222,6 +255,7 @@ int EventType::histCost(ProfileCostArray* c, double total, double* hist)
 
 bool EventType::hasKnownRealType(const QString& n)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return false;
 
     foreach (EventType* t, *_knownTypes)
@@ -233,6 +267,7 @@ bool EventType::hasKnownRealType(const QString& n)
 
 bool EventType::hasKnownDerivedType(const QString& n)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return false;
 
     foreach (EventType* t, *_knownTypes)
@@ -244,6 +279,7 @@ bool EventType::hasKnownDerivedType(const QString& n)
 
 EventType* EventType::cloneKnownRealType(const QString& n)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return nullptr;
 
     foreach (EventType* t, *_knownTypes)
@@ -258,6 +294,7 @@ EventType* EventType::cloneKnownRealType(const QString& n)
 
 EventType* EventType::cloneKnownDerivedType(const QString& n)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return nullptr;
 
     foreach (EventType* t, *_knownTypes)
@@ -276,6 +313,7 @@ void EventType::add(EventType* t, bool overwriteExisting)
 
     t->setEventTypeSet(nullptr);
 
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes)
         _knownTypes = new QList<EventType*>;
 
@@ -300,6 +338,7 @@ void EventType::add(EventType* t, bool overwriteExisting)
 
 int EventType::knownTypeCount()
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return 0;
 
     return _knownTypes->count();
@@ -307,6 +346,7 @@ int EventType::knownTypeCount()
 
 bool EventType::remove(const QString& n)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return false;
 
     foreach (EventType* t, *_knownTypes)
@@ -321,6 +361,7 @@ bool EventType::remove(const QString& n)
 
 EventType* EventType::knownType(int i)
 {
+    QMutexLocker locker(&knownTypesMutex);
     if (!_knownTypes) return nullptr;
     if (i<0 || i>=(int)_knownTypes->count()) return nullptr;
 
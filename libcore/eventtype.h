@@ -68,6 +68,14 @@ public:
 
     SubCost subCost(ProfileCostArray*);
 
+    /*
+     * Evaluate for <count> items at once, with real event costs given
+     * column-wise: costs of real type i for all items are at
+     * <costs> + i * <count>. Results go into <result>.
+     * See CostColumns, used for sorting by cost.
+     */
+    void subCosts(const SubCost* costs, int count, SubCost* result);
+
     /*
      * For virtual costs, returns a histogram for use with
      * partitionPixmap().
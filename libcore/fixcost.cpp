@@ -10,6 +10,128 @@
 #include "utils.h"
 #include "addr.h"
 
+#include <string.h>
+
+// PositionSpec
+
+/* Numbers in positions go through the vectorized parsing of cost
+ * values. Spaces are only stripped at the end of a position: before,
+ * they separate the address from a relative line number.
+ */
+static inline bool stripNumber(FixString& line, uint64& v,
+                               bool stripSpaces = true)
+{
+    v = 0;
+    return line.stripUInt64s(&v, 1, stripSpaces) == 1;
+}
+
+bool PositionSpec::parse(FixString& line, const PositionSpec& current,
+                         bool hasAddrInfo, bool hasLineInfo,
+                         int* negativeLine)
+{
+    char c;
+    uint64 v;
+
+    if (hasAddrInfo) {
+
+        if (!line.first(c)) return false;
+
+        if (c == '*') {
+            // nothing changed
+            line.stripFirst(c);
+            fromAddr = current.fromAddr;
+            toAddr = current.toAddr;
+        }
+        else if (c == '+') {
+            line.stripFirst(c);
+            stripNumber(line, v, false);
+            fromAddr = current.fromAddr + (uint) v;
+            toAddr = fromAddr;
+        }
+        else if (c == '-') {
+            line.stripFirst(c);
+            stripNumber(line, v, false);
+            fromAddr = current.fromAddr - (uint) v;
+            toAddr = fromAddr;
+        }
+        else if (c >= '0') {
+            stripNumber(line, v, false);
+            fromAddr = Addr(v);
+            toAddr = fromAddr;
+        }
+        else return false;
+
+        // Range specification
+        if (line.first(c)) {
+            if (c == '+') {
+                line.stripFirst(c);
+                stripNumber(line, v);
+                toAddr = fromAddr + (uint) v;
+            }
+            else if ((c == '-') || (c == ':')) {
+                line.stripFirst(c);
+                stripNumber(line, v);
+                toAddr = Addr(v);
+            }
+        }
+        line.stripSpaces();
+    }
+
+    if (hasLineInfo) {
+
+        if (!line.first(c)) return false;
+
+        if (c > '9') return false;
+        else if (c == '*') {
+            // nothing changed
+            line.stripFirst(c);
+            fromLine = current.fromLine;
+            toLine   = current.toLine;
+        }
+        else if (c == '+') {
+            line.stripFirst(c);
+            stripNumber(line, v, false);
+            fromLine = current.fromLine + (uint) v;
+            toLine = fromLine;
+        }
+        else if (c == '-') {
+            line.stripFirst(c);
+            stripNumber(line, v, false);
+            uint diff = (uint) v;
+            if (current.fromLine < diff) {
+                if (negativeLine)
+                    *negativeLine = (int)current.fromLine - (int)diff;
+                diff = current.fromLine;
+            }
+            fromLine = current.fromLine - diff;
+            toLine = fromLine;
+        }
+        else if (c >= '0') {
+            stripNumber(line, v, false);
+            fromLine = (uint) v;
+            toLine = fromLine;
+        }
+        else return false;
+
+        // Range specification
+        if (line.first(c)) {
+            if (c == '+') {
+                line.stripFirst(c);
+                stripNumber(line, v);
+                toLine = fromLine + (uint) v;
+            }
+            else if ((c == '-') || (c == ':')) {
+                line.stripFirst(c);
+                stripNumber(line, v);
+                toLine = (uint) v;
+            }
+        }
+        line.stripSpaces();
+    }
+
+    return true;
+}
+
 // FixCost
 
 FixCost::FixCost(TracePart* part, FixPool* pool,
@@ -26,7 +148,8 @@ FixCost::FixCost(TracePart* part, FixPool* pool,
 
     _cost = (SubCost*) pool->reserve(sizeof(SubCost) * maxCount);
     s.stripSpaces();
-    int i = 0;
+    // fast path for decimal values, SubCost just wraps an uint64
+    int i = s.stripUInt64s((uint64*) _cost, maxCount);
     while(i<maxCount) {
         if (!s.stripUInt64(_cost[i])) {
             // xdebug used to emit negative costs if it freed memory. It no
@@ -55,6 +178,25 @@ FixCost::FixCost(TracePart* part, FixPool* pool,
                                   partFunction->setFirstFixCost(this) : nullptr;
 }
 
+FixCost::FixCost(TracePart* part, FixPool* pool,
+                 TraceFunctionSource* functionSource,
+                 PositionSpec& pos,
+                 TracePartFunction* partFunction,
+                 const SubCost* cost, int count)
+{
+    _part = part;
+    _functionSource = functionSource;
+    _pos = pos;
+
+    _cost = (SubCost*) pool->allocate(sizeof(SubCost) * count);
+    _count = _cost ? count : 0;
+    if (_count > 0)
+        memcpy((void*) _cost, cost, sizeof(SubCost) * _count);
+
+    _nextCostOfPartFunction = partFunction ?
+                                  partFunction->setFirstFixCost(this) : nullptr;
+}
+
 void* FixCost::operator new(size_t size, FixPool* pool)
 {
     return pool->allocate(size);
@@ -73,6 +215,22 @@ void FixCost::addTo(ProfileCostArray* c)
     }
 }
 
+void FixCost::addCost(FixString& s)
+{
+    SubCost v;
+
+    s.stripSpaces();
+    for(int i=0; i<_count; i++) {
+        if (!s.stripUInt64(v)) {
+            // negative costs are clamped to zero, see constructor
+            int64 temp;
+            if (s.stripInt64(temp) && temp < 0) continue;
+            break;
+        }
+        _cost[i] += v;
+    }
+}
+
 
 
 // FixCallCost
@@ -96,7 +254,7 @@ FixCallCost::FixCallCost(TracePart* part, FixPool* pool,
 
     _cost = (SubCost*) pool->reserve(sizeof(SubCost) * (maxCount+1));
     s.stripSpaces();
-    int i = 0;
+    int i = s.stripUInt64s((uint64*) _cost, maxCount);
     while(i<maxCount) {
         if (!s.stripUInt64(_cost[i])) {
             // Same case as in the FixCost ctor.
@@ -119,6 +277,28 @@ FixCallCost::FixCallCost(TracePart* part, FixPool* pool,
     _nextCostOfPartCall = partCall ? partCall->setFirstFixCallCost(this) : nullptr;
 }
 
+FixCallCost::FixCallCost(TracePart* part, FixPool* pool,
+                         TraceFunctionSource* functionSource,
+                         unsigned int line, Addr addr,
+                         TracePartCall* partCall,
+                         SubCost callCount,
+                         const SubCost* cost, int count)
+{
+    _part = part;
+    _functionSource = functionSource;
+    _line = line;
+    _addr = addr;
+
+    _cost = (SubCost*) pool->allocate(sizeof(SubCost) * (count+1));
+    _count = _cost ? count : 0;
+    if (_count > 0)
+        memcpy((void*) _cost, cost, sizeof(SubCost) * _count);
+    if (_cost)
+        _cost[_count] = callCount;
+
+    _nextCostOfPartCall = partCall ? partCall->setFirstFixCallCost(this) : nullptr;
+}
+
 void* FixCallCost::operator new(size_t size, FixPool* pool)
 {
     return pool->allocate(size);
@@ -198,3 +378,75 @@ void FixJump::addTo(TraceJumpCost* jc)
     if (_isCondJump)
         jc->addFollowedCount(_cost[1]);
 }
+
+
+
+// FixInstrRange
+
+FixInstrRange::FixInstrRange(TracePart* part, FixPool*,
+                             TraceFunctionSource* functionSource,
+                             TracePartFunction* partFunction,
+                             uint64 start, const PositionSpec& startPos,
+                             bool startsWithSelfCost, bool hasLineInfo)
+{
+    _part = part;
+    _functionSource = functionSource;
+    _start = start;
+    _end = start;
+    _pos = startPos;
+    _startsWithSelfCost = startsWithSelfCost;
+    _hasLineInfo = hasLineInfo;
+
+    _nextRangeOfPartFunction = partFunction ?
+                                   partFunction->setFirstFixInstrRange(this) : nullptr;
+}
+
+void* FixInstrRange::operator new(size_t size, FixPool* pool)
+{
+    return pool->allocate(size);
+}
+
+void FixInstrRange::addTo(TraceFunction* f, TracePartFunction* pf,
+                          FixFile& file)
+{
+    EventTypeMapping* mapping = _part->eventTypeMapping();
+    PositionSpec pos = _pos;
+    bool selfCost = _startsWithSelfCost;
+    FixString line;
+    char c;
+
+    TraceLine* l = nullptr;
+    TraceInstr* i = nullptr;
+    TracePartInstr* pi = nullptr;
+
+    if (!file.setCurrent(_start)) return;
+    while((file.current() < _end) && file.nextLine(line)) {
+        if (!line.first(c) || (c == '#')) continue;
+
+        if (c > '9') {
+            // the cost line after calls=, rcalls=, jump= or jcnd=
+            // is no self cost. Other lines cannot be in a range
+            if (line.stripPrefix("calls=") || line.stripPrefix("rcalls=") ||
+                line.stripPrefix("jump=") || line.stripPrefix("jcnd="))
+                selfCost = false;
+            continue;
+        }
+
+        if (!pos.parse(line, pos, true, _hasLineInfo)) continue;
+        if (!selfCost) {
+            selfCost = true;
+            continue;
+        }
+        if (pos.fromAddr == Addr(0)) continue;
+
+        if (!l || (l->lineno() != pos.fromLine))
+            l = _functionSource->line(pos.fromLine, true);
+
+        if (!i || (i->addr() != pos.fromAddr)) {
+            i = f->instr(pos.fromAddr, true);
+            if (!i->line()) i->setLine(l);
+            pi = i->partInstr(_part, pf);
+        }
+        pi->addCost(mapping, line);
+    }
+}
@@ -30,6 +30,17 @@ public:
     bool isLineRegion() const { return (fromLine != toLine); }
     bool isAddrRegion() const { return (fromAddr != toAddr); }
 
+    /**
+     * Parse a position specification of a cost line from @p s into this,
+     * with relative positions based on @p current.
+     * A negative line number is clamped to 0, and the number is stored
+     * into @p negativeLine if given.
+     * Returns false if this is no position specification.
+     */
+    bool parse(FixString& s, const PositionSpec& current,
+               bool hasAddrInfo, bool hasLineInfo,
+               int* negativeLine = nullptr);
+
     uint fromLine, toLine;
     Addr fromAddr, toAddr;
 };
@@ -49,10 +60,18 @@ public:
             PositionSpec&,
             TracePartFunction*,
             FixString&);
+    // with <count> costs from <cost>, see CacheLoader
+    FixCost(TracePart*, FixPool*,
+            TraceFunctionSource*,
+            PositionSpec&,
+            TracePartFunction*,
+            const SubCost* cost, int count);
 
     void *operator new(size_t size, FixPool*);
 
     void addTo(ProfileCostArray*);
+    // add costs of a further cost line, see CachegrindLoader
+    void addCost(FixString&);
 
     TracePart* part() const { return _part; }
     bool isLineRegion() const { return _pos.isLineRegion(); }
@@ -64,10 +83,19 @@ public:
     Addr addr() const { return _pos.fromAddr; }
     Addr toAddr() const { return _pos.toAddr; }
     TraceFunctionSource* functionSource() const { return _functionSource; }
+    const PositionSpec& position() const { return _pos; }
+    int count() const { return _count; }
+    const SubCost* cost() const { return _cost; }
 
     FixCost* nextCostOfPartFunction() const
     { return _nextCostOfPartFunction; }
 
+    // for moving into another TraceData, see TraceData::mergeStaged()
+    void relocate(TracePart* part, TraceFunctionSource* fs)
+    { _part = part; _functionSource = fs; }
+    void setNextCostOfPartFunction(FixCost* fc)
+    { _nextCostOfPartFunction = fc; }
+
 private:
     int _count;
     SubCost*  _cost;
@@ -93,6 +121,13 @@ public:
                 Addr addr,
                 TracePartCall*,
                 SubCost, FixString&);
+    // with <count> costs from <cost>, see CacheLoader
+    FixCallCost(TracePart*, FixPool*,
+                TraceFunctionSource*,
+                unsigned int line,
+                Addr addr,
+                TracePartCall*,
+                SubCost, const SubCost* cost, int count);
 
     void *operator new(size_t size, FixPool*);
 
@@ -104,9 +139,17 @@ public:
     Addr addr() const { return _addr; }
     SubCost callCount() const { return _cost[_count]; }
     TraceFunctionSource* functionSource() const	{ return _functionSource; }
+    int count() const { return _count; }
+    const SubCost* cost() const { return _cost; }
     FixCallCost* nextCostOfPartCall() const
     { return _nextCostOfPartCall; }
 
+    // for moving into another TraceData, see TraceData::mergeStaged()
+    void relocate(TracePart* part, TraceFunctionSource* fs)
+    { _part = part; _functionSource = fs; }
+    void setNextCostOfPartCall(FixCallCost* fc)
+    { _nextCostOfPartCall = fc; }
+
 private:
     // we use 1 SubCost more than _count: _cost[_count] is the call count
     int _count;
@@ -156,6 +199,15 @@ public:
     FixJump* nextJumpOfPartFunction() const
     { return _nextJumpOfPartFunction; }
 
+    // for moving into another TraceData, see TraceData::mergeStaged()
+    void relocate(TracePart* part, TraceFunctionSource* source,
+                  TraceFunction* targetFunction,
+                  TraceFunctionSource* targetSource)
+    { _part = part; _source = source;
+      _targetFunction = targetFunction; _targetSource = targetSource; }
+    void setNextJumpOfPartFunction(FixJump* fj)
+    { _nextJumpOfPartFunction = fj; }
+
 private:
     bool _isCondJump;
     SubCost* _cost;
@@ -168,6 +220,58 @@ private:
     FixJump *_nextJumpOfPartFunction;
 };
 
+/**
+ * A range of a profile data file with the cost lines of a part function
+ * for one source file, when costs of instructions are read only on demand
+ * (see GlobalConfig::lazyInstrDetail()). The self cost of these lines
+ * is kept per source line in FixCost objects without address; calls and
+ * jumps are kept as usual.
+ */
+class FixInstrRange
+{
+
+public:
+    FixInstrRange(TracePart*, FixPool*,
+                  TraceFunctionSource*,
+                  TracePartFunction*,
+                  uint64 start, const PositionSpec& startPos,
+                  bool startsWithSelfCost, bool hasLineInfo);
+
+    void *operator new(size_t size, FixPool*);
+
+    /**
+     * Read the self costs of instructions in this range from @p file
+     * into the part instructions of function @p f.
+     */
+    void addTo(TraceFunction* f, TracePartFunction*, FixFile& file);
+
+    TracePart* part() const { return _part; }
+    TraceFunctionSource* functionSource() const { return _functionSource; }
+    uint64 start() const { return _start; }
+    uint64 end() const { return _end; }
+    void setEnd(uint64 end) { _end = end; }
+
+    FixInstrRange* nextRangeOfPartFunction() const
+    { return _nextRangeOfPartFunction; }
+
+    // for moving into another TraceData, see TraceData::mergeStaged()
+    void relocate(TracePart* part, TraceFunctionSource* fs)
+    { _part = part; _functionSource = fs; }
+    void setNextRangeOfPartFunction(FixInstrRange* fr)
+    { _nextRangeOfPartFunction = fr; }
+
+private:
+    uint64 _start, _end;
+    // position before first line, needed for relative positions
+    PositionSpec _pos;
+    // false if first cost line is a call or jump cost line
+    bool _startsWithSelfCost, _hasLineInfo;
+
+    TracePart* _part;
+    TraceFunctionSource* _functionSource;
+    FixInstrRange* _nextRangeOfPartFunction;
+};
+
 #endif
 
 
@@ -0,0 +1,228 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Sorted map with flat storage
+ */
+
+#ifndef FLATMAP_H
+#define FLATMAP_H
+
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+
+#include <QVector>
+
+/**
+ * Map from sorted keys to values, for maps filled once (while loading)
+ * and read often afterwards, such as the instructions of a function.
+ *
+ * Values are created in blocks and never move, so pointers to values
+ * stay valid until the map is deleted. Keys and value pointers are kept
+ * in sorted arrays, allowing for binary search and fast iteration.
+ * Insertion of ascending keys is an append; other keys are collected
+ * in a small sorted array, merged into the main one when it gets too
+ * big or on iteration.
+ *
+ * Iterators are random access, but get invalid on insertion.
+ * Values are default constructed, as with QMap::operator[].
+ */
+template<class Key, class T>
+class FlatMap
+{
+public:
+    template<class V>
+    class IteratorBase
+    {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef std::ptrdiff_t difference_type;
+        typedef V value_type;
+        typedef V* pointer;
+        typedef V& reference;
+
+        IteratorBase() : _key(nullptr), _item(nullptr) {}
+        IteratorBase(const Key* k, T* const* i) : _key(k), _item(i) {}
+        // allow conversion from Iterator to ConstIterator
+        template<class V2>
+        IteratorBase(const IteratorBase<V2>& o) : _key(o._key), _item(o._item) {}
+
+        const Key& key() const { return *_key; }
+        V& value() const { return **_item; }
+        V& operator*() const { return **_item; }
+        V* operator->() const { return *_item; }
+        V& operator[](difference_type n) const { return *_item[n]; }
+
+        IteratorBase& operator++() { ++_key; ++_item; return *this; }
+        IteratorBase operator++(int) { IteratorBase r = *this; ++*this; return r; }
+        IteratorBase& operator--() { --_key; --_item; return *this; }
+        IteratorBase operator--(int) { IteratorBase r = *this; --*this; return r; }
+        IteratorBase& operator+=(difference_type n) { _key += n; _item += n; return *this; }
+        IteratorBase& operator-=(difference_type n) { _key -= n; _item -= n; return *this; }
+        IteratorBase operator+(difference_type n) const { IteratorBase r = *this; return r += n; }
+        IteratorBase operator-(difference_type n) const { IteratorBase r = *this; return r -= n; }
+        difference_type operator-(const IteratorBase& o) const { return _item - o._item; }
+
+        bool operator==(const IteratorBase& o) const { return _item == o._item; }
+        bool operator!=(const IteratorBase& o) const { return _item != o._item; }
+        bool operator<(const IteratorBase& o) const { return _item < o._item; }
+        bool operator>(const IteratorBase& o) const { return _item > o._item; }
+        bool operator<=(const IteratorBase& o) const { return _item <= o._item; }
+        bool operator>=(const IteratorBase& o) const { return _item >= o._item; }
+
+    private:
+        template<class, class> friend class FlatMap;
+        template<class> friend class IteratorBase;
+
+        const Key* _key;
+        T* const* _item;
+    };
+
+    typedef IteratorBase<T> Iterator;
+    typedef IteratorBase<const T> ConstIterator;
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+
+    FlatMap() : _blockSize(0), _blockUsed(0) {}
+    ~FlatMap()
+    {
+        foreach(T* b, _blocks)
+            delete[] b;
+    }
+
+    FlatMap(const FlatMap&) = delete;
+    FlatMap& operator=(const FlatMap&) = delete;
+
+    int count() const { return _keys.count() + _pendingKeys.count(); }
+    int size() const { return count(); }
+    bool isEmpty() const { return count() == 0; }
+    bool empty() const { return isEmpty(); }
+
+    Iterator begin() { freeze(); return Iterator(_keys.constData(), _items.constData()); }
+    Iterator end() { freeze(); return begin() + _items.count(); }
+    ConstIterator begin() const { return constBegin(); }
+    ConstIterator end() const { return constEnd(); }
+    ConstIterator constBegin() const
+    {
+        freeze();
+        return ConstIterator(_keys.constData(), _items.constData());
+    }
+    ConstIterator constEnd() const { return constBegin() + _items.count(); }
+
+    Iterator find(const Key& key)
+    {
+        freeze();
+        int i = indexOf(_keys, key);
+        return (i < 0) ? end() : begin() + i;
+    }
+
+    /**
+     * Value for @p key, or nullptr if not existing.
+     * In contrast to find(), this does not merge pending insertions.
+     */
+    T* item(const Key& key) const
+    {
+        int i = indexOf(_keys, key);
+        if (i >= 0) return _items[i];
+        i = indexOf(_pendingKeys, key);
+        return (i < 0) ? nullptr : _pendingItems[i];
+    }
+
+    // value for @p key, created if not existing
+    T& operator[](const Key& key)
+    {
+        T* v = item(key);
+        if (v) return *v;
+
+        v = newItem();
+        if (_pendingKeys.isEmpty() &&
+            (_keys.isEmpty() || (_keys.last() < key))) {
+            _keys.append(key);
+            _items.append(v);
+        }
+        else {
+            int i = int(std::lower_bound(_pendingKeys.constBegin(),
+                                         _pendingKeys.constEnd(), key)
+                        - _pendingKeys.constBegin());
+            _pendingKeys.insert(i, key);
+            _pendingItems.insert(i, v);
+            if (_pendingKeys.count() > 16 + _keys.count() / 16)
+                freeze();
+        }
+        return *v;
+    }
+
+    // bytes allocated for values and the sorted arrays
+    size_t memorySize() const
+    {
+        size_t values = 0;
+        for (int i = 0; i < _blocks.count(); i++)
+            values += qMin(4 << qMin(i, 6), 256);
+        return values * sizeof(T) +
+                (_keys.capacity() + _pendingKeys.capacity()) * sizeof(Key) +
+                (_items.capacity() + _pendingItems.capacity()) * sizeof(T*) +
+                _blocks.capacity() * sizeof(T*);
+    }
+
+    // merge pending insertions into the sorted arrays
+    void freeze() const
+    {
+        int n = _pendingKeys.count();
+        if (n == 0) return;
+
+        // merge from the back, into the enlarged arrays
+        int i = _keys.count() - 1, j = n - 1;
+        _keys.resize(i + 1 + n);
+        _items.resize(i + 1 + n);
+        Key* keys = _keys.data();
+        T** items = _items.data();
+        for (int k = i + n; j >= 0; k--) {
+            if ((i >= 0) && (_pendingKeys[j] < keys[i])) {
+                keys[k] = keys[i];
+                items[k] = items[i];
+                i--;
+            }
+            else {
+                keys[k] = _pendingKeys[j];
+                items[k] = _pendingItems[j];
+                j--;
+            }
+        }
+        _pendingKeys.clear();
+        _pendingItems.clear();
+    }
+
+private:
+    static int indexOf(const QVector<Key>& keys, const Key& key)
+    {
+        const Key* b = keys.constData();
+        const Key* e = b + keys.count();
+        const Key* p = std::lower_bound(b, e, key);
+        if ((p == e) || (key < *p)) return -1;
+        return int(p - b);
+    }
+
+    T* newItem()
+    {
+        // block sizes grow from 4 to 256 values
+        if (_blockUsed == _blockSize) {
+            _blockSize = (_blockSize == 0) ? 4 : qMin(2 * _blockSize, 256);
+            _blocks.append(new T[_blockSize]);
+            _blockUsed = 0;
+        }
+        return _blocks.last() + _blockUsed++;
+    }
+
+    QVector<T*> _blocks;
+    int _blockSize, _blockUsed;
+
+    // sorted keys with values, and pending sorted insertions
+    mutable QVector<Key> _keys, _pendingKeys;
+    mutable QVector<T*> _items, _pendingItems;
+};
+
+#endif // FLATMAP_H
@@ -30,6 +30,11 @@
 #define DEFAULT_MAXLISTCOUNT     100
 #define DEFAULT_CONTEXT          3
 #define DEFAULT_NOCOSTINSIDE     20
+#define DEFAULT_LOADTHREADS      0
+#define DEFAULT_USECACHEFILES    false
+#define DEFAULT_USEPARTPREFIXSUMS false
+#define DEFAULT_LAZYINSTRDETAIL  false
+#define DEFAULT_USEHUGEPAGES     false
 
 
 //
@@ -126,6 +131,13 @@ GlobalConfig::GlobalConfig()
     // annotation behaviour
     _context          = DEFAULT_CONTEXT;
     _noCostInside     = DEFAULT_NOCOSTINSIDE;
+
+    // loading
+    _loadThreads      = DEFAULT_LOADTHREADS;
+    _useCacheFiles    = DEFAULT_USECACHEFILES;
+    _usePartPrefixSums = DEFAULT_USEPARTPREFIXSUMS;
+    _lazyInstrDetail  = DEFAULT_LAZYINSTRDETAIL;
+    _useHugePages     = DEFAULT_USEHUGEPAGES;
 }
 
 GlobalConfig::~GlobalConfig()
@@ -183,6 +195,16 @@ void GlobalConfig::saveOptions()
                             DEFAULT_NOCOSTINSIDE);
     generalConfig->setValue(QStringLiteral("HideTemplates"), _hideTemplates,
                             DEFAULT_HIDETEMPLATES);
+    generalConfig->setValue(QStringLiteral("LoadThreads"), _loadThreads,
+                            DEFAULT_LOADTHREADS);
+    generalConfig->setValue(QStringLiteral("UseCacheFiles"), _useCacheFiles,
+                            DEFAULT_USECACHEFILES);
+    generalConfig->setValue(QStringLiteral("UsePartPrefixSums"),
+                            _usePartPrefixSums, DEFAULT_USEPARTPREFIXSUMS);
+    generalConfig->setValue(QStringLiteral("LazyInstrDetail"),
+                            _lazyInstrDetail, DEFAULT_LAZYINSTRDETAIL);
+    generalConfig->setValue(QStringLiteral("UseHugePages"), _useHugePages,
+                            DEFAULT_USEHUGEPAGES);
     delete generalConfig;
 
     // store known event types
@@ -254,6 +276,16 @@ void GlobalConfig::readOptions()
                                              DEFAULT_NOCOSTINSIDE).toInt();
     _hideTemplates    = generalConfig->value(QStringLiteral("HideTemplates"),
                                              DEFAULT_HIDETEMPLATES).toBool();
+    _loadThreads      = generalConfig->value(QStringLiteral("LoadThreads"),
+                                             DEFAULT_LOADTHREADS).toInt();
+    _useCacheFiles    = generalConfig->value(QStringLiteral("UseCacheFiles"),
+                                             DEFAULT_USECACHEFILES).toBool();
+    _usePartPrefixSums = generalConfig->value(QStringLiteral("UsePartPrefixSums"),
+                                              DEFAULT_USEPARTPREFIXSUMS).toBool();
+    _lazyInstrDetail  = generalConfig->value(QStringLiteral("LazyInstrDetail"),
+                                             DEFAULT_LAZYINSTRDETAIL).toBool();
+    _useHugePages     = generalConfig->value(QStringLiteral("UseHugePages"),
+                                             DEFAULT_USEHUGEPAGES).toBool();
     delete generalConfig;
 
     // event types
@@ -415,6 +447,31 @@ int GlobalConfig::noCostInside()
     return config()->_noCostInside;
 }
 
+int GlobalConfig::loadThreads()
+{
+    return config()->_loadThreads;
+}
+
+bool GlobalConfig::useCacheFiles()
+{
+    return config()->_useCacheFiles;
+}
+
+bool GlobalConfig::usePartPrefixSums()
+{
+    return config()->_usePartPrefixSums;
+}
+
+bool GlobalConfig::lazyInstrDetail()
+{
+    return config()->_lazyInstrDetail;
+}
+
+bool GlobalConfig::useHugePages()
+{
+    return config()->_useHugePages;
+}
+
 void GlobalConfig::setPercentPrecision(int v)
 {
     if ((v<1) || (v >5)) return;
@@ -445,6 +502,37 @@ void GlobalConfig::setContext(int v)
     _context = v;
 }
 
+void GlobalConfig::setLoadThreads(int v)
+{
+    GlobalConfig* c = config();
+    if ((v<0) || (v >256)) return;
+    c->_loadThreads = v;
+}
+
+void GlobalConfig::setUseCacheFiles(bool b)
+{
+    GlobalConfig* c = config();
+    c->_useCacheFiles = b;
+}
+
+void GlobalConfig::setUsePartPrefixSums(bool b)
+{
+    GlobalConfig* c = config();
+    c->_usePartPrefixSums = b;
+}
+
+void GlobalConfig::setLazyInstrDetail(bool b)
+{
+    GlobalConfig* c = config();
+    c->_lazyInstrDetail = b;
+}
+
+void GlobalConfig::setUseHugePages(bool b)
+{
+    GlobalConfig* c = config();
+    c->_useHugePages = b;
+}
+
 const QStringList& GlobalConfig::generalSourceDirs()
 {
     return _generalSourceDirs;
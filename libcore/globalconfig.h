@@ -58,6 +58,18 @@ public:
     static int context();
     // how many lines without cost are still regarded as inside a function
     static int noCostInside();
+    // number of threads used for loading profile data (0: one per core)
+    static int loadThreads();
+    // use binary cache files next to big profile data files for fast
+    // reopening; off by default, as hidden files get written
+    static bool useCacheFiles();
+    // keep prefix sums over parts for fast selection of part ranges
+    static bool usePartPrefixSums();
+    // read costs of instructions from profile data files only on demand
+    static bool lazyInstrDetail();
+    // back memory pools of profile data with huge pages, see FixPool;
+    // taken over at application start
+    static bool useHugePages();
 
     const QStringList& generalSourceDirs();
     QStringList objectSourceDirs(QString);
@@ -77,6 +89,11 @@ public:
     static void setShowCycles(bool);
 
     static void setHideTemplates(bool);
+    static void setLoadThreads(int);
+    static void setUseCacheFiles(bool);
+    static void setUsePartPrefixSums(bool);
+    static void setLazyInstrDetail(bool);
+    static void setUseHugePages(bool);
     // upper limit for cutting of a call in cycle detection
     static double cycleCut();
 
@@ -95,6 +112,8 @@ protected:
     int _percentPrecision;
     int _maxSymbolLength, _maxSymbolCount, _maxListCount;
     int _context, _noCostInside;
+    int _loadThreads;
+    bool _useCacheFiles, _usePartPrefixSums, _lazyInstrDetail, _useHugePages;
 
     static GlobalConfig* _config;
 };
@@ -4,6 +4,7 @@ DEPENDPATH += $$PWD
 NHEADERS += \
     $$PWD/context.h \
     $$PWD/costitem.h \
+    $$PWD/costcolumns.h \
     $$PWD/subcost.h \
     $$PWD/eventtype.h \
     $$PWD/addr.h \
@@ -13,7 +14,14 @@ NHEADERS += \
     $$PWD/utils.h \
     $$PWD/logger.h \
     $$PWD/loader.h \
+    $$PWD/backgroundload.h \
+    $$PWD/cacheloader.h \
+    $$PWD/callgraph.h \
     $$PWD/fixcost.h \
+    $$PWD/flatmap.h \
+    $$PWD/memoryusage.h \
+    $$PWD/nametable.h \
+    $$PWD/partprefixsums.h \
     $$PWD/pool.h \
     $$PWD/coverage.h \
     $$PWD/stackbrowser.h
@@ -21,16 +29,23 @@ NHEADERS += \
 SOURCES += \
     $$PWD/context.cpp \
     $$PWD/costitem.cpp \
+    $$PWD/costcolumns.cpp \
     $$PWD/subcost.cpp \
     $$PWD/eventtype.cpp \
     $$PWD/addr.cpp \
+    $$PWD/backgroundload.cpp \
     $$PWD/cachegrindloader.cpp \
+    $$PWD/cacheloader.cpp \
+    $$PWD/callgraph.cpp \
     $$PWD/config.cpp \
     $$PWD/coverage.cpp \
     $$PWD/fixcost.cpp \
     $$PWD/globalconfig.cpp \
     $$PWD/loader.cpp \
     $$PWD/logger.cpp \
+    $$PWD/memoryusage.cpp \
+    $$PWD/nametable.cpp \
+    $$PWD/partprefixsums.cpp \
     $$PWD/pool.cpp \
     $$PWD/stackbrowser.cpp \
     $$PWD/tracedata.cpp \
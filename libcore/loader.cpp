@@ -58,10 +58,13 @@ Loader* Loader::loader(const QString& name)
 }
 
 // factories of available loaders
+Loader* createCacheLoader();
 Loader* createCachegrindLoader();
 
 void Loader::initLoaders()
 {
+    // binary cache files have precedence over the profile data files
+    _loaderList.append(createCacheLoader());
     _loaderList.append(createCachegrindLoader());
     //_loaderList.append(GProfLoader::createLoader());
 }
@@ -23,7 +23,7 @@ class Logger;
 
 /**
  * To implement a new loader, inherit from the Loader class and
- * and reimplement canLoad() and load().
+ * and reimplement canLoad(), load() and clone().
  *
  * For registration, put into the static initLoaders() function
  * of this base class a _loaderList.append(new MyLoader()).
@@ -51,6 +51,10 @@ public:
      * return the number of sections loaded (0 on error)
      */
     virtual int load(TraceData*, QIODevice* file, const QString& filename);
+    /* a new instance of this loader, used for loading
+     * multiple files in parallel (registered loaders are shared)
+     */
+    virtual Loader* clone() const = 0;
 
     static Loader* matchingLoader(QIODevice* file);
     static Loader* loader(const QString& name);
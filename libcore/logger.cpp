@@ -57,3 +57,47 @@ void Logger::loadFinished(const QString& msg)
     else
         qDebug() << "Error loading file" << _filename << ":" << qPrintable(msg);
 }
+
+
+/// BufferedLogger
+
+void BufferedLogger::loadStart(const QString& filename)
+{
+    _progress.storeRelaxed(0);
+    _messages.append(Message{ Start, 0, filename });
+}
+
+void BufferedLogger::loadProgress(int progress)
+{
+    _progress.storeRelaxed(progress);
+}
+
+void BufferedLogger::loadWarning(int line, const QString& msg)
+{
+    _messages.append(Message{ Warning, line, msg });
+}
+
+void BufferedLogger::loadError(int line, const QString& msg)
+{
+    _messages.append(Message{ Error, line, msg });
+}
+
+void BufferedLogger::loadFinished(const QString& msg)
+{
+    _messages.append(Message{ Finished, 0, msg });
+}
+
+void BufferedLogger::forward(Logger* l)
+{
+    if (l) {
+        foreach(const Message& m, _messages) {
+            switch(m.type) {
+            case Start:    l->loadStart(m.msg); break;
+            case Warning:  l->loadWarning(m.line, m.msg); break;
+            case Error:    l->loadError(m.line, m.msg); break;
+            case Finished: l->loadFinished(m.msg); break;
+            }
+        }
+    }
+    _messages.clear();
+}
@@ -16,8 +16,10 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <qlist.h>
 #include <qstring.h>
 #include <qtimer.h>
+#include <QAtomicInt>
 
 class Logger
 {
@@ -38,6 +40,38 @@ private:
     QTimer _timer;
 };
 
+/**
+ * Logger recording notifications, e.g. from loading in another thread,
+ * to be forwarded to another logger afterwards.
+ * Progress notifications are not recorded, but the last one can be
+ * queried from any thread.
+ */
+class BufferedLogger: public Logger
+{
+public:
+    void loadStart(const QString& filename) override;
+    void loadProgress(int progress) override;
+    void loadWarning(int line, const QString& msg) override;
+    void loadError(int line, const QString& msg) override;
+    void loadFinished(const QString& msg) override;
+
+    // forward recorded notifications to @p l, in order
+    void forward(Logger* l);
+
+    // last progress of current file (0 - 100)
+    int progress() const { return _progress.loadRelaxed(); }
+
+private:
+    enum MessageType { Start, Warning, Error, Finished };
+    struct Message {
+        MessageType type;
+        int line;
+        QString msg;
+    };
+    QList<Message> _messages;
+    QAtomicInt _progress;
+};
+
 #endif // LOGGER_H
 
 
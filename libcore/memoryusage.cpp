@@ -0,0 +1,101 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Accounting of memory used by profile data
+ */
+
+#include "memoryusage.h"
+
+#include <QObject>
+#include <QChar>
+
+
+//---------------------------------------------------
+// MemoryUsage
+
+MemoryUsage::MemoryUsage()
+{
+    for (int i = 0; i < CategoryCount; i++) {
+        _bytes[i] = 0;
+        _items[i] = 0;
+    }
+}
+
+void MemoryUsage::add(Category c, uint64 bytes, int items)
+{
+    _bytes[c] += bytes;
+    _items[c] += items;
+}
+
+uint64 MemoryUsage::total() const
+{
+    uint64 sum = 0;
+    for (int i = 0; i < CategoryCount; i++)
+        sum += _bytes[i];
+    return sum;
+}
+
+QString MemoryUsage::categoryName(Category c)
+{
+    switch(c) {
+    case Names:      return QObject::tr("Names");
+    case FixCosts:   return QObject::tr("Costs from Files");
+    case Functions:  return QObject::tr("Functions");
+    case Calls:      return QObject::tr("Calls");
+    case PartItems:  return QObject::tr("Costs per Part");
+    case InstrLines: return QObject::tr("Instructions/Lines");
+    case Other:      return QObject::tr("Other");
+    default:
+        break;
+    }
+    return QString();
+}
+
+static QString prettyBytes(uint64 bytes)
+{
+    if (bytes < 10 * 1024)
+        return QObject::tr("%1 B").arg(bytes);
+    if (bytes < 10 * 1024 * 1024)
+        return QObject::tr("%1 KB").arg(bytes / 1024);
+    return QObject::tr("%1 MB").arg((double)bytes / (1024 * 1024), 0, 'f', 1);
+}
+
+QString MemoryUsage::toString() const
+{
+    QString s;
+    for (int i = 0; i < CategoryCount; i++) {
+        s += QStringLiteral("%1 %2")
+                 .arg(categoryName((Category)i), -20)
+                 .arg(prettyBytes(_bytes[i]), 10);
+        if (_items[i] > 0)
+            s += QStringLiteral("  (%1)").arg(_items[i]);
+        s += QLatin1Char('\n');
+    }
+    s += QStringLiteral("%1 %2\n")
+             .arg(QObject::tr("Total"), -20)
+             .arg(prettyBytes(total()), 10);
+    return s;
+}
+
+uint64 MemoryUsage::stringBytes(const QString& s)
+{
+    if (s.isNull()) return 0;
+
+    // shared header with reference count, size and capacity
+    return 3 * sizeof(void*) + (s.capacity() + 1) * sizeof(QChar);
+}
+
+uint64 MemoryUsage::mapEntryBytes(int keySize, int valueSize)
+{
+    // node with links and allocation overhead
+    return 4 * sizeof(void*) + keySize + valueSize;
+}
+
+uint64 MemoryUsage::listBytes(int count)
+{
+    return count * sizeof(void*);
+}
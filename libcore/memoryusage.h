@@ -0,0 +1,65 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Accounting of memory used by profile data
+ */
+
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <QString>
+
+#include "utils.h"
+
+/**
+ * Memory used by a TraceData, in bytes per category of data,
+ * as collected by TraceData::memoryUsage().
+ *
+ * Sizes of objects are exact, but allocation overhead of strings
+ * and Qt containers is estimated. Costs of instructions and source
+ * lines only are accounted for if already built (see
+ * TraceFunction::instrMap()).
+ */
+class MemoryUsage
+{
+public:
+    enum Category {
+        Names = 0,  // interned names of objects, files, classes, functions
+        FixCosts,   // costs as read from profile data files (FixPool)
+        Functions,  // functions with their source files, objects, files, classes
+        Calls,      // calls between functions
+        PartItems,  // costs of above items per part
+        InstrLines, // instructions and source lines with their calls and jumps
+        Other,      // parts, function cycles, lookup tables
+        CategoryCount
+    };
+
+    MemoryUsage();
+
+    void add(Category c, uint64 bytes, int items = 0);
+
+    uint64 bytes(Category c) const { return _bytes[c]; }
+    int items(Category c) const { return _items[c]; }
+    uint64 total() const;
+
+    static QString categoryName(Category);
+
+    // multi-line table with bytes and items per category
+    QString toString() const;
+
+    // estimated heap bytes of a string, of an entry in a QMap/QHash
+    // with given key and value sizes, and of a list of pointers
+    static uint64 stringBytes(const QString&);
+    static uint64 mapEntryBytes(int keySize, int valueSize);
+    static uint64 listBytes(int count);
+
+private:
+    uint64 _bytes[CategoryCount];
+    int _items[CategoryCount];
+};
+
+#endif // MEMORYUSAGE_H
@@ -0,0 +1,168 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Interned names of profile data items
+ */
+
+#include "nametable.h"
+
+#include "memoryusage.h"
+
+
+//---------------------------------------------------
+// NameTable
+
+int NameTable::id(const QString& s)
+{
+    int id = _ids.value(s, -1);
+    if (id >= 0) return id;
+
+    Entry e;
+    e.name = s;
+    // do not keep spare capacity of strings built while parsing
+    e.name.squeeze();
+    id = _entries.count();
+    _entries.append(e);
+    _ids.insert(e.name, id);
+    return id;
+}
+
+QString NameTable::intern(const QString& s)
+{
+    return name(id(s));
+}
+
+QString NameTable::name(int id) const
+{
+    if (id < 0) return QString();
+
+    return _entries.at(id).name;
+}
+
+QString NameTable::shortName(int id)
+{
+    if (id < 0) return QString();
+
+    Entry& e = _entries[id];
+    if (e.shortName.isNull())
+        e.shortName = stripPath(e.name);
+    return e.shortName;
+}
+
+QString NameTable::templateFreeName(int id)
+{
+    if (id < 0) return QString();
+
+    Entry& e = _entries[id];
+    if (e.templateFreeName.isNull())
+        e.templateFreeName = stripTemplates(e.name);
+    return e.templateFreeName;
+}
+
+QString NameTable::formattedName(int id)
+{
+    if (id < 0) return QString();
+
+    Entry& e = _entries[id];
+    if (e.formattedName.isNull())
+        e.formattedName = formatted(e.name);
+    return e.formattedName;
+}
+
+int NameTable::count() const
+{
+    return _entries.count();
+}
+
+uint64 NameTable::memorySize() const
+{
+    uint64 bytes = _entries.capacity() * sizeof(Entry) +
+                   _ids.capacity() * sizeof(void*) +
+                   _ids.count() * MemoryUsage::mapEntryBytes(sizeof(QString),
+                                                             sizeof(int));
+    for (const Entry& e : _entries) {
+        bytes += MemoryUsage::stringBytes(e.name);
+        // derived forms often share data with the name
+        if (!e.shortName.isSharedWith(e.name))
+            bytes += MemoryUsage::stringBytes(e.shortName);
+        if (!e.templateFreeName.isSharedWith(e.name))
+            bytes += MemoryUsage::stringBytes(e.templateFreeName);
+        bytes += MemoryUsage::stringBytes(e.formattedName);
+    }
+    return bytes;
+}
+
+QString NameTable::stripPath(const QString& s)
+{
+    int lastIndex = s.lastIndexOf(QLatin1Char('/')) + 1;
+    if (lastIndex == 0) return s;
+
+    return s.mid(lastIndex);
+}
+
+QString NameTable::stripTemplates(const QString& s)
+{
+    if (!s.contains(QLatin1Char('<'))) return s;
+
+    QString res;
+    res.reserve(s.length());
+    int d = 0;
+    for(int i=0;i<s.length();i++) {
+        switch(s[i].toLatin1()) {
+        case '<':
+            if (d<=0) res.append(s[i]);
+            d++;
+            break;
+        case '>':
+            d--;
+            // fall through
+        default:
+            if (d<=0) res.append(s[i]);
+            break;
+        }
+    }
+    res.squeeze();
+    return res;
+}
+
+QString NameTable::formatted(const QString& s)
+{
+    // bold, but inside template parameters normal, function arguments italic
+    QString rich(QStringLiteral("<b>"));
+    int d = 0;
+    for(int i=0;i<s.length();i++) {
+        switch(s[i].toLatin1()) {
+        case '&':
+            rich.append("&amp;");
+            break;
+        case '<':
+            d++;
+            rich.append("&lt;");
+            if (d==1)
+                rich.append("</b>");
+            break;
+        case '>':
+            d--;
+            if (d==0)
+                rich.append("<b>");
+            rich.append("&gt; "); // add space to allow for line break
+            break;
+        case '(':
+            rich.append("</b>(<i><b>");
+            break;
+        case ')':
+            rich.append("</b></i>)<b>");
+            break;
+        default:
+            rich.append(s[i]);
+            break;
+        }
+    }
+    rich.append("</b>");
+    rich.squeeze();
+    return rich;
+}
@@ -0,0 +1,72 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Interned names of profile data items
+ */
+
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "utils.h"
+
+/**
+ * Table of interned names of ELF objects, source files, classes and
+ * functions of a trace, owned by its TraceData.
+ *
+ * Each distinct name is stored once and gets an id; items with the same
+ * name share the string data, regardless of the number of parts it
+ * appears in. Derived forms of a name used for display are computed on
+ * first request and cached.
+ *
+ * Names are never removed, and are freed with the trace. As with its
+ * trace, a table is used by one thread at a time: staging traces of
+ * parallel loading have their own table, and names get interned into
+ * the table of the trace they are merged into (see
+ * TraceData::mergeStaged()).
+ */
+class NameTable
+{
+public:
+    NameTable() {}
+
+    // id of name @p s, which is added if not yet known
+    int id(const QString& s);
+    // interned copy of @p s, sharing data with all other copies
+    QString intern(const QString& s);
+    QString name(int id) const;
+
+    // name with path removed
+    QString shortName(int id);
+    // name with template parameters removed
+    QString templateFreeName(int id);
+    // rich text with template parameters in normal, arguments in italic
+    QString formattedName(int id);
+
+    int count() const;
+    // estimated bytes used by names, derived forms and lookup table
+    uint64 memorySize() const;
+
+private:
+    struct Entry {
+        QString name;
+        // null until computed
+        QString shortName, templateFreeName, formattedName;
+    };
+
+    static QString stripPath(const QString&);
+    static QString stripTemplates(const QString&);
+    static QString formatted(const QString&);
+
+    QVector<Entry> _entries;
+    QHash<QString, int> _ids;
+};
+
+#endif // NAMETABLE_H
@@ -0,0 +1,227 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Prefix sums of costs over trace parts
+ */
+
+#include "partprefixsums.h"
+
+#include <algorithm>
+
+#include <QMap>
+
+
+//---------------------------------------------------
+// PartPrefixSums
+
+PartPrefixSums::PartPrefixSums(TraceData* data)
+{
+    _data = data;
+    _parts = data->parts();
+    for (int i = 0; i < _parts.count(); i++)
+        _partIndex.insert(_parts[i], i);
+
+    EventTypeSet* types = data->eventTypes();
+    int e = types->realCount();
+    _eventCount = e;
+
+    _functions.width = 2 * e + 2;
+    _calls.width = e + 1;
+    _items.width = 2 * e;
+
+    QVector<SubCost> values(_functions.width);
+
+    TraceFunctionMap::Iterator it;
+    for ( it = data->functionMap().begin();
+          it != data->functionMap().end(); ++it ) {
+        TraceFunction* f = &(*it);
+
+        // part functions, sorted by part index
+        QMap<int, TracePartFunction*> partFunctions;
+        foreach(TraceInclusiveCost* item, f->deps()) {
+            int idx = _partIndex.value(item->part(), -1);
+            if (idx >= 0)
+                partFunctions.insert(idx, (TracePartFunction*) item);
+        }
+
+        startItem(_functions, f);
+        QMap<int, TracePartFunction*>::const_iterator pit;
+        for ( pit = partFunctions.constBegin();
+              pit != partFunctions.constEnd(); ++pit ) {
+            TracePartFunction* pf = pit.value();
+            for (int i = 0; i < e; i++) {
+                values[i] = pf->subCost(types->realType(i));
+                values[e + i] = pf->inclusive()->subCost(types->realType(i));
+            }
+            values[2 * e] = pf->calledCount();
+            values[2 * e + 1] = pf->callingCount();
+            addRow(_functions, pit.key(), values.data());
+        }
+
+        foreach(TraceCall* call, f->callings()) {
+            QMap<int, TraceCallCost*> partCalls;
+            foreach(TraceCallCost* item, call->deps()) {
+                int idx = _partIndex.value(item->part(), -1);
+                if (idx >= 0)
+                    partCalls.insert(idx, item);
+            }
+
+            startItem(_calls, call);
+            QMap<int, TraceCallCost*>::const_iterator cit;
+            for ( cit = partCalls.constBegin();
+                  cit != partCalls.constEnd(); ++cit ) {
+                for (int i = 0; i < e; i++)
+                    values[i] = cit.value()->subCost(types->realType(i));
+                values[e] = cit.value()->callCount();
+                addRow(_calls, cit.key(), values.data());
+            }
+        }
+    }
+
+    TraceObjectMap::Iterator oit;
+    for ( oit = data->objectMap().begin();
+          oit != data->objectMap().end(); ++oit )
+        addItemTable(_items, &(*oit), (*oit).deps());
+
+    TraceClassMap::Iterator cit;
+    for ( cit = data->classMap().begin();
+          cit != data->classMap().end(); ++cit )
+        addItemTable(_items, &(*cit), (*cit).deps());
+
+    TraceFileMap::Iterator fit;
+    for ( fit = data->fileMap().begin();
+          fit != data->fileMap().end(); ++fit )
+        addItemTable(_items, &(*fit), (*fit).deps());
+
+    finishTable(_functions);
+    finishTable(_calls);
+    finishTable(_items);
+
+    if (0) qDebug("PartPrefixSums: %d parts, %d/%d/%d rows",
+                  (int)_parts.count(), (int)_functions.rowPart.count(),
+                  (int)_calls.rowPart.count(), (int)_items.rowPart.count());
+}
+
+bool PartPrefixSums::isValid() const
+{
+    return (_parts == _data->parts()) &&
+            (_eventCount == _data->eventTypes()->realCount());
+}
+
+void PartPrefixSums::startItem(Table& t, ProfileCostArray* item)
+{
+    t.items.append(item);
+    t.firstRow.append(t.rowPart.count());
+}
+
+void PartPrefixSums::addRow(Table& t, int part, const SubCost* values)
+{
+    int row = t.rowPart.count();
+    bool firstOfItem = (row == t.firstRow.last());
+
+    t.rowPart.append(part);
+    for (int i = 0; i < t.width; i++) {
+        SubCost v = values[i];
+        if (!firstOfItem)
+            v += t.sums[qsizetype(row - 1) * t.width + i];
+        t.sums.append(v);
+    }
+}
+
+void PartPrefixSums::finishTable(Table& t)
+{
+    t.firstRow.append(t.rowPart.count());
+
+    t.items.squeeze();
+    t.firstRow.squeeze();
+    t.rowPart.squeeze();
+    t.sums.squeeze();
+}
+
+void PartPrefixSums::addItemTable(Table& t, ProfileCostArray* item,
+                                  const TraceInclusiveCostList& deps)
+{
+    EventTypeSet* types = _data->eventTypes();
+    int e = _eventCount;
+
+    QMap<int, TraceInclusiveCost*> partItems;
+    foreach(TraceInclusiveCost* dep, deps) {
+        int idx = _partIndex.value(dep->part(), -1);
+        if (idx >= 0)
+            partItems.insert(idx, dep);
+    }
+
+    QVector<SubCost> values(t.width);
+    startItem(t, item);
+    QMap<int, TraceInclusiveCost*>::const_iterator it;
+    for ( it = partItems.constBegin(); it != partItems.constEnd(); ++it ) {
+        for (int i = 0; i < e; i++) {
+            values[i] = it.value()->subCost(types->realType(i));
+            values[e + i] = it.value()->inclusive()->subCost(types->realType(i));
+        }
+        addRow(t, it.key(), values.data());
+    }
+}
+
+void PartPrefixSums::rangeSum(const Table& t, int i, int first, int last,
+                              SubCost* values) const
+{
+    const int* rows = t.rowPart.constData();
+    const int* begin = rows + t.firstRow[i];
+    const int* end = rows + t.firstRow[i + 1];
+
+    // last row of item with part <= last, and before first
+    int hi = int(std::upper_bound(begin, end, last) - rows) - 1;
+    int lo = int(std::lower_bound(begin, end, first) - rows) - 1;
+
+    const SubCost* sums = t.sums.constData();
+    for (int v = 0; v < t.width; v++) {
+        values[v] = 0;
+        if (hi < t.firstRow[i]) continue;
+
+        values[v] = sums[qsizetype(hi) * t.width + v];
+        if (lo >= t.firstRow[i])
+            values[v] -= sums[qsizetype(lo) * t.width + v];
+    }
+}
+
+void PartPrefixSums::apply(int first, int last)
+{
+    int e = _eventCount;
+    QVector<SubCost> values(_functions.width);
+
+    for (int i = 0; i < _functions.items.count(); i++) {
+        TraceFunction* f = (TraceFunction*) _functions.items[i];
+
+        // costs below function level are recalculated on demand
+        f->invalidateDynamicCost();
+
+        rangeSum(_functions, i, first, last, values.data());
+        f->setCost(values.data(), e);
+        f->setInclusive(values.data() + e, e);
+        f->setCallCounts(values[2 * e], values[2 * e + 1]);
+    }
+
+    for (int i = 0; i < _calls.items.count(); i++) {
+        TraceCall* call = (TraceCall*) _calls.items[i];
+
+        rangeSum(_calls, i, first, last, values.data());
+        call->setCost(values.data(), e);
+        call->setCallCount(values[e]);
+    }
+
+    for (int i = 0; i < _items.items.count(); i++) {
+        TraceInclusiveCost* item = (TraceInclusiveCost*) _items.items[i];
+
+        rangeSum(_items, i, first, last, values.data());
+        item->setCost(values.data(), e);
+        item->setInclusive(values.data() + e, e);
+    }
+
+    // totals are summed up from parts
+    _data->invalidate();
+}
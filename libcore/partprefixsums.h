@@ -0,0 +1,76 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Prefix sums of costs over trace parts
+ */
+
+#ifndef PARTPREFIXSUMS_H
+#define PARTPREFIXSUMS_H
+
+#include <QVector>
+
+#include "tracedata.h"
+
+/**
+ * Accumulated costs of functions, calls, objects, classes and files
+ * over the parts of a TraceData, in the order of TraceData::parts().
+ * With these, the costs for any contiguous range of parts (e.g. a
+ * timeframe selected in the part overview) are set in O(items),
+ * without touching the part cost items.
+ *
+ * Sums are stored sparse: per cost item, there only is a row for each
+ * part the item has cost in, holding the sum over this and all previous
+ * parts. The rows of a range are found by binary search.
+ */
+class PartPrefixSums
+{
+public:
+    explicit PartPrefixSums(TraceData*);
+
+    // are these sums up-to-date for the parts of the TraceData?
+    bool isValid() const;
+
+    /**
+     * Set the costs of all functions, calls, objects, classes and files
+     * to the sum over the parts with index first to last.
+     * The costs do not account for function cycles.
+     */
+    void apply(int first, int last);
+
+private:
+    // sums for a set of cost items with same number of values per row
+    struct Table {
+        int width;
+        QVector<ProfileCostArray*> items;
+        QVector<int> firstRow; // rows of item i: [firstRow[i];firstRow[i+1][
+        QVector<int> rowPart;  // part index of a row
+        QVector<SubCost> sums; // <width> values per row
+    };
+
+    void startItem(Table& t, ProfileCostArray* item);
+    void addRow(Table& t, int part, const SubCost* values);
+    void finishTable(Table& t);
+    // get sum for range of parts for item i into <values>
+    void rangeSum(const Table& t, int i, int first, int last,
+                  SubCost* values) const;
+    void addItemTable(Table& t, ProfileCostArray* item,
+                      const TraceInclusiveCostList& deps);
+
+    TraceData* _data;
+    TracePartList _parts;
+    QHash<TracePart*, int> _partIndex;
+    int _eventCount;
+
+    // functions: exclusive, inclusive, called count, calling count
+    Table _functions;
+    // calls: exclusive, call count
+    Table _calls;
+    // objects, classes and files: exclusive, inclusive
+    Table _items;
+};
+
+#endif // PARTPREFIXSUMS_H
@@ -10,88 +10,222 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <atomic>
 #include <qglobal.h>
+#include <QThread>
+
+#if defined(Q_OS_LINUX)
+#include <sys/mman.h>
+#endif
 
 // FixPool
 
+// chunk sizes grow from FIXPOOL_MINCHUNK to FIXPOOL_MAXCHUNK per arena,
+// so that small pools (e.g. for small staging data) stay small
+#define FIXPOOL_MINCHUNK (64*1024)
+#define FIXPOOL_MAXCHUNK (2*1024*1024)
+
+// for DynPool
 #define CHUNK_SIZE 100000
 
 struct SpaceChunk
 {
     struct SpaceChunk* next;
+    unsigned int size; // usable space
     unsigned int used;
     char space[1];
 };
 
+struct FixPool::Arena
+{
+    struct SpaceChunk *first, *last;
+    unsigned int reservation;
+    unsigned int nextChunkSize;
+    int count;
+    unsigned long long size;
+};
+
+static std::atomic<unsigned long long> fixPoolIds(0);
+static std::atomic<bool> fixPoolHugePages(false);
+
+thread_local unsigned long long FixPool::_lastPoolId = 0;
+thread_local FixPool::Arena* FixPool::_lastArena = nullptr;
+
 FixPool::FixPool()
 {
-    _first = _last = nullptr;
-    _reservation = 0;
-    _count = 0;
-    _size = 0;
+    _id = ++fixPoolIds;
 }
 
 FixPool::~FixPool()
 {
-    struct SpaceChunk* chunk = _first, *next;
-
-    while(chunk) {
-        next = chunk->next;
-        free(chunk);
-        chunk = next;
+    if (0) {
+        Statistics s = statistics();
+        qDebug("~FixPool: Had %d objects with total size %llu\n",
+               s.objects, s.used);
     }
 
-    if (0) qDebug("~FixPool: Had %d objects with total size %d\n",
-                  _count, _size);
+    release();
+}
+
+void FixPool::setUseHugePages(bool b)
+{
+    fixPoolHugePages = b;
+}
+
+FixPool::Arena* FixPool::arena()
+{
+    if (_lastPoolId == _id) return _lastArena;
+
+    QMutexLocker locker(&_mutex);
+    void* thread = QThread::currentThreadId();
+    Arena* a = _threadArenas.value(thread, nullptr);
+    if (!a) {
+        a = new Arena;
+        a->first = a->last = nullptr;
+        a->reservation = 0;
+        a->nextChunkSize = FIXPOOL_MINCHUNK;
+        a->count = 0;
+        a->size = 0;
+        _arenas.append(a);
+        _threadArenas.insert(thread, a);
+    }
+    _lastPoolId = _id;
+    _lastArena = a;
+    return a;
 }
 
 void* FixPool::allocate(unsigned int size)
 {
-    if (!ensureSpace(size)) return nullptr;
+    Arena* a = arena();
+    if (!ensureSpace(a, size)) return nullptr;
 
-    _reservation = 0;
-    void* result = _last->space + _last->used;
-    _last->used += size;
+    a->reservation = 0;
+    void* result = a->last->space + a->last->used;
+    a->last->used += size;
 
-    _count++;
-    _size += size;
+    a->count++;
+    a->size += size;
 
     return result;
 }
 
 void* FixPool::reserve(unsigned int size)
 {
-    if (!ensureSpace(size)) return nullptr;
-    _reservation = size;
+    Arena* a = arena();
+    if (!ensureSpace(a, size)) return nullptr;
+    a->reservation = size;
 
-    return _last->space + _last->used;
+    return a->last->space + a->last->used;
 }
 
 
 bool FixPool::allocateReserved(unsigned int size)
 {
-    if (_reservation < size) return false;
+    Arena* a = arena();
+    if (a->reservation < size) return false;
 
-    _reservation = 0;
-    _last->used += size;
+    a->reservation = 0;
+    a->last->used += size;
 
-    _count++;
-    _size += size;
+    a->count++;
+    a->size += size;
 
     return true;
 }
 
-bool FixPool::ensureSpace(unsigned int size)
+void FixPool::adopt(FixPool* other)
 {
-    if (_last && _last->used + size <= CHUNK_SIZE) return true;
+    if (!other || (other == this)) return;
+
+    QList<Arena*> arenas;
+    {
+        QMutexLocker locker(&other->_mutex);
+        arenas = other->_arenas;
+        other->_arenas.clear();
+        other->_threadArenas.clear();
+        // force lookup in threads which used <other> before
+        other->_id = ++fixPoolIds;
+    }
+
+    // adopted arenas are not used for allocation any more
+    QMutexLocker locker(&_mutex);
+    _arenas.append(arenas);
+}
+
+void FixPool::release()
+{
+    QMutexLocker locker(&_mutex);
+
+    foreach(Arena* a, _arenas) {
+        struct SpaceChunk* chunk = a->first, *next;
+        while(chunk) {
+            next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+        delete a;
+    }
+    _arenas.clear();
+    _threadArenas.clear();
+    _id = ++fixPoolIds;
+}
 
-    struct SpaceChunk* newChunk;
+FixPool::Statistics FixPool::statistics()
+{
+    QMutexLocker locker(&_mutex);
+
+    Statistics s;
+    s.arenas = _arenas.count();
+    s.chunks = 0;
+    s.objects = 0;
+    s.capacity = 0;
+    s.used = 0;
+    s.waste = 0;
+    foreach(Arena* a, _arenas) {
+        s.objects += a->count;
+        s.used += a->size;
+        for(struct SpaceChunk* chunk = a->first; chunk; chunk = chunk->next) {
+            s.chunks++;
+            s.capacity += chunk->size;
+            if (chunk != a->last)
+                s.waste += chunk->size - chunk->used;
+        }
+    }
+    return s;
+}
 
-    // we do not allow allocation sizes > CHUNK_SIZE
-    if (size > CHUNK_SIZE) return false;
+bool FixPool::ensureSpace(Arena* a, unsigned int size)
+{
+    if (a->last && a->last->used + size <= a->last->size) return true;
+
+    unsigned int header = offsetof(struct SpaceChunk, space);
+
+    // we do not allow allocation sizes > maximal chunk size
+    if (size > FIXPOOL_MAXCHUNK - header) return false;
+
+    unsigned int chunkSize = a->nextChunkSize;
+    while (chunkSize - header < size)
+        chunkSize *= 2;
+    if (chunkSize < FIXPOOL_MAXCHUNK)
+        a->nextChunkSize = chunkSize * 2;
+
+    void* mem = nullptr;
+#if defined(Q_OS_LINUX)
+    // big chunks are aligned to allow for backing by huge pages
+    if (chunkSize == FIXPOOL_MAXCHUNK) {
+        if (posix_memalign(&mem, FIXPOOL_MAXCHUNK, chunkSize) != 0)
+            mem = nullptr;
+#ifdef MADV_HUGEPAGE
+        if (mem && fixPoolHugePages)
+            madvise(mem, chunkSize, MADV_HUGEPAGE);
+#endif
+    }
+    else
+#endif
+        mem = malloc(chunkSize);
 
-    newChunk = (struct SpaceChunk*) malloc(sizeof(struct SpaceChunk) +
-                                           CHUNK_SIZE);
+    struct SpaceChunk* newChunk = (struct SpaceChunk*) mem;
     if (!newChunk) {
         qFatal("ERROR: Out of memory. Sorry. KCachegrind has to terminate.\n\n"
                "You probably tried to load a profile data file too huge for"
@@ -99,14 +233,15 @@ bool FixPool::ensureSpace(unsigned int size)
         exit(1);
     }
     newChunk->next = nullptr;
+    newChunk->size = chunkSize - header;
     newChunk->used = 0;
 
-    if (!_last) {
-        _last = _first = newChunk;
+    if (!a->last) {
+        a->last = a->first = newChunk;
     }
     else {
-        _last->next = newChunk;
-        _last = newChunk;
+        a->last->next = newChunk;
+        a->last = newChunk;
     }
     return true;
 }
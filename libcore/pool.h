@@ -9,6 +9,10 @@
 #ifndef POOL_H
 #define POOL_H
 
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
 /**
  * Pool objects: containers for many small objects.
  */
@@ -20,10 +24,24 @@ struct SpaceChunk;
  *
  * For objects with fixed size and life time
  * ending with that of the pool.
+ *
+ * Multiple threads can allocate from the same pool without contention:
+ * each thread gets its own arena of chunks. Chunks grow up to 2 MB,
+ * which are aligned for transparent huge pages.
  */
 class FixPool
 {
 public:
+    // memory statistics, see statistics()
+    struct Statistics {
+        int arenas;
+        int chunks;
+        int objects;
+        unsigned long long capacity; // bytes in chunks
+        unsigned long long used;     // bytes handed out
+        unsigned long long waste;    // unused bytes at end of full chunks
+    };
+
     FixPool();
     ~FixPool();
 
@@ -37,6 +55,7 @@ public:
      * Reserve space. If you call allocateReservedSpace(realsize)
      * with realSize < reserved size directly after, you
      * will get the same memory area.
+     * Reservations are per thread.
      */
     void* reserve(unsigned int size);
 
@@ -47,15 +66,47 @@ public:
      */
     bool allocateReserved(unsigned int size);
 
+    /**
+     * Take over all space allocated from @p other, which is
+     * empty afterwards. Objects allocated from @p other stay valid
+     * until this pool is deleted.
+     * No thread may allocate from @p other at the same time.
+     */
+    void adopt(FixPool* other);
+
+    /**
+     * Free all space at once. All objects allocated from this pool
+     * become invalid.
+     */
+    void release();
+
+    Statistics statistics();
+
+    /**
+     * Advise the kernel to back big chunks with huge pages
+     * (madvise, where supported). Default is off.
+     */
+    static void setUseHugePages(bool);
+
 private:
-    /* Checks that there is enough space in the last chunk.
+    struct Arena;
+
+    // arena of the calling thread, created on demand
+    Arena* arena();
+    /* Checks that there is enough space in the last chunk of @p a.
      * Returns false if this is not possible.
      */
-    bool ensureSpace(unsigned int);
+    bool ensureSpace(Arena* a, unsigned int);
+
+    // unique id, as a pool may get the address of a deleted one
+    unsigned long long _id;
+    QMutex _mutex;
+    QList<Arena*> _arenas;
+    QHash<void*, Arena*> _threadArenas;
 
-    struct SpaceChunk *_first, *_last;
-    unsigned int _reservation;
-    int _count, _size;
+    // last pool/arena used by a thread, to avoid locking
+    static thread_local unsigned long long _lastPoolId;
+    static thread_local Arena* _lastArena;
 };
 
 /**
@@ -58,6 +58,9 @@ public:
     uint64 v;
 };
 
+// allows parsing into arrays of SubCost via FixString::stripUInt64s()
+static_assert(sizeof(SubCost) == sizeof(uint64), "SubCost must wrap uint64");
+
 class ProfileCostArray;
 class EventType;
 typedef QList<ProfileCostArray*> TraceCostList;
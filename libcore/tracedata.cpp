@@ -16,10 +16,15 @@
 #include <memory>
 #include <algorithm>
 #include <numeric>
+#include <functional>
 
 #include <QFile>
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
 #include <QDebug>
 
 #include "logger.h"
@@ -27,6 +32,20 @@
 #include "globalconfig.h"
 #include "utils.h"
 #include "fixcost.h"
+#include "partprefixsums.h"
+#include "nametable.h"
+#include "callgraph.h"
+
+
+// memory of per-part cost items in dependency list <l>, each of size <size>
+template<class List>
+static void addPartItemMemory(MemoryUsage& m, const List& l, int size)
+{
+    uint64 bytes = MemoryUsage::listBytes(l.count());
+    foreach(ProfileCostArray* c, l)
+        bytes += size + c->costMemory();
+    m.add(MemoryUsage::PartItems, bytes, l.count());
+}
 
 
 #define TRACE_DEBUG      0
@@ -131,6 +150,19 @@ void TraceCallCost::addCallCount(SubCost c)
     invalidate();
 }
 
+bool TraceCallCost::applyDelta(ProfileCostArray* item, bool subtract)
+{
+    if (!ProfileCostArray::applyDelta(item, subtract)) return false;
+
+    SubCost c = ((TraceCallCost*)item)->callCount();
+    if (subtract)
+        _callCount -= c;
+    else
+        _callCount += c;
+
+    return true;
+}
+
 
 //---------------------------------------------------
 // TraceInclusiveCost
@@ -169,6 +201,19 @@ void TraceInclusiveCost::addInclusive(ProfileCostArray* c)
     invalidate();
 }
 
+bool TraceInclusiveCost::applyDelta(ProfileCostArray* item, bool subtract)
+{
+    if (!ProfileCostArray::applyDelta(item, subtract)) return false;
+
+    ProfileCostArray* c = ((TraceInclusiveCost*)item)->inclusive();
+    if (subtract)
+        _inclusive.subtractCost(c);
+    else
+        _inclusive.addCost(c);
+
+    return true;
+}
+
 
 //---------------------------------------------------
 // TraceListCost
@@ -625,6 +670,7 @@ TracePartFunction::TracePartFunction(TraceFunction* function,
 
     _firstFixCost = nullptr;
     _firstFixJump = nullptr;
+    _firstFixInstrRange = nullptr;
 }
 
 TracePartFunction::~TracePartFunction()
@@ -941,6 +987,14 @@ TraceInstrJump::~TraceInstrJump()
     }
 }
 
+int TraceInstrJump::partInstrJumpCount() const
+{
+    int count = 0;
+    for(TracePartInstrJump* item = _first; item; item = item->next())
+        count++;
+    return count;
+}
+
 TracePartInstrJump* TraceInstrJump::partInstrJump(TracePart* part)
 {
     static TracePartInstrJump* item = nullptr;
@@ -1186,6 +1240,19 @@ void TraceCall::invalidateDynamicCost()
     invalidate();
 }
 
+void TraceCall::updatePartActivation(TracePartCall* pc)
+{
+    if (!applyDelta(pc, !pc->part()->isActive()))
+        invalidate();
+
+    // line/instruction calls are recalculated on demand
+    foreach(TraceLineCall* lc, _lineCalls)
+        lc->invalidate();
+
+    foreach(TraceInstrCall* ic, _instrCalls)
+        ic->invalidate();
+}
+
 
 QString TraceCall::name() const
 {
@@ -1489,6 +1556,14 @@ QString TraceLine::prettyName() const
 TraceCostItem::TraceCostItem(ProfileContext* context)
     : TraceInclusiveListCost(context)
 {
+    _nameId = -1;
+}
+
+void TraceCostItem::setName(const QString& name)
+{
+    NameTable* names = data()->nameTable();
+    _nameId = names->id(name);
+    _name = names->name(_nameId);
 }
 
 TraceCostItem::~TraceCostItem()
@@ -1560,9 +1635,7 @@ TraceLine* TraceFunctionSource::line(uint lineno, bool createNew)
 
     if (!createNew) {
         if (!_lineMap) return nullptr;
-        TraceLineMap::Iterator it = _lineMap->find(lineno);
-        if (it == _lineMap->end()) return nullptr;
-        return &(it.value());
+        return _lineMap->item(lineno);
     }
 
     if (!_lineMap) _lineMap = new TraceLineMap;
@@ -1610,6 +1683,41 @@ void TraceFunctionSource::invalidateDynamicCost()
     invalidate();
 }
 
+void TraceFunctionSource::addMemoryUsage(MemoryUsage& m)
+{
+    m.add(MemoryUsage::Functions, sizeof(TraceFunctionSource) + costMemory());
+
+    TraceLineList lines;
+    if (_lineMap) {
+        m.add(MemoryUsage::InstrLines,
+              _lineMap->memorySize() - _lineMap->count() * sizeof(TraceLine));
+        TraceLineMap::Iterator lit;
+        for ( lit = _lineMap->begin();
+              lit != _lineMap->end(); ++lit )
+            lines.append( &(*lit) );
+    }
+    if (_line0)
+        lines.append(_line0);
+
+    foreach(TraceLine* l, lines) {
+        m.add(MemoryUsage::InstrLines, sizeof(TraceLine) + l->costMemory() +
+              MemoryUsage::listBytes(l->lineCalls().count()), 1);
+        addPartItemMemory(m, l->deps(), sizeof(TracePartLine));
+
+        foreach(TraceLineJump* lj, l->lineJumps()) {
+            m.add(MemoryUsage::InstrLines,
+                  sizeof(TraceLineJump) + MemoryUsage::listBytes(1));
+            int parts = lj->deps().count();
+            m.add(MemoryUsage::PartItems,
+                  parts * (sizeof(TracePartLineJump) + sizeof(void*)), parts);
+        }
+    }
+
+    if (_regions)
+        m.add(MemoryUsage::Other, MemoryUsage::listBytes(_regions->count()) +
+              _regions->count() * sizeof(TraceLineRegion));
+}
+
 TraceLineMap* TraceFunctionSource::lineMap()
 {
 #if USE_FIXCOST
@@ -1798,9 +1906,14 @@ TraceFunction::TraceFunction()
     _callingCount    = 0;
     _calledContexts  = 0;
     _callingContexts = 0;
+    _contextsDirty = false;
 
     _instrMap = nullptr;
     _instrMapFilled = false;
+    _graphId = -1;
+
+    _callingIndex = nullptr;
+    _sourceFileIndex = nullptr;
 }
 
 
@@ -1814,6 +1927,8 @@ TraceFunction::~TraceFunction()
     qDeleteAll(_sourceFiles);
     qDeleteAll(_basicBlocks);
 
+    delete _callingIndex;
+    delete _sourceFileIndex;
     delete _instrMap;
 }
 
@@ -1889,25 +2004,8 @@ QString TraceFunction::prettyName() const
     if (_name.isEmpty())
         return prettyEmptyName();
 
-    if (GlobalConfig::hideTemplates()) {
-
-        res = QString();
-        int d = 0;
-        for(int i=0;i<_name.length();i++) {
-            switch(_name[i].toLatin1()) {
-            case '<':
-                if (d<=0) res.append(_name[i]);
-                d++;
-                break;
-            case '>':
-                d--;
-                // fall through
-            default:
-                if (d<=0) res.append(_name[i]);
-                break;
-            }
-        }
-    }
+    if (GlobalConfig::hideTemplates())
+        res = data()->nameTable()->templateFreeName(_nameId);
 #if 0
     // TODO: make it a configuration, but disabled by default.
     //
@@ -1944,39 +2042,7 @@ QString TraceFunction::formattedName() const
     // produce a "rich" name only if templates are hidden
     if (!GlobalConfig::hideTemplates() || _name.isEmpty()) return QString();
 
-    // bold, but inside template parameters normal, function arguments italic
-    QString rich(QStringLiteral("<b>"));
-    int d = 0;
-    for(int i=0;i<_name.length();i++) {
-        switch(_name[i].toLatin1()) {
-        case '&':
-            rich.append("&amp;");
-            break;
-        case '<':
-            d++;
-            rich.append("&lt;");
-            if (d==1)
-                rich.append("</b>");
-            break;
-        case '>':
-            d--;
-            if (d==0)
-                rich.append("<b>");
-            rich.append("&gt; "); // add space to allow for line break
-            break;
-        case '(':
-            rich.append("</b>(<i><b>");
-            break;
-        case ')':
-            rich.append("</b></i>)<b>");
-            break;
-        default:
-            rich.append(_name[i]);
-            break;
-        }
-    }
-    rich.append("</b>");
-    return rich;
+    return data()->nameTable()->formattedName(_nameId);
 }
 
 QString TraceFunction::prettyEmptyName()
@@ -2100,10 +2166,7 @@ TraceInstr* TraceFunction::instr(Addr addr, bool createNew)
 
     if (!createNew) {
         if (!_instrMap) return nullptr;
-        TraceInstrMap::Iterator it = _instrMap->find(addr);
-        if (it == _instrMap->end())
-            return nullptr;
-        return &(it.value());
+        return _instrMap->item(addr);
     }
 
     if (!_instrMap) _instrMap = new TraceInstrMap;
@@ -2143,15 +2206,37 @@ void TraceFunction::addCaller(TraceCall* caller)
 
 
 
+// Number of callees/source files of a function from which on lookups
+// use a hash index. Most functions have only a few, where a linear
+// search is fast enough and an index only would cost memory.
+#define FUNCTION_INDEX_THRESHOLD 16
+
 TraceCall* TraceFunction::calling(TraceFunction* called)
 {
-    foreach(TraceCall* calling, _callings)
-        if (calling->called() == called)
-            return calling;
+    TraceCall* calling = nullptr;
+    if (_callingIndex)
+        calling = _callingIndex->value(called, nullptr);
+    else {
+        foreach(TraceCall* c, _callings)
+            if (c->called() == called) {
+                calling = c;
+                break;
+            }
+    }
+    if (calling) return calling;
 
-    TraceCall* calling = new TraceCall(this, called);
+    calling = new TraceCall(this, called);
     _callings.append(calling);
 
+    // hub functions can have thousands of callees: avoid linear search
+    if (_callingIndex)
+        _callingIndex->insert(called, calling);
+    else if (_callings.count() > FUNCTION_INDEX_THRESHOLD) {
+        _callingIndex = new QHash<TraceFunction*, TraceCall*>;
+        foreach(TraceCall* c, _callings)
+            _callingIndex->insert(c->called(), c);
+    }
+
     // we have to invalidate ourself so invalidations from item propagate up
     invalidate();
 
@@ -2167,15 +2252,29 @@ TraceFunctionSource* TraceFunction::sourceFile(TraceFile* file,
 {
     if (!file) file = _file;
 
-    foreach(TraceFunctionSource* sourceFile, _sourceFiles)
-        if (sourceFile->file() == file)
-            return sourceFile;
-
-    if (!createNew) return nullptr;
+    TraceFunctionSource* sourceFile = nullptr;
+    if (_sourceFileIndex)
+        sourceFile = _sourceFileIndex->value(file, nullptr);
+    else {
+        foreach(TraceFunctionSource* sf, _sourceFiles)
+            if (sf->file() == file) {
+                sourceFile = sf;
+                break;
+            }
+    }
+    if (sourceFile || !createNew) return sourceFile;
 
-    TraceFunctionSource* sourceFile = new TraceFunctionSource(this, file);
+    sourceFile = new TraceFunctionSource(this, file);
     _sourceFiles.append(sourceFile);
 
+    if (_sourceFileIndex)
+        _sourceFileIndex->insert(file, sourceFile);
+    else if (_sourceFiles.count() > FUNCTION_INDEX_THRESHOLD) {
+        _sourceFileIndex = new QHash<TraceFile*, TraceFunctionSource*>;
+        foreach(TraceFunctionSource* sf, _sourceFiles)
+            _sourceFileIndex->insert(sf->file(), sf);
+    }
+
     // we have to invalidate ourself so invalidations from item propagate up
     invalidate();
 
@@ -2242,6 +2341,7 @@ SubCost TraceFunction::calledCount()
 int TraceFunction::calledContexts()
 {
     if (_dirty) update();
+    if (_contextsDirty) updateContexts();
 
     return _calledContexts;
 }
@@ -2256,10 +2356,18 @@ SubCost TraceFunction::callingCount()
 int TraceFunction::callingContexts()
 {
     if (_dirty) update();
+    if (_contextsDirty) updateContexts();
 
     return _callingContexts;
 }
 
+void TraceFunction::setCallCounts(SubCost called, SubCost calling)
+{
+    _calledCount  = called;
+    _callingCount = calling;
+    _contextsDirty = true;
+}
+
 QString TraceFunction::prettyCalledCount()
 {
     return _calledCount.pretty();
@@ -2318,6 +2426,65 @@ void TraceFunction::invalidateDynamicCost()
     invalidate();
 }
 
+void TraceFunction::addMemoryUsage(MemoryUsage& m)
+{
+    m.add(MemoryUsage::Functions, costMemory() +
+          MemoryUsage::listBytes(_callers.count() + _callings.count() +
+                                 _sourceFiles.count() + _associations.count()) +
+          MemoryUsage::mapEntryBytes(sizeof(void*), sizeof(void*)) *
+          ((_callingIndex ? _callingIndex->count() : 0) +
+           (_sourceFileIndex ? _sourceFileIndex->count() : 0)), 1);
+    addPartItemMemory(m, deps(), sizeof(TracePartFunction));
+
+    foreach(TraceCall* c, _callings) {
+        m.add(MemoryUsage::Calls, sizeof(TraceCall) + c->costMemory() +
+              MemoryUsage::listBytes(c->lineCalls().count() +
+                                     c->instrCalls().count()), 1);
+        addPartItemMemory(m, c->deps(), sizeof(TracePartCall));
+
+        foreach(TraceLineCall* lc, c->lineCalls()) {
+            m.add(MemoryUsage::InstrLines,
+                  sizeof(TraceLineCall) + lc->costMemory());
+            addPartItemMemory(m, lc->deps(), sizeof(TracePartLineCall));
+        }
+        foreach(TraceInstrCall* ic, c->instrCalls()) {
+            m.add(MemoryUsage::InstrLines,
+                  sizeof(TraceInstrCall) + ic->costMemory());
+            addPartItemMemory(m, ic->deps(), sizeof(TracePartInstrCall));
+        }
+    }
+
+    foreach(TraceFunctionSource* sf, _sourceFiles)
+        sf->addMemoryUsage(m);
+
+    if (_instrMap) {
+        m.add(MemoryUsage::InstrLines,
+              _instrMap->memorySize() - _instrMap->count() * sizeof(TraceInstr));
+        TraceInstrMap::Iterator iit;
+        for ( iit = _instrMap->begin();
+              iit != _instrMap->end(); ++iit ) {
+            TraceInstr& i = *iit;
+            m.add(MemoryUsage::InstrLines, sizeof(TraceInstr) + i.costMemory() +
+                  MemoryUsage::listBytes(i.instrJumps().count() +
+                                         i.instrCalls().count()), 1);
+            addPartItemMemory(m, i.deps(), sizeof(TracePartInstr));
+
+            foreach(TraceInstrJump* ij, i.instrJumps()) {
+                m.add(MemoryUsage::InstrLines, sizeof(TraceInstrJump));
+                int parts = ij->partInstrJumpCount();
+                m.add(MemoryUsage::PartItems,
+                      parts * sizeof(TracePartInstrJump), parts);
+            }
+        }
+    }
+
+    foreach(TraceBasicBlock* bb, _basicBlocks)
+        m.add(MemoryUsage::InstrLines, sizeof(TraceBasicBlock) +
+              bb->costMemory() + bb->instrNumber() * sizeof(TraceInstr*) +
+              bb->outgoingBranches().capacity() * sizeof(TraceBranch) +
+              bb->incomingBranches().capacity() * sizeof(TraceBranch*));
+}
+
 void TraceFunction::update()
 {
     if (!_dirty) return;
@@ -2330,25 +2497,15 @@ void TraceFunction::update()
 
     _calledCount    = 0;
     _callingCount    = 0;
-    _calledContexts  = 0;
-    _callingContexts = 0;
     clear();
 
-    // To calculate context counts, we just use first real event type (FIXME?)
-    EventType* e = data() ? data()->eventTypes()->realType(0) : nullptr;
-
-    // context count is NOT the sum of part contexts
-    foreach(TraceCall *caller, _callers) {
-        if (e && (caller->subCost(e) >0))
-            _calledContexts++;
+    foreach(TraceCall *caller, _callers)
         _calledCount += caller->callCount();
-    }
 
-    foreach(TraceCall* callee, _callings) {
-        if (e && (callee->subCost(e) >0))
-            _callingContexts++;
+    foreach(TraceCall* callee, _callings)
         _callingCount += callee->callCount();
-    }
+
+    updateContexts();
 
     if (data()->inFunctionCycleUpdate() || !_cycle) {
         // usual case (no cycle member)
@@ -2395,124 +2552,87 @@ void TraceFunction::update()
 #endif
 }
 
-bool TraceFunction::isCycle()
+void TraceFunction::updateContexts()
 {
-    return _cycle == this;
-}
+    _calledContexts  = 0;
+    _callingContexts = 0;
 
-bool TraceFunction::isCycleMember()
-{
-    return _cycle && (_cycle != this);
-}
+    // To calculate context counts, we just use first real event type (FIXME?)
+    EventType* e = data() ? data()->eventTypes()->realType(0) : nullptr;
 
-void TraceFunction::cycleReset()
-{
-    _cycle = nullptr;
-    _cycleStackDown = nullptr;
-    _cycleLow = 0;
+    // context count is NOT the sum of part contexts
+    if (e) {
+        foreach(TraceCall *caller, _callers)
+            if (caller->subCost(e) >0)
+                _calledContexts++;
+
+        foreach(TraceCall* callee, _callings)
+            if (callee->subCost(e) >0)
+                _callingContexts++;
+    }
+
+    _contextsDirty = false;
 }
 
-// this does not mark functions calling themself !
-void TraceFunction::cycleDFS(int d, int& pNo, TraceFunction** pTop)
+bool TraceFunction::applyDelta(ProfileCostArray* item, bool subtract)
 {
-    if (_cycleLow != 0) return;
-
-    // initialize with prefix order
-    pNo++;
-    int prefixNo = pNo;
-    _cycleLow = prefixNo;
-
-    // put myself on stack
-    _cycleStackDown = *pTop;
-    *pTop = this;
-
-    /* cycle cut heuristic:
-     * skip calls for cycle detection if they make less than _cycleCut
-     * percent of the cost of the function.
-     * FIXME: Which cost type to use for this heuristic ?!
-     */
-    Q_ASSERT((data() != nullptr) && (data()->eventTypes()->realCount()>0));
-    EventType* e = data()->eventTypes()->realType(0);
+    // inclusive cost of cycles and their members is not a sum of parts
+    if (_cycle) return false;
+    if (!TraceCostItem::applyDelta(item, subtract)) return false;
 
-    SubCost base = 0;
-    if (_callers.count()>0) {
-        foreach(TraceCall* caller, _callers)
-            if (caller->subCost(e) > base)
-                base = caller->subCost(e);
+    TracePartFunction* pf = (TracePartFunction*) item;
+    if (subtract) {
+        _calledCount  -= pf->calledCount();
+        _callingCount -= pf->callingCount();
     }
-    else base = inclusive()->subCost(e);
-
-    SubCost cutLimit = SubCost(base * GlobalConfig::cycleCut());
-
-    if (0) {
-        qDebug("%s (%d) Visiting %s",
-               qPrintable(QString().fill(' ', d)),
-               pNo, qPrintable(prettyName()));
-        qDebug("%s       Cum. %s, Max Caller %s, cut limit %s",
-               qPrintable(QString().fill(' ', d)),
-               qPrintable(inclusive()->subCost(e).pretty()),
-               qPrintable(base.pretty()),
-               qPrintable(cutLimit.pretty()));
+    else {
+        _calledCount  += pf->calledCount();
+        _callingCount += pf->callingCount();
     }
+    _contextsDirty = true;
 
-    foreach(TraceCall *callee, _callings) {
-        TraceFunction* called = callee->called();
+    return true;
+}
 
-        // cycle cut heuristic
-        if (callee->subCost(e) < cutLimit) {
-            if (0) qDebug("%s       Cut call to %s (cum. %s)",
-                          qPrintable(QString().fill(' ', d)),
-                          qPrintable(called->prettyName()),
-                          qPrintable(callee->subCost(e).pretty()));
+void TraceFunction::updatePartActivation(TracePartFunction* pf)
+{
+    bool upToDate = applyDelta(pf, !pf->part()->isActive());
 
-            continue;
-        }
+    foreach(TracePartCall* pc, pf->partCallings())
+        pc->call()->updatePartActivation(pc);
 
-        if (called->_cycleLow==0) {
-            // not visited yet
-            called->cycleDFS(d+1, pNo, pTop);
-            if (called->_cycleLow < _cycleLow)
-                _cycleLow = called->_cycleLow;
-        }
-        else if (called->_cycleStackDown) {
-            // backlink to same SCC (still in stack)
-            if (called->_cycleLow < _cycleLow)
-                _cycleLow = called->_cycleLow;
+    // costs below function level are recalculated on demand
+    foreach(TraceFunctionSource* sf, _sourceFiles)
+        sf->invalidateDynamicCost();
 
-            if (0) qDebug("%s (low %d) Back to %s",
-                          qPrintable(QString().fill(' ', d)),
-                          _cycleLow, qPrintable(called->prettyName()));
-        }
+    if (_instrMap) {
+        TraceInstrMap::Iterator iit;
+        for ( iit = _instrMap->begin();
+              iit != _instrMap->end(); ++iit )
+            (*iit).invalidate();
     }
 
-    if (prefixNo == _cycleLow) {
-        // this is the base of a SCC.
-
-        if (*pTop == this) {
-            *pTop = _cycleStackDown;
-            _cycleStackDown = nullptr;
-        }
-        else {
-            // a SCC with >1 members
-
-            TraceFunctionCycle* cycle = data()->functionCycle(this);
-            if (0) qDebug("Found Cycle %d with base %s:",
-                          cycle->cycleNo(), qPrintable(prettyName()));
-            while(*pTop) {
-                TraceFunction* top = *pTop;
-                cycle->add(top);
+    // source files propagate their invalidation to us
+    if (upToDate)
+        _dirty = false;
+    else
+        invalidate();
+}
 
-                // remove from stack
-                *pTop = top->_cycleStackDown;
-                top->_cycleStackDown = nullptr;
+bool TraceFunction::isCycle()
+{
+    return _cycle == this;
+}
 
-                if (0) qDebug("  %s", qPrintable(top->prettyName()));
-                if (top == this) break;
-            }
-        }
-    }
+bool TraceFunction::isCycleMember()
+{
+    return _cycle && (_cycle != this);
 }
 
+void TraceFunction::cycleReset()
+{
+    _cycle = nullptr;
+}
 
 TraceInstrMap* TraceFunction::instrMap()
 {
@@ -2558,6 +2678,21 @@ TraceInstrMap* TraceFunction::instrMap()
             fc->addTo(pi);
         }
 
+        // costs of instructions not read on loading
+        FixInstrRange* fr = pf->firstFixInstrRange();
+        if (fr) {
+            TracePart* part = pf->part();
+            QFile device(part->name());
+            FixFile file(&device, part->name());
+            if (file.exists() && (file.len() == part->detailFileSize())) {
+                for(; fr; fr = fr->nextRangeOfPartFunction())
+                    fr->addTo(this, pf, file);
+            }
+            else
+                qDebug("Instruction costs of '%s' not available: '%s' changed",
+                       qPrintable(name()), qPrintable(part->name()));
+        }
+
         TraceInstr* to = nullptr;
         TraceInstrJump* ij;
         TracePartInstrJump* pij;
@@ -2815,6 +2950,8 @@ void TraceFunctionCycle::init()
     _callers.clear();
     // this deletes all TraceCall's to members
     _callings.clear();
+    delete _callingIndex;
+    _callingIndex = nullptr;
 
     invalidate();
 }
@@ -3002,11 +3139,9 @@ QString TraceFile::directory()
 
 QString TraceFile::shortName() const
 {
-    int lastIndex = 0, index;
-    while ( (index=_name.indexOf(QLatin1Char('/'), lastIndex)) >=0)
-        lastIndex = index+1;
+    if (_nameId < 0) return QString();
 
-    return _name.mid(lastIndex);
+    return data()->nameTable()->shortName(_nameId);
 }
 
 QString TraceFile::prettyName() const
@@ -3103,11 +3238,9 @@ QString TraceObject::directory()
 
 QString TraceObject::shortName() const
 {
-    int lastIndex = 0, index;
-    while ( (index=_name.indexOf(QLatin1Char('/'), lastIndex)) >=0)
-        lastIndex = index+1;
+    if (_nameId < 0) return QString();
 
-    return _name.mid(lastIndex);
+    return data()->nameTable()->shortName(_nameId);
 }
 
 QString TraceObject::prettyName() const
@@ -3140,6 +3273,7 @@ TracePart::TracePart(TraceData* data)
     _pid = 0;
 
     _eventTypeMapping = nullptr;
+    _detailFileSize = 0;
 }
 
 TracePart::~TracePart()
@@ -3229,11 +3363,17 @@ void TraceData::init()
 {
     _functionCycleCount = 0;
     _inFunctionCycleUpdate = false;
+    _cyclesShown = -1;
 
     _maxThreadID = 0;
     _maxPartNumber = 0;
     _fixPool = nullptr;
     _dynPool = nullptr;
+    _nameTable = new NameTable();
+    _callGraph = nullptr;
+    _staging = false;
+    _loadCancel = nullptr;
+    _partPrefixSums = nullptr;
 
     _arch = ArchUnknown;
 }
@@ -3244,6 +3384,9 @@ TraceData::~TraceData()
 
     delete _fixPool;
     delete _dynPool;
+    delete _nameTable;
+    delete _callGraph;
+    delete _partPrefixSums;
 }
 
 QString TraceData::shortTraceName() const
@@ -3263,6 +3406,65 @@ FixPool* TraceData::fixPool()
     return _fixPool;
 }
 
+MemoryUsage TraceData::memoryUsage()
+{
+    MemoryUsage m;
+
+    // function map nodes, functions themselves are accounted for below
+    m.add(MemoryUsage::Other, _functionMap.count() *
+          MemoryUsage::mapEntryBytes(sizeof(QString), 0));
+    for (auto it = _functionMap.begin(); it != _functionMap.end(); ++it) {
+        m.add(MemoryUsage::Functions, sizeof(TraceFunction));
+        (*it).addMemoryUsage(m);
+    }
+
+    for (auto it = _objectMap.begin(); it != _objectMap.end(); ++it) {
+        TraceObject& o = *it;
+        m.add(MemoryUsage::Functions, o.costMemory() +
+              MemoryUsage::mapEntryBytes(sizeof(QString), sizeof(TraceObject)) +
+              MemoryUsage::listBytes(o.functions().count()));
+        addPartItemMemory(m, o.deps(), sizeof(TracePartObject));
+    }
+    for (auto it = _fileMap.begin(); it != _fileMap.end(); ++it) {
+        TraceFile& f = *it;
+        m.add(MemoryUsage::Functions, f.costMemory() +
+              MemoryUsage::mapEntryBytes(sizeof(QString), sizeof(TraceFile)) +
+              MemoryUsage::listBytes(f.functions().count() +
+                                     f.sourceFiles().count()));
+        addPartItemMemory(m, f.deps(), sizeof(TracePartFile));
+    }
+    for (auto it = _classMap.begin(); it != _classMap.end(); ++it) {
+        TraceClass& c = *it;
+        m.add(MemoryUsage::Functions, c.costMemory() +
+              MemoryUsage::mapEntryBytes(sizeof(QString), sizeof(TraceClass)) +
+              MemoryUsage::listBytes(c.functions().count()));
+        addPartItemMemory(m, c.deps(), sizeof(TracePartClass));
+    }
+
+    m.add(MemoryUsage::Names, _nameTable->memorySize(), _nameTable->count());
+
+    if (_fixPool) {
+        FixPool::Statistics s = _fixPool->statistics();
+        m.add(MemoryUsage::FixCosts, s.capacity, s.objects);
+    }
+
+    // lookup tables, parts and cycles
+    m.add(MemoryUsage::Other, MemoryUsage::mapEntryBytes(sizeof(void*), 0) *
+          (_objectHash.count() + _fileHash.count() + _functionHash.count()));
+    foreach(TracePart* p, _parts)
+        m.add(MemoryUsage::Other, sizeof(TracePart) + p->costMemory() +
+              MemoryUsage::listBytes(p->deps().count()));
+    if (_callGraph)
+        m.add(MemoryUsage::Other, _callGraph->memorySize());
+    foreach(TraceFunctionCycle* c, _functionCycles) {
+        m.add(MemoryUsage::Other, sizeof(TraceFunctionCycle) +
+              MemoryUsage::listBytes(c->members().count()));
+        c->addMemoryUsage(m);
+    }
+
+    return m;
+}
+
 DynPool* TraceData::dynPool()
 {
     if (!_dynPool)
@@ -3271,6 +3473,16 @@ DynPool* TraceData::dynPool()
     return _dynPool;
 }
 
+CallGraph* TraceData::callGraph()
+{
+    if (!_callGraph) {
+        _callGraph = new CallGraph();
+        _callGraph->build(this);
+    }
+
+    return _callGraph;
+}
+
 bool partLessThan(const TracePart* p1, const TracePart* p2)
 {
     return *p1 < *p2;
@@ -3285,8 +3497,35 @@ bool partLessThan(const TracePart* p1, const TracePart* p2)
  */
 int TraceData::load(QStringList files)
 {
+    files = prepareLoad(files);
     if (files.isEmpty()) return 0;
 
+    int threads = GlobalConfig::loadThreads();
+    if (threads == 0) threads = QThread::idealThreadCount();
+    if (threads > files.count()) threads = files.count();
+
+    int partsLoaded = 0;
+    if (threads > 1)
+        partsLoaded = loadParallel(files, threads);
+    else {
+        QStringList::const_iterator it;
+        for (it = files.constBegin(); it != files.constEnd(); ++it ) {
+            if (isLoadCanceled()) break;
+            QFile file(*it);
+            partsLoaded += internalLoad(&file, *it);
+        }
+    }
+    if (partsLoaded == 0) return 0;
+
+    finishLoad();
+
+    return partsLoaded;
+}
+
+QStringList TraceData::prepareLoad(QStringList files)
+{
+    if (files.isEmpty()) return files;
+
     _traceName = files[0];
     if (files.count() == 1) {
         QFileInfo finfo(_traceName);
@@ -3304,24 +3543,22 @@ int TraceData::load(QStringList files)
         }
     }
 
-    if (files.isEmpty()) {
+    if (files.isEmpty())
         _traceName += ' ' + QObject::tr("(not found)");
-        return 0;
-    }
 
-    QStringList::const_iterator it;
-    int partsLoaded = 0;
-    for (it = files.constBegin(); it != files.constEnd(); ++it ) {
-        QFile file(*it);
-        partsLoaded += internalLoad(&file, *it);
-    }
-    if (partsLoaded == 0) return 0;
+    return files;
+}
 
+void TraceData::finishLoad()
+{
     std::sort(_parts.begin(), _parts.end(), partLessThan);
     invalidateDynamicCost();
-    updateFunctionCycles();
 
-    return partsLoaded;
+    // a canceled load is discarded, skip the expensive steps
+    if (isLoadCanceled()) return;
+    updateFunctionCycles();
+    if (isLoadCanceled()) return;
+    updateFunctionCosts(GlobalConfig::loadThreads());
 }
 
 int TraceData::load(QString file)
@@ -3333,10 +3570,8 @@ int TraceData::load(QIODevice* file, const QString& filename)
 {
     _traceName = filename;
     int partsLoaded = internalLoad(file, filename);
-    if (partsLoaded>0) {
-        invalidateDynamicCost();
-        updateFunctionCycles();
-    }
+    if (partsLoaded>0)
+        finishLoad();
     return partsLoaded;
 }
 
@@ -3357,50 +3592,321 @@ int TraceData::internalLoad(QIODevice* device, const QString& filename)
         _logger->loadFinished(QStringLiteral("Unknown file format"));
         return 0;
     }
+
+    // traces may be loaded in parallel: do not share the loader
+    l = l->clone();
     l->setLogger(_logger);
 
     int partsLoaded = l->load(this, device, filename);
 
-    l->setLogger(nullptr);
+    delete l;
 
     return partsLoaded;
 }
 
+
+TraceData* TraceData::loadStaged(const QString& file, Logger* l,
+                                  const QAtomicInt* cancel)
+{
+    QFile device(file);
+    return loadStaged(&device, file, l, cancel);
+}
+
+TraceData* TraceData::loadStaged(QIODevice* device, const QString& file,
+                                  Logger* l, const QAtomicInt* cancel)
+{
+    TraceData* data = new TraceData(l);
+    data->setStaging(true);
+    data->setLoadCancel(cancel);
+    data->_traceName = file;
+
+    data->internalLoad(device, file);
+
+    // cancel flag may not exist after loading
+    data->setLoadCancel(nullptr);
+
+    return data;
+}
+
+int TraceData::loadParallel(const QStringList& files, int threads)
+{
+    struct StagedLoad {
+        QString file;
+        BufferedLogger logger;
+        TraceData* data;
+        QSemaphore done;
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    QList<StagedLoad*> loads;
+    const QAtomicInt* cancel = _loadCancel;
+    foreach(const QString& file, files) {
+        StagedLoad* load = new StagedLoad;
+        load->file = file;
+        load->data = nullptr;
+        loads.append(load);
+
+        pool.start([load, cancel]() {
+            load->data = loadStaged(load->file, &load->logger, cancel);
+            load->done.release();
+        });
+    }
+
+    // merge in order of given files, as soon as available
+    int partsLoaded = 0;
+    foreach(StagedLoad* load, loads) {
+        load->done.acquire();
+        load->logger.forward(_logger);
+        partsLoaded += mergeStaged(load->data);
+        delete load->data;
+    }
+    pool.waitForDone();
+    qDeleteAll(loads);
+
+    return partsLoaded;
+}
+
+int TraceData::mergeStaged(TraceData* staged, TracePart* into)
+{
+    if (!staged || (staged == this)) return 0;
+
+    // parts: new ones get the same attributes, with event types
+    // mapped into our event type set
+    QHash<TracePart*, TracePart*> partMap;
+    TracePartList newParts;
+    foreach(TracePart* sp, staged->_parts) {
+        EventTypeMapping* sm = sp->eventTypeMapping();
+        if (!sm) continue;
+
+        TracePart* p = into;
+        if (!p) {
+            p = new TracePart(this);
+            p->setName(sp->name());
+            p->setDescription(sp->description());
+            p->setTrigger(sp->trigger());
+            p->setTimeframe(sp->timeframe());
+            p->setVersion(sp->version());
+            p->setPartNumber(sp->partNumber());
+            p->setThreadID(sp->threadID());
+            p->setProcessID(sp->processID());
+            p->setDetailFileSize(sp->detailFileSize());
+
+            EventTypeMapping* m = new EventTypeMapping(&_eventTypes);
+            for (int i = 0; i < sm->count(); i++)
+                m->append(staged->_eventTypes.realType(sm->realIndex(i))->name());
+            p->setEventMapping(m);
+            newParts.append(p);
+        }
+        partMap.insert(sp, p);
+    }
+
+    // mapping of staged cost items to ours, created on demand
+    QHash<TraceObject*, TraceObject*> objects;
+    QHash<TraceFile*, TraceFile*> files;
+    QHash<TraceFunction*, TraceFunction*> functions;
+    QHash<TraceFunctionSource*, TraceFunctionSource*> sources;
+    QHash<TracePartFunction*, TracePartFunction*> partFunctions;
+
+    auto mapObject = [&](TraceObject* so) -> TraceObject* {
+        TraceObject*& o = objects[so];
+        if (!o) o = object(so->name());
+        return o;
+    };
+    auto mapFile = [&](TraceFile* sf) -> TraceFile* {
+        TraceFile*& f = files[sf];
+        if (!f) f = file(sf->name());
+        return f;
+    };
+    auto mapFunction = [&](TraceFunction* sf) -> TraceFunction* {
+        if (!sf) return nullptr;
+        TraceFunction*& f = functions[sf];
+        if (!f) f = function(sf->name(), mapFile(sf->file()),
+                             mapObject(sf->object()));
+        return f;
+    };
+    auto mapSource = [&](TraceFunctionSource* ss) -> TraceFunctionSource* {
+        if (!ss) return nullptr;
+        TraceFunctionSource*& s = sources[ss];
+        if (!s) s = mapFunction(ss->function())->sourceFile(mapFile(ss->file()),
+                                                            true);
+        return s;
+    };
+    auto mapPartFunction = [&](TracePartFunction* spf, TraceFunction* sf,
+                               TracePart* p) -> TracePartFunction* {
+        TraceFunction* f = mapFunction(sf);
+        if (!spf)
+            return f->partFunction(p, f->file()->partFile(p),
+                                   f->object()->partObject(p));
+
+        TracePartFunction*& pf = partFunctions[spf];
+        if (!pf) {
+            TracePartObject* partObject = nullptr;
+            if (spf->partObject())
+                partObject = mapObject(spf->partObject()->object())->partObject(p);
+            TraceFile* partFileFile = mapFile(spf->partFile()->file());
+            pf = f->partFunction(p, partFileFile->partFile(p), partObject);
+        }
+        return pf;
+    };
+
+    TraceObjectMap::Iterator oit;
+    for ( oit = staged->_objectMap.begin();
+          oit != staged->_objectMap.end(); ++oit )
+        mapObject(&(*oit));
+
+    TraceFileMap::Iterator fit;
+    for ( fit = staged->_fileMap.begin();
+          fit != staged->_fileMap.end(); ++fit )
+        mapFile(&(*fit));
+
+    // Move the fix costs over, keeping their order in the lists of
+    // part functions/calls: prepending staged lists results in the same
+    // order as sequential loading (new fix costs get prepended)
+    TraceFunctionMap::Iterator it;
+    for ( it = staged->_functionMap.begin();
+          it != staged->_functionMap.end(); ++it ) {
+        TraceFunction* sf = &(*it);
+        TraceFunction* f = mapFunction(sf);
+
+        foreach(TraceFunctionSource* ss, sf->sourceFiles())
+            mapSource(ss);
+
+        foreach(TraceInclusiveCost* item, sf->deps()) {
+            TracePartFunction* spf = (TracePartFunction*) item;
+            TracePart* p = partMap.value(spf->part());
+            if (!p) continue;
+
+            TracePartFunction* pf = mapPartFunction(spf, sf, p);
+
+            FixCost* fc = spf->firstFixCost();
+            if (fc) {
+                while(1) {
+                    fc->relocate(p, mapSource(fc->functionSource()));
+                    if (!fc->nextCostOfPartFunction()) break;
+                    fc = fc->nextCostOfPartFunction();
+                }
+                fc->setNextCostOfPartFunction(pf->setFirstFixCost(spf->firstFixCost()));
+                spf->setFirstFixCost(nullptr);
+            }
+
+            FixJump* fj = spf->firstFixJump();
+            if (fj) {
+                while(1) {
+                    fj->relocate(p, mapSource(fj->source()),
+                                 mapFunction(fj->targetFunction()),
+                                 mapSource(fj->targetSource()));
+                    if (!fj->nextJumpOfPartFunction()) break;
+                    fj = fj->nextJumpOfPartFunction();
+                }
+                fj->setNextJumpOfPartFunction(pf->setFirstFixJump(spf->firstFixJump()));
+                spf->setFirstFixJump(nullptr);
+            }
+
+            FixInstrRange* fr = spf->firstFixInstrRange();
+            if (fr) {
+                while(1) {
+                    fr->relocate(p, mapSource(fr->functionSource()));
+                    if (!fr->nextRangeOfPartFunction()) break;
+                    fr = fr->nextRangeOfPartFunction();
+                }
+                fr->setNextRangeOfPartFunction(pf->setFirstFixInstrRange(spf->firstFixInstrRange()));
+                spf->setFirstFixInstrRange(nullptr);
+            }
+
+            foreach(TracePartCall* spc, spf->partCallings()) {
+                TraceFunction* sCalled = spc->call()->called();
+                TracePartFunction* spfCalled =
+                        (TracePartFunction*) sCalled->findDepFromPart(spf->part());
+
+                TraceCall* call = f->calling(mapFunction(sCalled));
+                TracePartCall* pc = call->partCall(p, pf,
+                                                   mapPartFunction(spfCalled, sCalled, p));
+
+                FixCallCost* fcc = spc->firstFixCallCost();
+                if (!fcc) continue;
+                while(1) {
+                    fcc->relocate(p, mapSource(fcc->functionSource()));
+                    if (!fcc->nextCostOfPartCall()) break;
+                    fcc = fcc->nextCostOfPartCall();
+                }
+                fcc->setNextCostOfPartCall(pc->setFirstFixCallCost(spc->firstFixCallCost()));
+                spc->setFirstFixCallCost(nullptr);
+                pc->invalidate();
+            }
+            pf->invalidate();
+        }
+    }
+
+    // fix cost memory is ours now
+    if (staged->_fixPool)
+        fixPool()->adopt(staged->_fixPool);
+
+    for (int i = 0; i < staged->_eventTypes.realCount(); i++) {
+        int index = _eventTypes.realIndex(staged->_eventTypes.realType(i)->name());
+        _callMax.maxCost(index, staged->_callMax.subCost(i));
+    }
+    updateMaxCallCount(staged->_maxCallCount);
+
+    if (!staged->_command.isEmpty()) {
+        if (!_command.isEmpty() && (_command != staged->_command)) {
+            qDebug("TraceData::mergeStaged: Redefined command in %s",
+                   qPrintable(staged->_traceName));
+        }
+        _command = staged->_command;
+    }
+    if (staged->_arch != ArchUnknown)
+        _arch = staged->_arch;
+
+    foreach(TracePart* p, newParts) {
+        p->invalidate();
+        p->totals()->clear();
+        p->totals()->addCost(p);
+        addPart(p);
+    }
+    if (into) into->invalidate();
+    invalidate();
+
+    return newParts.count();
+}
+
 bool TraceData::activateParts(const TracePartList& l)
 {
-    bool changed = false;
+    TracePartList changed;
 
     foreach(TracePart* part, _parts)
         if (part->activate(l.contains(part)))
-            changed = true;
+            changed.append(part);
 
-    if (changed) {
-        // because active parts have changed, throw away calculated
-        // costs...
-        invalidateDynamicCost();
-        updateFunctionCycles();
-    }
+    if (changed.isEmpty()) return false;
 
-    return changed;
+    // because active parts have changed, update calculated costs
+    updatePartActivation(changed);
+    updateCyclesForActivation();
+    updateFunctionCosts(GlobalConfig::loadThreads());
+
+    return true;
 }
 
 
 bool TraceData::activateParts(TracePartList l, bool active)
 {
-    bool changed = false;
+    TracePartList changed;
 
     foreach(TracePart* part, l) {
         if (_parts.contains(part))
             if (part->activate(active))
-                changed = true;
+                changed.append(part);
     }
 
-    if (changed) {
-        invalidateDynamicCost();
-        updateFunctionCycles();
-    }
+    if (changed.isEmpty()) return false;
+
+    updatePartActivation(changed);
+    updateCyclesForActivation();
+    updateFunctionCosts(GlobalConfig::loadThreads());
 
-    return changed;
+    return true;
 }
 
 bool TraceData::activatePart(TracePart* p, bool active)
@@ -3417,12 +3923,16 @@ void TraceData::addPart(TracePart* part)
 {
     if (_parts.contains(part)>0) return;
 
-    if ((part->partNumber()==0) &&
+    if (!_staging &&
+        (part->partNumber()==0) &&
         (part->processID()==0)) {
         _maxPartNumber++;
         part->setPartNumber(_maxPartNumber);
     }
     _parts.append(part);
+
+    delete _partPrefixSums;
+    _partPrefixSums = nullptr;
 }
 
 TracePart* TraceData::partWithName(const QString& name)
@@ -3459,6 +3969,19 @@ QString TraceData::activePartRange()
     return res;
 }
 
+bool TraceData::activePartIndexRange(int& first, int& last)
+{
+    first = last = -1;
+    for (int i = 0; i < _parts.count(); i++) {
+        if (!_parts[i]->isActive()) continue;
+
+        if (first < 0) first = i;
+        else if (last < i - 1) return false;
+        last = i;
+    }
+    return first >= 0;
+}
+
 void TraceData::invalidateDynamicCost()
 {
     // invalidate all dynamic costs
@@ -3488,14 +4011,158 @@ void TraceData::invalidateDynamicCost()
 
 }
 
+// run <f> on chunks of index range [0,count[ with up to <threads> threads
+static void runInChunks(int count, int threads,
+                        const std::function<void(int,int)>& f)
+{
+    // not worth it for small ranges
+    const int minChunkSize = 1000;
+    int chunkSize = qMax(minChunkSize, count / (4 * threads) + 1);
+    if ((threads <= 1) || (count <= chunkSize)) {
+        f(0, count);
+        return;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    for (int from = 0; from < count; from += chunkSize) {
+        int to = qMin(from + chunkSize, count);
+        pool.start([&f, from, to]() { f(from, to); });
+    }
+    pool.waitForDone();
+}
+
+void TraceData::updateFunctionCosts(int threads)
+{
+    if (_eventTypes.realCount() == 0) return;
+    // to calculate context counts, functions use the first real event type
+    EventType* e = _eventTypes.realType(0);
+
+    if (threads == 0) threads = QThread::idealThreadCount();
+
+    QVector<TraceFunction*> functions;
+    functions.reserve(_functionMap.count());
+    TraceFunctionMap::Iterator it;
+    for ( it = _functionMap.begin(); it != _functionMap.end(); ++it )
+        functions.append(&(*it));
+
+    // Updating a cost item updates the items it depends on. To not update
+    // an item from multiple threads, this is done in two phases:
+    // 1) calls with their part calls: a call is owned by its caller, and
+    //    a part call by its call. Functions read the cost of their calls
+    //    for the first event type, thus this cached cost is set here, too.
+    runInChunks(functions.count(), threads, [&](int from, int to) {
+        for (int i = from; i < to; i++) {
+            if (isLoadCanceled()) return;
+            foreach(TraceCall* call, functions[i]->callings()) {
+                foreach(TraceCallCost* pc, call->deps()) {
+                    if (!pc->part() || !pc->part()->isActive()) continue;
+                    pc->update();
+                    pc->subCost(e);
+                }
+                call->update();
+                call->subCost(e);
+            }
+        }
+    });
+
+    // 2) functions with their part functions, only reading calls.
+    //    Function cycles depend on their members, and are left out.
+    if (isLoadCanceled()) return;
+    runInChunks(functions.count(), threads, [&](int from, int to) {
+        for (int i = from; i < to; i++) {
+            if (isLoadCanceled()) return;
+            TraceFunction* f = functions[i];
+            foreach(TraceInclusiveCost* pf, f->deps()) {
+                if (!pf->part() || !pf->part()->isActive()) continue;
+                pf->update();
+            }
+            f->update();
+        }
+    });
+}
+
+void TraceData::updatePartActivation(const TracePartList& parts)
+{
+#if USE_FIXCOST
+    // With cycles, inclusive costs are not a sum over parts.
+    // If most parts change, recalculation is cheaper.
+    if (hasFunctionCycles()) {
+        invalidateDynamicCost();
+        return;
+    }
+
+    // With prefix sums, a contiguous range of parts is set directly.
+    // Only worth it if not just a single part changed
+    int first, last;
+    if (GlobalConfig::usePartPrefixSums() && (parts.count() > 1) &&
+        activePartIndexRange(first, last)) {
+        if (!_partPrefixSums || !_partPrefixSums->isValid()) {
+            delete _partPrefixSums;
+            _partPrefixSums = new PartPrefixSums(this);
+        }
+        _partPrefixSums->apply(first, last);
+        return;
+    }
+
+    if (2 * parts.count() > _parts.count()) {
+        invalidateDynamicCost();
+        return;
+    }
+
+    // Instead of invalidating everything, only add/subtract the cost
+    // items of changed parts to/from the items summed up from parts
+    foreach(TracePart* part, parts) {
+        bool subtract = !part->isActive();
+        QSet<TracePartObject*> partObjects;
+        QSet<TracePartClass*> partClasses;
+        QSet<TracePartFile*> partFiles;
+
+        // dependencies of a part are its part functions
+        foreach(ProfileCostArray* item, part->deps()) {
+            TracePartFunction* pf = (TracePartFunction*) item;
+            pf->function()->updatePartActivation(pf);
+
+            if (pf->partObject()) partObjects.insert(pf->partObject());
+            if (pf->partClass()) partClasses.insert(pf->partClass());
+            if (pf->partFile()) partFiles.insert(pf->partFile());
+        }
+
+        foreach(TracePartObject* po, partObjects)
+            if (!po->object()->applyDelta(po, subtract))
+                po->object()->invalidate();
+
+        foreach(TracePartClass* pc, partClasses)
+            if (!pc->cls()->applyDelta(pc, subtract))
+                pc->cls()->invalidate();
+
+        foreach(TracePartFile* pf, partFiles)
+            if (!pf->file()->applyDelta(pf, subtract))
+                pf->file()->invalidate();
+
+        if (!applyDelta(part->totals(), subtract))
+            invalidate();
+    }
+#else
+    Q_UNUSED(parts);
+    invalidateDynamicCost();
+#endif
+}
+
 
 TraceObject* TraceData::object(const QString& name)
 {
-    TraceObject& o = _objectMap[name];
+    TraceObject* found = _objectHash.value(name);
+    if (found) return found;
+
+    // keys share the interned name
+    QString iname = _nameTable->intern(name);
+    TraceObject& o = _objectMap[iname];
+    _objectHash.insert(iname, &o);
     if (!o.data()) {
         // was created
         o.setPosition(this);
-        o.setName(name);
+        o.setName(iname);
 
 #if TRACE_DEBUG
         qDebug("Created %s [TraceData::object]",
@@ -3508,11 +4175,17 @@ TraceObject* TraceData::object(const QString& name)
 
 TraceFile* TraceData::file(const QString& name)
 {
-    TraceFile& f = _fileMap[name];
+    TraceFile* found = _fileHash.value(name);
+    if (found) return found;
+
+    // keys share the interned name
+    QString iname = _nameTable->intern(name);
+    TraceFile& f = _fileMap[iname];
+    _fileHash.insert(iname, &f);
     if (!f.data()) {
         // was created
         f.setPosition(this);
-        f.setName(name);
+        f.setName(iname);
 
 #if TRACE_DEBUG
         qDebug("Created %s [TraceData::file]",
@@ -3566,15 +4239,20 @@ TraceClass* TraceData::cls(const QString& fnName, QString& shortName)
 TraceFunction* TraceData::function(const QString& name,
                                    TraceFile* file, TraceObject* object)
 {
+    if (!file || !object) {
+        qDebug("ERROR - no file/object for %s ?!", qPrintable(name));
+        return nullptr;
+    }
+
+    // fast path for functions already looked up with same file/object
+    TraceFunctionKey hashKey { _nameTable->id(name), file, object };
+    TraceFunction* found = _functionHash.value(hashKey);
+    if (found) return found;
+
     // strip class name
     QString shortName;
     TraceClass* c = cls(name, shortName);
 
-    if (!file || !object || !c) {
-        qDebug("ERROR - no file/object/class for %s ?!", qPrintable(name));
-        return nullptr;
-    }
-
     // Use object name and file name as part of key, to get distinct
     // function objects for functions with same name but defined in
     // different ELF objects or different files (this is possible e.g.
@@ -3624,6 +4302,10 @@ TraceFunction* TraceData::function(const QString& name,
         file->addFunction(&f);
     }
 
+    // also different files/objects with same short names map to the same
+    // function (see key above), so there can be multiple hash keys.
+    _functionHash.insert(hashKey, &(it.value()));
+
     return &(it.value());
 }
 
@@ -3834,10 +4516,39 @@ TraceFunctionCycle* TraceData::functionCycle(TraceFunction* f)
 }
 
 
+bool TraceData::hasFunctionCycles()
+{
+    foreach(TraceFunctionCycle* cycle, _functionCycles)
+        if (!cycle->members().isEmpty()) return true;
+
+    return false;
+}
+
+void TraceData::updateCyclesForActivation()
+{
+    // Without cycle cut heuristic, cycles do not depend on costs, and
+    // thus not on active parts: only costs of cycles are to be updated
+    bool showCycles = GlobalConfig::showCycles();
+    if ((GlobalConfig::cycleCut() > 0.0) ||
+        (_cyclesShown != (showCycles ? 1 : 0))) {
+        updateFunctionCycles();
+        return;
+    }
+
+    foreach(TraceFunctionCycle* cycle, _functionCycles)
+        cycle->invalidateDynamicCost();
+}
+
 void TraceData::updateFunctionCycles()
 {
     //qDebug("Updating cycles...");
 
+    bool hadCycles = hasFunctionCycles();
+
+    // calls get attributed to other functions
+    delete _callGraph;
+    _callGraph = nullptr;
+
     // init cycle info
     foreach(TraceFunctionCycle* cycle, _functionCycles)
         cycle->init();
@@ -3846,35 +4557,73 @@ void TraceData::updateFunctionCycles()
     for ( it = _functionMap.begin(); it != _functionMap.end(); ++it )
         (*it).cycleReset();
 
+    _cyclesShown = GlobalConfig::showCycles() ? 1 : 0;
     if (!GlobalConfig::showCycles()) return;
 
     _inFunctionCycleUpdate = true;
 
+    // graph of calls with functions numbered in map order
+    QVector<TraceFunction*> functions;
+    functions.reserve(_functionMap.count());
+    for ( it = _functionMap.begin(); it != _functionMap.end(); ++it ) {
+        (*it).setGraphId(functions.count());
+        functions.append(&(*it));
+    }
 
-#if 0
-    int fCount = _functionMap.size(), fNo = 0, progress=0, p;
-    QString msg = tr("Recalculating Function Cycles...");
-    if (_topLevel) _topLevel->showStatus(msg,0);
-#endif
+    Q_ASSERT(functions.isEmpty() || (_eventTypes.realCount()>0));
+    EventType* e = _eventTypes.realType(0);
 
-    // DFS and collapse strong connected components (Tarjan)
-    int pNo = 0;
-    TraceFunction* stackTop;
-    for ( it = _functionMap.begin(); it != _functionMap.end(); ++it ) {
+    QVector<int> start, targets;
+    start.reserve(functions.count() + 1);
+    foreach(TraceFunction* f, functions) {
+        // a canceled load is discarded, no need for consistent cycles
+        if (isLoadCanceled()) {
+            _inFunctionCycleUpdate = false;
+            return;
+        }
+        start.append(targets.count());
+
+        /* cycle cut heuristic:
+         * skip calls for cycle detection if they make less than _cycleCut
+         * percent of the cost of the function.
+         * FIXME: Which cost type to use for this heuristic ?!
+         */
+        SubCost base = 0;
+        const TraceCallList& callers = f->callers(true);
+        if (callers.count()>0) {
+            foreach(TraceCall* caller, callers)
+                if (caller->subCost(e) > base)
+                    base = caller->subCost(e);
+        }
+        else base = f->inclusive()->subCost(e);
 
-#if 0
-        if (_topLevel) {
-            fNo++;
-            p = 100*fNo/fCount;
-            if (p> progress) {
-                progress = p;
-                _topLevel->showStatus(msg, p);
+        SubCost cutLimit = SubCost(base * GlobalConfig::cycleCut());
+
+        foreach(TraceCall *callee, f->callings()) {
+            if (callee->subCost(e) < cutLimit) {
+                if (0) qDebug("  Cut call %s => %s (cum. %s)",
+                              qPrintable(f->prettyName()),
+                              qPrintable(callee->called()->prettyName()),
+                              qPrintable(callee->subCost(e).pretty()));
+                continue;
             }
+            targets.append(callee->called()->graphId());
+        }
+    }
+    start.append(targets.count());
+
+    // collapse strong connected components (Tarjan) into cycles
+    StronglyConnectedComponents scc(start, targets);
+    for (int c = 0; c < scc.count(); c++) {
+        if (scc.size(c) < 2) continue;
+
+        TraceFunctionCycle* cycle = functionCycle(functions[scc.root(c)]);
+        if (0) qDebug("Found Cycle %d with base %s:", cycle->cycleNo(),
+                      qPrintable(functions[scc.root(c)]->prettyName()));
+        for (const int* m = scc.membersBegin(c); m != scc.membersEnd(c); ++m) {
+            cycle->add(functions[*m]);
+            if (0) qDebug("  %s", qPrintable(functions[*m]->prettyName()));
         }
-#endif
-
-        stackTop = nullptr;
-        (*it).cycleDFS(1, pNo, &stackTop);
     }
 
     // postprocess cycles
@@ -3882,14 +4631,23 @@ void TraceData::updateFunctionCycles()
         cycle->setup();
 
     _inFunctionCycleUpdate = false;
-    // we have to invalidate costs because cycles are now taken into account
-    invalidateDynamicCost();
+    // we have to invalidate costs because cycles are now taken into account.
+    // Without cycles before and after, costs are still valid
+    if (hadCycles || hasFunctionCycles())
+        invalidateDynamicCost();
 
 #if 0
     if (0) if (_topLevel) _topLevel->showStatus(QString(), 0);
 #endif
 }
 
+/* TODO: cycles of objects, classes and files.
+ * These need cycle items for the groups first, like TraceFunctionCycle
+ * for functions, which are shown in views and get the calls between
+ * their members. Detection then can reuse StronglyConnectedComponents
+ * on a CSR graph of the calls between groups, built like in
+ * updateFunctionCycles(). Until then, these are not called.
+ */
 void TraceData::updateObjectCycles()
 {
 }
@@ -24,7 +24,9 @@
 #include <qstring.h>
 #include <qstringlist.h>
 #include <qmap.h>
+#include <qhash.h>
 #include <QProcess>
+#include <QAtomicInt>
 #include <QDebug>
 
 #include "costitem.h"
@@ -33,6 +35,8 @@
 #include "addr.h"
 #include "context.h"
 #include "eventtype.h"
+#include "flatmap.h"
+#include "memoryusage.h"
 
 class QFile;
 
@@ -119,8 +123,12 @@ class QFile;
 class FixCost;
 class FixCallCost;
 class FixJump;
+class FixInstrRange;
 class FixPool;
 class DynPool;
+class NameTable;
+class PartPrefixSums;
+class CallGraph;
 class Logger;
 
 class ProfileCostArray;
@@ -189,8 +197,29 @@ typedef QMap<QString, TraceObject> TraceObjectMap;
 typedef QMap<QString, TraceClass> TraceClassMap;
 typedef QMap<QString, TraceFile> TraceFileMap;
 typedef QMap<QString, TraceFunction> TraceFunctionMap;
-typedef QMap<uint, TraceLine> TraceLineMap;
-typedef QMap<Addr, TraceInstr> TraceInstrMap;
+typedef FlatMap<uint, TraceLine> TraceLineMap;
+typedef FlatMap<Addr, TraceInstr> TraceInstrMap;
+
+/**
+ * Key for hashed lookup of functions, see TraceData::function().
+ * The name is given by its id in the NameTable of the trace. File and
+ * object are unique per TraceData, so their addresses work as
+ * identifiers.
+ */
+struct TraceFunctionKey
+{
+    int nameId;
+    const TraceFile* file;
+    const TraceObject* object;
+
+    bool operator==(const TraceFunctionKey& k) const
+    { return (nameId == k.nameId) && (file == k.file) && (object == k.object); }
+};
+
+inline size_t qHash(const TraceFunctionKey& k, size_t seed = 0)
+{
+    return qHashMulti(seed, k.nameId, k.file, k.object);
+}
 
 
 /**
@@ -233,10 +262,14 @@ public:
     QString costString(EventTypeSet* m) override;
     void clear() override;
 
+    bool applyDelta(ProfileCostArray* item, bool subtract) override;
+
     // additional cost metric
     SubCost callCount();
     QString prettyCallCount();
     void addCallCount(SubCost c);
+    // does not invalidate, see ProfileCostArray::setCost()
+    void setCallCount(SubCost c) { _callCount = c; }
 
 protected:
     SubCost _callCount;
@@ -256,9 +289,16 @@ public:
     QString costString(EventTypeSet* m) override;
     void clear() override;
 
+    bool applyDelta(ProfileCostArray* item, bool subtract) override;
+
     // additional cost metric
     ProfileCostArray* inclusive();
     void addInclusive(ProfileCostArray*);
+    int costMemory() const override
+    { return ProfileCostArray::costMemory() + _inclusive.costMemory(); }
+    // does not invalidate, see ProfileCostArray::setCost()
+    void setInclusive(const SubCost* cost, int count)
+    { _inclusive.setCost(cost, count); }
 
 protected:
     ProfileCostArray _inclusive;
@@ -570,6 +610,9 @@ public:
     FixJump* setFirstFixJump(FixJump* fj)
     { FixJump* t = _firstFixJump; _firstFixJump = fj; return t; }
     FixJump* firstFixJump() const { return _firstFixJump; }
+    FixInstrRange* setFirstFixInstrRange(FixInstrRange* fr)
+    { FixInstrRange* t = _firstFixInstrRange; _firstFixInstrRange = fr; return t; }
+    FixInstrRange* firstFixInstrRange() const { return _firstFixInstrRange; }
 
     // additional cost metrics
     SubCost calledCount();
@@ -595,6 +638,7 @@ private:
 
     FixCost* _firstFixCost;
     FixJump* _firstFixJump;
+    FixInstrRange* _firstFixInstrRange;
 };
 
 
@@ -682,6 +726,10 @@ public:
     /* passes ownership of mapping */
     void setEventMapping(EventTypeMapping* sm) { _eventTypeMapping = sm; }
     EventTypeMapping* eventTypeMapping() { return _eventTypeMapping; }
+    /* size of the file with costs of instructions to be read on demand,
+     * or 0 if all costs were read on loading (see FixInstrRange) */
+    void setDetailFileSize(uint64 s) { _detailFileSize = s; }
+    uint64 detailFileSize() const { return _detailFileSize; }
 
     // returns true if something changed
     bool activate(bool);
@@ -706,6 +754,8 @@ private:
 
     // event type mapping for all fix costs of this part
     EventTypeMapping* _eventTypeMapping;
+
+    uint64 _detailFileSize;
 };
 
 
@@ -736,6 +786,7 @@ public:
 
     // part factory
     TracePartInstrJump* partInstrJump(TracePart*);
+    int partInstrJumpCount() const;
 
 private:
     TraceInstr *_instrFrom, *_instrTo;
@@ -846,6 +897,8 @@ public:
     void update() override;
 
     void invalidateDynamicCost();
+    // apply activation change of the part of <pc>, see TraceData
+    void updatePartActivation(TracePartCall* pc);
 
     // factories
     TracePartCall* partCall(TracePart*,
@@ -986,13 +1039,16 @@ public:
     ~TraceCostItem() override;
 
     QString name() const override { return _name; }
-    virtual void setName(const QString& name) { _name = name; }
+    // the name is interned in the NameTable of the trace
+    virtual void setName(const QString& name);
+    int nameId() const { return _nameId; }
 
 protected:
     bool onlyActiveParts() override { return true; }
 
 protected:
     QString _name;
+    int _nameId;
 };
 
 
@@ -1046,6 +1102,8 @@ public:
     TraceLineMap* lineMap();
 
     void invalidateDynamicCost();
+    // add memory used by lines built up to now
+    void addMemoryUsage(MemoryUsage&);
 
     /* factories */
     TraceLine* line(uint lineno, bool createNew = true);
@@ -1221,9 +1279,17 @@ public:
 
     void update() override;
 
+    bool applyDelta(ProfileCostArray* item, bool subtract) override;
+
     // this invalidate all subcosts of function depending on
     // active status of parts
     void invalidateDynamicCost();
+    // apply activation change of the part of <pf>, see TraceData
+    void updatePartActivation(TracePartFunction* pf);
+
+    // add memory used by this function with its calls, source files,
+    // instructions and basic blocks; only counts what is built up to now
+    void addMemoryUsage(MemoryUsage&);
 
     void addCaller(TraceCall*);
 
@@ -1274,6 +1340,8 @@ public:
     QString prettyCallingCount();
     int calledContexts();
     int callingContexts();
+    // does not invalidate, see ProfileCostArray::setCost()
+    void setCallCounts(SubCost called, SubCost calling);
 
     // only to be called after default constructor
     void setFile(TraceFile* file) { _file = file; }
@@ -1294,11 +1362,17 @@ public:
     bool isCycle();
     bool isCycleMember();
     void cycleReset();
-    void cycleDFS(int d, int& pNo, TraceFunction** pTop);
+
+    // id in call graph, see CallGraph
+    int graphId() const { return _graphId; }
+    void setGraphId(int id) { _graphId = id; }
 
 protected:
     TraceCallList _callers; // list of calls we are called from
     TraceCallList _callings; // list of calls we are calling (we are owner)
+    // index into _callings by called function, only created for functions
+    // with many callees to avoid its memory overhead (see calling())
+    QHash<TraceFunction*, TraceCall*>* _callingIndex;
     TraceFunctionCycle* _cycle;
 
 private:
@@ -1307,25 +1381,29 @@ private:
     void constructBasicBlocks();
     void divideInstructionsIntoBasicBlocks(TraceInstrMap *instructions);
     void handleInvalidBranches();
+    void updateContexts();
 
     TraceClass* _cls;
     TraceObject* _object;
     TraceFile* _file;
 
     TraceFunctionSourceList _sourceFiles; // we are owner
+    // index into _sourceFiles, created like _callingIndex
+    QHash<TraceFile*, TraceFunctionSource*>* _sourceFileIndex;
     TraceInstrMap* _instrMap; // we are owner
     bool _instrMapFilled;
     std::vector<TraceBasicBlock*> _basicBlocks;
     // see TraceAssociation
     TraceAssociationList _associations;
 
-    // for cycle detection
-    int _cycleLow;
-    TraceFunction* _cycleStackDown;
+    // for cycle detection and CallGraph
+    int _graphId;
 
     // cached
     SubCost _calledCount, _callingCount;
     int _calledContexts, _callingContexts;
+    // context counts are not additive: recalculated on demand
+    bool _contextsDirty;
 };
 
 
@@ -1479,8 +1557,47 @@ public:
     int load(QString file);
     int load(QIODevice*, const QString&);
 
-    /** returns true if something changed. These do NOT
-     * invalidate the dynamic costs on a activation change,
+    /**
+     * Loads a single profile data file into a new staging trace,
+     * to be moved into another trace via mergeStaged() afterwards.
+     * Nothing is shared with other traces, thus this can be
+     * called from multiple threads in parallel.
+     */
+    static TraceData* loadStaged(const QString& file, Logger* l,
+                                 const QAtomicInt* cancel = nullptr);
+    static TraceData* loadStaged(QIODevice* device, const QString& file,
+                                 Logger* l, const QAtomicInt* cancel = nullptr);
+
+    /**
+     * Moves all profile data of staging trace @p staged into this trace.
+     * Parts of @p staged are appended as new parts, or merged into
+     * existing part @p into if given. In the latter case, totals of
+     * @p into are not updated.
+     * Merging staged traces in file order results in the same data as
+     * loading the files sequentially.
+     * Fix costs of @p staged are taken over by this trace, so it only
+     * can be deleted afterwards.
+     * Returns the number of new parts.
+     */
+    int mergeStaged(TraceData* staged, TracePart* into = nullptr);
+
+    /**
+     * Loaders stop early when the value of @p cancel gets non-zero.
+     * A trace with canceled loading may be incomplete and should be
+     * deleted. Used for loading in background, see BackgroundLoad.
+     */
+    void setLoadCancel(const QAtomicInt* cancel) { _loadCancel = cancel; }
+    const QAtomicInt* loadCancel() const { return _loadCancel; }
+    bool isLoadCanceled() const
+    { return _loadCancel && _loadCancel->loadRelaxed(); }
+
+    // staging traces do not number parts, see mergeStaged()
+    void setStaging(bool s) { _staging = s; }
+    bool isStaging() const { return _staging; }
+
+    /** returns true if something changed. Except for activatePart(),
+     * dynamic costs are updated for the activation change.
+     * activatePart() does NOT invalidate the dynamic costs,
      * i.e. all cost items depends on active parts.
      * This has to be done by the caller when true is returned by
      * calling invalidateDynamicCost().
@@ -1505,9 +1622,14 @@ public:
 
     EventTypeSet* eventTypes() { return &_eventTypes; }
 
+    // estimated memory used by the loaded profile data
+    MemoryUsage memoryUsage();
+
     // memory pools
     FixPool* fixPool();
     DynPool* dynPool();
+    // interned names of items of this trace
+    NameTable* nameTable() const { return _nameTable; }
 
     // factories for object/file/class/function/line instances
     TraceObject* object(const QString& name);
@@ -1541,6 +1663,9 @@ public:
 
     const TraceFunctionCycleList& functionCycles() { return _functionCycles; }
 
+    // compact call graph, built on demand after cycle updates
+    CallGraph* callGraph();
+
     ProfileCostArray* callMax() { return &_callMax; }
     SubCost maxCallCount() { return _maxCallCount; }
     void updateMaxCallCount(SubCost);
@@ -1563,17 +1688,43 @@ public:
     // invalidates all cost items dependent on active state of parts
     void invalidateDynamicCost();
 
+    /**
+     * Computes self and inclusive costs of all functions and their calls
+     * in advance, using up to @p threads threads (0: one per core),
+     * instead of on first access. Costs of function cycles and of
+     * objects, classes and files still are computed on demand.
+     */
+    void updateFunctionCosts(int threads = 0);
+    // incrementally applies activation changes of <parts>, falls back
+    // to invalidateDynamicCost() if not possible
+    void updatePartActivation(const TracePartList& parts);
+
     // cycle detection
     void updateFunctionCycles();
+    // not implemented yet, see TODO in tracedata.cpp
     void updateObjectCycles();
     void updateClassCycles();
     void updateFileCycles();
     bool inFunctionCycleUpdate() { return _inFunctionCycleUpdate; }
 
 private:
+    friend class BackgroundLoad;
+
     void init();
+    // set trace name, and expand a single file as prefix
+    QStringList prepareLoad(QStringList files);
+    // update after adding parts by loading
+    void finishLoad();
     // add profile parts from one file
     int internalLoad(QIODevice* file, const QString& filename);
+    // load files in parallel, using given number of threads
+    int loadParallel(const QStringList& files, int threads);
+    // are there function cycles with members?
+    bool hasFunctionCycles();
+    // update cycles after part activation changes, if needed
+    void updateCyclesForActivation();
+    // index range of active parts, false if not contiguous
+    bool activePartIndexRange(int& first, int& last);
 
     // for notification callbacks
     Logger* _logger;
@@ -1585,6 +1736,10 @@ private:
 
     FixPool* _fixPool;
     DynPool* _dynPool;
+    NameTable* _nameTable;
+    CallGraph* _callGraph;
+    bool _staging;
+    const QAtomicInt* _loadCancel;
 
     // always the trace totals (not dependent on active parts)
     ProfileCostArray _totals;
@@ -1595,6 +1750,10 @@ private:
     TraceClassMap _classMap;
     TraceFileMap _fileMap;
     TraceFunctionMap _functionMap;
+    // O(1) lookup into the maps above, which keep ordered iteration
+    QHash<QString, TraceObject*> _objectHash;
+    QHash<QString, TraceFile*> _fileHash;
+    QHash<TraceFunctionKey, TraceFunction*> _functionHash;
     QString _command;
     Arch _arch;
     QString _traceName;
@@ -1608,6 +1767,11 @@ private:
     TraceFunctionCycleList _functionCycles;
     int _functionCycleCount;
     bool _inFunctionCycleUpdate;
+    // showCycles() setting at last cycle update, -1 if not done yet
+    int _cyclesShown;
+
+    // for fast switching of active part ranges, created on demand
+    PartPrefixSums* _partPrefixSums;
 };
 
 
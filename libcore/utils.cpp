@@ -13,6 +13,11 @@
 #include "utils.h"
 
 #include <errno.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include <QIODevice>
 #include <QFile>
@@ -260,6 +265,82 @@ bool FixString::stripUInt64(uint64& v, bool stripSpaces)
 }
 
 
+// value of 8 ASCII digits in little endian <chunk>, where leading
+// bytes may be zero instead of '0'
+static inline uint64 parseEightDigits(uint64 chunk)
+{
+    chunk &= 0x0F0F0F0F0F0F0F0FULL;
+    chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+    chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFULL;
+    chunk = (chunk * 10000 + (chunk >> 32)) & 0x00000000FFFFFFFFULL;
+    return chunk;
+}
+
+// value of decimal number with <digits> (1 to 16) digits at <s>,
+// reading 8 bytes at <s> and 8 bytes at <s>+<digits>-8 if <digits> >8
+static inline uint64 parseDigits(const char* s, int digits)
+{
+    uint64 chunk;
+    if (digits <= 8) {
+        memcpy(&chunk, s, 8);
+        // little endian: move digits to the upper bytes
+        chunk <<= 8 * (8 - digits);
+        return parseEightDigits(chunk);
+    }
+
+    uint64 high;
+    memcpy(&high, s, 8);
+    high <<= 8 * (16 - digits);
+    memcpy(&chunk, s + digits - 8, 8);
+    return parseEightDigits(high) * 100000000ULL + parseEightDigits(chunk);
+}
+
+int FixString::stripUInt64s(uint64* v, int max, bool stripSpaces)
+{
+    int n = 0;
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // Vectorized: classify 16 bytes at once and convert up to 16 digits
+    // without a branch per digit. Only done if 16 bytes are available.
+    while((n < max) && (_len >= 16)) {
+        int digits;
+#if defined(__SSE2__)
+        __m128i chunk = _mm_loadu_si128((const __m128i*) _str);
+        __m128i t = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+        // digit iff (c - '0') <= 9, unsigned
+        __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(9)), t);
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(isDigit) & 0xFFFF;
+        digits = mask ? __builtin_ctz(mask) : 16;
+#else
+        digits = 0;
+        while((digits < 16) &&
+              (_str[digits] >= '0') && (_str[digits] <= '9'))
+            digits++;
+#endif
+        // let scalar code handle other cases (e.g. hexadecimal)
+        if ((digits == 0) || (digits == 16) || (_str[digits] == 'x')) break;
+
+        v[n++] = parseDigits(_str, digits);
+        _str += digits;
+        _len -= digits;
+        if (!stripSpaces && (n == max)) break;
+        while((_len > 0) && (*_str == ' ')) {
+            _str++;
+            _len--;
+        }
+    }
+#endif
+
+    // scalar fallback for the remaining values
+    while(n < max) {
+        char c;
+        if (!first(c) || (c < '0') || (c > '9')) break;
+        if (!stripUInt64(v[n], stripSpaces || (n + 1 < max))) break;
+        n++;
+    }
+    return n;
+}
+
 bool FixString::stripInt64(int64& v, bool stripSpaces)
 {
     if (_len==0) {
@@ -341,13 +422,22 @@ bool FixString::stripInt64(int64& v, bool stripSpaces)
 
 // class FixFile
 
+// files bigger than this are accessed via a sliding window
+#define FIXFILE_MAXMAPSIZE \
+    ((sizeof(void*) > 4) ? ((uint64)8 << 30) : ((uint64)256 << 20))
+// initial window size, doubled for lines not fitting well
+#define FIXFILE_WINDOWSIZE ((uint64)64 << 20)
+
 FixFile::FixFile(QIODevice* file, const QString& filename)
 {
     _file = file;
+    _base = _current = nullptr;
+    _len = _baseOffset = _baseLen = _currentLeft = 0;
+    _windowSize = 0;
+    _used_mmap = false;
+    _windowed = false;
 
     if (!file) {
-        _len = 0;
-        _currentLeft = 0;
         _openError = true;
         return;
     }
@@ -356,14 +446,22 @@ FixFile::FixFile(QIODevice* file, const QString& filename)
     if (!file->isOpen() && !file->open( QIODevice::ReadOnly ) ) {
         qWarning( "%s: %s", (const char*)QFile::encodeName(_filename),
                   strerror( errno ) );
-        _len = 0;
-        _currentLeft = 0;
         _openError = true;
         return;
     }
 
     _openError = false;
-    _used_mmap = false;
+
+    if ((uint64)file->size() > FIXFILE_MAXMAPSIZE) {
+        _len = file->size();
+        _windowed = true;
+        _windowSize = FIXFILE_WINDOWSIZE;
+        if (!moveWindow(0, _windowSize))
+            qWarning( "%s: cannot access data", qPrintable( _filename ));
+
+        if (0) qDebug("Windowed access to '%s'", qPrintable( _filename ));
+        return;
+    }
 
     uchar* addr = nullptr;
 
@@ -390,10 +488,34 @@ FixFile::FixFile(QIODevice* file, const QString& filename)
         _len  = _data.size();
     }
 
+    _baseLen     = _len;
     _current     = _base;
     _currentLeft = _len;
 }
 
+FixFile::FixFile(const FixFile& base, uint64 from, uint64 to)
+{
+    Q_ASSERT(!base._windowed);
+
+    // no ownership of the data: never unmapped by the view
+    _file = nullptr;
+    _filename = base._filename;
+    _openError = base._openError;
+    _used_mmap = false;
+    _windowed = false;
+    _windowSize = 0;
+
+    if (to > base._len) to = base._len;
+    if (from > to) from = to;
+
+    _base        = base._base;
+    _baseOffset  = 0;
+    _len         = to;
+    _baseLen     = to;
+    _current     = _base + from;
+    _currentLeft = to - from;
+}
+
 FixFile::~FixFile()
 {
     // if the file was read into _data, it will be deleted automatically
@@ -407,17 +529,99 @@ FixFile::~FixFile()
     }
 }
 
+/**
+ * Windowed access: make <size> bytes of data starting at file
+ * offset <pos> available (less at end of file), and set the
+ * current position to <pos>.
+ * Data is mapped if possible, otherwise read into a buffer.
+ */
+bool FixFile::moveWindow(uint64 pos, uint64 size)
+{
+    if (pos > _len) pos = _len;
+    if (size > _len - pos) size = _len - pos;
+
+    QFile* mappableDevice = dynamic_cast<QFile*>(_file);
+    if (_used_mmap) {
+        if (!mappableDevice->unmap( (uchar*) _base ))
+            qWarning( "munmap: %s", strerror( errno ) );
+        _used_mmap = false;
+    }
+
+    uchar* addr = nullptr;
+    if (mappableDevice && (size > 0))
+        addr = mappableDevice->map( pos, size );
+
+    if (addr) {
+        _data.clear();
+        _base = (char*) addr;
+        _used_mmap = true;
+    }
+    else {
+        // keep data still needed from the read buffer, which allows
+        // to stream from devices not able to seek backwards
+        if (!_data.isEmpty() && (pos >= _baseOffset) &&
+            (pos <= _baseOffset + _data.size()))
+            _data.remove(0, pos - _baseOffset);
+        else {
+            _data.clear();
+            if (!_file->seek(pos)) size = 0;
+        }
+        if (size > (uint64)_data.size())
+            _data.append(_file->read(size - _data.size()));
+        _base = _data.data();
+        size = _data.size();
+    }
+
+    if (0) qDebug("FixFile: window at %llu, size %llu", pos, size);
+
+    _baseOffset  = pos;
+    _baseLen     = size;
+    _current     = _base;
+    _currentLeft = size;
+
+    return (size > 0) || (pos == _len);
+}
+
+/**
+ * Windowed access: move window to start at the current position,
+ * to get data following the current window.
+ * Returns false if no further data is available.
+ */
+bool FixFile::nextWindow()
+{
+    if (!_windowed) return false;
+    if (_baseOffset + _baseLen >= _len) return false;
+
+    // a long line crossing the window end: enlarge window
+    if (_currentLeft > _windowSize/2) _windowSize *= 2;
+
+    uint64 left = _currentLeft;
+    moveWindow(current(), _windowSize);
+    return (_currentLeft > left);
+}
+
 bool FixFile::nextLine(FixString& str)
 {
-    if (_currentLeft == 0) return false;
+    if ((_currentLeft == 0) && !nextWindow()) return false;
 
-    unsigned left = _currentLeft;
+    uint64 left = _currentLeft;
     char* current = _current;
 
-    while(left>0) {
-        if (*current == 0 || *current == '\n') break;
-        current++;
-        left--;
+    while(1) {
+        while(left>0) {
+            if (*current == 0 || *current == '\n') break;
+            current++;
+            left--;
+        }
+        if (left > 0) break;
+
+        // at end of data: the line may cross the end of the window
+        uint64 scanned = _currentLeft;
+        bool more = nextWindow();
+        if (_currentLeft < scanned) return false;
+        current = _current + scanned;
+        left = _currentLeft - scanned;
+        if (!more) break;
     }
 
     if (0) {
@@ -426,8 +630,8 @@ bool FixFile::nextLine(FixString& str)
         if (l>199) l = 199;
         strncpy(tmp, _current, l);
         tmp[l] = 0;
-        qDebug("[FixFile::nextLine] At %lu, len %u: '%s'",
-               (unsigned long) (_current - _base), _currentLeft-left, tmp);
+        qDebug("[FixFile::nextLine] At %llu, len %llu: '%s'",
+               this->current(), _currentLeft-left, tmp);
     }
 
     int len =  _currentLeft-left;
@@ -445,12 +649,16 @@ bool FixFile::nextLine(FixString& str)
     return true;
 }
 
-bool FixFile::setCurrent(unsigned pos)
+bool FixFile::setCurrent(uint64 pos)
 {
     if (pos > _len) return false;
 
-    _current = _base + pos;
-    _currentLeft = _len - pos;
+    if (_windowed &&
+        ((pos < _baseOffset) || (pos > _baseOffset + _baseLen)))
+        return moveWindow(pos, _windowSize);
+
+    _current = _base + (pos - _baseOffset);
+    _currentLeft = _baseLen - (pos - _baseOffset);
     return true;
 }
 
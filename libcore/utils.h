@@ -73,6 +73,14 @@ public:
 
     bool stripUInt(uint&, bool stripSpaces = true);
     bool stripUInt64(uint64&, bool stripSpaces = true);
+    /**
+     * Strip up to @p max space separated decimal numbers into @p v.
+     * Stops before anything else (e.g. negative numbers), to be handled
+     * by stripInt64(). Hexadecimal numbers fall back to stripUInt64().
+     * With @p stripSpaces false, spaces after the last value are kept.
+     * @returns the number of values stripped.
+     */
+    int stripUInt64s(uint64* v, int max, bool stripSpaces = true);
     bool stripInt64(int64&, bool stripSpaces = true);
 
     operator QString() const
@@ -86,11 +94,22 @@ private:
 
 /**
  * A class for fast line by line reading of a read-only ASCII file
+ *
+ * Files up to 8 GB (256 MB on 32-bit platforms) are mapped or read
+ * at once. Bigger files are accessed via a sliding window, bounding the
+ * address space used. Then, a string returned by nextLine() is only
+ * valid up to the next call.
  */
 class FixFile {
 
 public:
     FixFile(QIODevice*, const QString&);
+    /**
+     * View on the range [@p from, @p to) of the data of @p base.
+     * Offsets stay relative to the start of @p base, which has to
+     * outlive the view. Not possible if @p base is windowed.
+     */
+    FixFile(const FixFile& base, uint64 from, uint64 to);
     ~FixFile();
 
     /**
@@ -100,16 +119,21 @@ public:
      */
     bool nextLine(FixString& str);
     bool exists() { return !_openError; }
-    unsigned len() { return _len; }
-    unsigned current() { return _current - _base; }
-    bool setCurrent(unsigned pos);
+    uint64 len() { return _len; }
+    uint64 current() { return _baseOffset + (_current - _base); }
+    bool setCurrent(uint64 pos);
     void rewind() { setCurrent(0); }
+    bool isWindowed() { return _windowed; }
 
 private:
+    bool moveWindow(uint64 pos, uint64 size);
+    bool nextWindow();
+
+    // the data available at _base starts at file offset _baseOffset
     char *_base, *_current;
     QByteArray _data;
-    unsigned _len, _currentLeft;
-    bool _used_mmap, _openError;
+    uint64 _len, _baseOffset, _baseLen, _currentLeft, _windowSize;
+    bool _used_mmap, _openError, _windowed;
     QIODevice* _file;
     QString _filename;
 };
@@ -16,6 +16,8 @@
 #include <math.h>
 
 #include <QApplication>
+#include <QBuffer>
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QDesktopServices>
 #include <QFile>
@@ -40,6 +42,7 @@
 #include <QMenu>
 
 
+#include "callgraph.h"
 #include "config.h"
 #include "globalguiconfig.h"
 #include "listutils.h"
@@ -58,6 +61,7 @@
 #define DEFAULT_CLUSTERGROUPS false
 #define DEFAULT_DETAILLEVEL   1
 #define DEFAULT_LAYOUT        GraphOptions::TopDown
+#define DEFAULT_USEGRAPHVIZ   false
 #define DEFAULT_ZOOMPOS       Auto
 
 
@@ -555,6 +559,10 @@ void GraphExporter::reset(TraceData*, CostItem* i, EventType* ct,
                           ProfileContext::Type gt, QString filename)
 {
     _graphCreated = false;
+    _visibleSelected = false;
+    _visibleNodes.clear();
+    _visibleEdges.clear();
+    _skippedEdges.clear();
     _nodeMap.clear();
     _edgeMap.clear();
 
@@ -653,63 +661,40 @@ void GraphExporter::createGraph()
 }
 
 
-bool GraphExporter::writeDot(QIODevice* device)
+QString GraphExporter::nodeName(TraceFunction* f, QChar type)
 {
-    if (!_item)
-        return false;
+    return QStringLiteral("%1%2").arg(type).arg((qptrdiff)f, 0, 16);
+}
 
-    QFile* file = nullptr;
-    QTextStream* stream = nullptr;
+TraceFunction* GraphExporter::centerFunction()
+{
+    if (!_item)
+        return nullptr;
 
-    if (device)
-        stream = new QTextStream(device);
-    else {
-        if (_tmpFile)
-            stream = new QTextStream(_tmpFile);
-        else {
-            file = new QFile(_dotName);
-            if ( !file->open(QIODevice::WriteOnly ) ) {
-                qDebug() << "Can not write dot file '"<< _dotName << "'";
-                delete file;
-                return false;
-            }
-            stream = new QTextStream(file);
-        }
+    switch (_item->type()) {
+    case ProfileContext::Function:
+    case ProfileContext::FunctionCycle:
+        return (TraceFunction*) _item;
+    case ProfileContext::Call:
+        return ((TraceCall*)_item)->caller(true);
+    default:
+        break;
     }
+    return nullptr;
+}
 
+/* Select the nodes and edges to be shown according to limits.
+ * This attaches edges to nodes and creates edges summing up skipped
+ * calls. Afterwards, edges of nodes are cleared; visible edges are
+ * inserted again by CallGraphView when building the scene.
+ */
+void GraphExporter::selectVisible()
+{
     if (!_graphCreated)
         createGraph();
-
-    /* Generate dot format...
-     * When used for the CallGraphView (in contrast to "Export Callgraph..."),
-     * the labels are only dummy placeholders to reserve space for our own
-     * drawings.
-     */
-
-    *stream << "digraph \"callgraph\" {\n";
-
-    if (_go->layout() == LeftRight) {
-        *stream << QStringLiteral("  rankdir=LR;\n");
-    } else if (_go->layout() == Circular) {
-        TraceFunction *f = nullptr;
-        switch (_item->type()) {
-        case ProfileContext::Function:
-        case ProfileContext::FunctionCycle:
-            f = (TraceFunction*) _item;
-            break;
-        case ProfileContext::Call:
-            f = ((TraceCall*)_item)->caller(true);
-            break;
-        default:
-            break;
-        }
-        if (f)
-            *stream << QStringLiteral("  center=F%1;\n").arg((qptrdiff)f, 0, 16);
-        *stream << QStringLiteral("  overlap=false;\n  splines=true;\n");
-    }
-
-    // for clustering
-    QMap<TraceCostItem*,QList<GraphNode*> > nLists;
+    if (_visibleSelected)
+        return;
+    _visibleSelected = true;
 
     GraphNodeMap::Iterator nit;
     for (nit = _nodeMap.begin(); nit != _nodeMap.end(); ++nit ) {
@@ -738,46 +723,7 @@ bool GraphExporter::writeDot(QIODevice* device)
             g = nullptr;
             break;
         }
-        nLists[g].append(&n);
-    }
-
-    QMap<TraceCostItem*,QList<GraphNode*> >::Iterator lit;
-    int cluster = 0;
-    for (lit = nLists.begin(); lit != nLists.end(); ++lit, cluster++) {
-        QList<GraphNode*>& l = lit.value();
-        TraceCostItem* i = lit.key();
-
-        if (_go->clusterGroups() && i) {
-            QString iabr = GlobalConfig::shortenSymbol(i->prettyName());
-            // escape quotation marks in symbols to avoid invalid dot syntax
-            iabr.replace("\"", "\\\"");
-            *stream << QStringLiteral("subgraph \"cluster%1\" { label=\"%2\";\n")
-                       .arg(cluster).arg(iabr);
-        }
-
-        foreach(GraphNode* np, l) {
-            TraceFunction* f = np->function();
-
-            QString abr = GlobalConfig::shortenSymbol(f->prettyName());
-            // escape quotation marks to avoid invalid dot syntax
-            abr.replace("\"", "\\\"");
-            *stream << QStringLiteral("  F%1 [").arg((qptrdiff)f, 0, 16);
-            if (_useBox) {
-                // we want a minimal size for cost display
-                if ((int)abr.length() < 8) abr = abr + QString(8 - abr.length(),'_');
-
-                // make label 3 lines for CallGraphView
-                *stream << QStringLiteral("shape=box,label=\"** %1 **\\n**\\n%2\"];\n")
-                           .arg(abr)
-                           .arg(SubCost(np->incl).pretty());
-            } else
-                *stream << QStringLiteral("label=\"%1\\n%2\"];\n")
-                           .arg(abr)
-                           .arg(SubCost(np->incl).pretty());
-        }
-
-        if (_go->clusterGroups() && i)
-            *stream << QStringLiteral("}\n");
+        _visibleNodes[g].append(&n);
     }
 
     GraphEdgeMap::Iterator eit;
@@ -805,22 +751,7 @@ bool GraphExporter::writeDot(QIODevice* device)
         from.removeEdge(&e);
         to.removeEdge(&e);
 
-        *stream << QStringLiteral("  F%1 -> F%2 [weight=%3")
-                   .arg((qptrdiff)e.from(), 0, 16)
-                   .arg((qptrdiff)e.to(), 0, 16)
-                   .arg((long)log(log(e.cost)));
-
-        if (_go->detailLevel() ==1) {
-            *stream << QStringLiteral(",label=\"%1 (%2x)\"")
-                       .arg(SubCost(e.cost).pretty())
-                       .arg(SubCost(e.count).pretty());
-        }
-        else if (_go->detailLevel() ==2)
-            *stream << QStringLiteral(",label=\"%3\\n%4 x\"")
-                       .arg(SubCost(e.cost).pretty())
-                       .arg(SubCost(e.count).pretty());
-
-        *stream << QStringLiteral("];\n");
+        _visibleEdges.append(&e);
     }
 
     if (_go->showSkipped()) {
@@ -843,15 +774,7 @@ bool GraphExporter::writeDot(QIODevice* device)
                 e->setCallee(p.second);
                 e->cost = costSum;
                 e->count = countSum;
-
-                *stream << QStringLiteral("  R%1 [shape=point,label=\"\"];\n")
-                           .arg((qptrdiff)n.function(), 0, 16);
-                *stream << QStringLiteral("  R%1 -> F%2 [label=\"%3\\n%4 x\",weight=%5];\n")
-                           .arg((qptrdiff)n.function(), 0, 16)
-                           .arg((qptrdiff)n.function(), 0, 16)
-                           .arg(SubCost(costSum).pretty())
-                           .arg(SubCost(countSum).pretty())
-                           .arg((int)log(costSum));
+                _skippedEdges.append(e);
             }
 
             // add edge for all skipped callees if cost sum is high enough
@@ -864,25 +787,141 @@ bool GraphExporter::writeDot(QIODevice* device)
                 e->setCaller(p.first);
                 e->cost = costSum;
                 e->count = countSum;
-
-                *stream << QStringLiteral("  S%1 [shape=point,label=\"\"];\n")
-                           .arg((qptrdiff)n.function(), 0, 16);
-                *stream << QStringLiteral("  F%1 -> S%2 [label=\"%3\\n%4 x\",weight=%5];\n")
-                           .arg((qptrdiff)n.function(), 0, 16)
-                           .arg((qptrdiff)n.function(), 0, 16)
-                           .arg(SubCost(costSum).pretty())
-                           .arg(SubCost(countSum).pretty())
-                           .arg((int)log(costSum));
+                _skippedEdges.append(e);
             }
         }
     }
 
     // clear edges here completely.
-    // Visible edges are inserted again on parsing in CallGraphView::refresh
+    // Visible edges are inserted again in CallGraphView::showLayout
     for (nit = _nodeMap.begin(); nit != _nodeMap.end(); ++nit ) {
         GraphNode& n = *nit;
         n.clearEdges();
     }
+}
+
+bool GraphExporter::writeDot(QIODevice* device)
+{
+    if (!_item)
+        return false;
+
+    QFile* file = nullptr;
+    QTextStream* stream = nullptr;
+
+    if (device)
+        stream = new QTextStream(device);
+    else {
+        if (_tmpFile)
+            stream = new QTextStream(_tmpFile);
+        else {
+            file = new QFile(_dotName);
+            if ( !file->open(QIODevice::WriteOnly ) ) {
+                qDebug() << "Can not write dot file '"<< _dotName << "'";
+                delete file;
+                return false;
+            }
+            stream = new QTextStream(file);
+        }
+    }
+
+    selectVisible();
+
+    /* Generate dot format...
+     * When used for the CallGraphView (in contrast to "Export Callgraph..."),
+     * the labels are only dummy placeholders to reserve space for our own
+     * drawings.
+     */
+
+    *stream << "digraph \"callgraph\" {\n";
+
+    if (_go->layout() == LeftRight) {
+        *stream << QStringLiteral("  rankdir=LR;\n");
+    } else if (_go->layout() == Circular) {
+        TraceFunction *f = centerFunction();
+        if (f)
+            *stream << QStringLiteral("  center=%1;\n").arg(nodeName(f));
+        *stream << QStringLiteral("  overlap=false;\n  splines=true;\n");
+    }
+
+    QMap<TraceCostItem*,QList<GraphNode*> >::Iterator lit;
+    int cluster = 0;
+    for (lit = _visibleNodes.begin(); lit != _visibleNodes.end(); ++lit, cluster++) {
+        QList<GraphNode*>& l = lit.value();
+        TraceCostItem* i = lit.key();
+
+        if (_go->clusterGroups() && i) {
+            QString iabr = GlobalConfig::shortenSymbol(i->prettyName());
+            // escape quotation marks in symbols to avoid invalid dot syntax
+            iabr.replace("\"", "\\\"");
+            *stream << QStringLiteral("subgraph \"cluster%1\" { label=\"%2\";\n")
+                       .arg(cluster).arg(iabr);
+        }
+
+        foreach(GraphNode* np, l) {
+            TraceFunction* f = np->function();
+
+            QString abr = GlobalConfig::shortenSymbol(f->prettyName());
+            // escape quotation marks to avoid invalid dot syntax
+            abr.replace("\"", "\\\"");
+            *stream << QStringLiteral("  %1 [").arg(nodeName(f));
+            if (_useBox) {
+                // we want a minimal size for cost display
+                if ((int)abr.length() < 8) abr = abr + QString(8 - abr.length(),'_');
+
+                // make label 3 lines for CallGraphView
+                *stream << QStringLiteral("shape=box,label=\"** %1 **\\n**\\n%2\"];\n")
+                           .arg(abr)
+                           .arg(SubCost(np->incl).pretty());
+            } else
+                *stream << QStringLiteral("label=\"%1\\n%2\"];\n")
+                           .arg(abr)
+                           .arg(SubCost(np->incl).pretty());
+        }
+
+        if (_go->clusterGroups() && i)
+            *stream << QStringLiteral("}\n");
+    }
+
+    foreach(GraphEdge* e, _visibleEdges) {
+        *stream << QStringLiteral("  %1 -> %2 [weight=%3")
+                   .arg(nodeName(e->from()))
+                   .arg(nodeName(e->to()))
+                   .arg((long)log(log(e->cost)));
+
+        if (_go->detailLevel() ==1) {
+            *stream << QStringLiteral(",label=\"%1 (%2x)\"")
+                       .arg(SubCost(e->cost).pretty())
+                       .arg(SubCost(e->count).pretty());
+        }
+        else if (_go->detailLevel() ==2)
+            *stream << QStringLiteral(",label=\"%3\\n%4 x\"")
+                       .arg(SubCost(e->cost).pretty())
+                       .arg(SubCost(e->count).pretty());
+
+        *stream << QStringLiteral("];\n");
+    }
+
+    foreach(GraphEdge* e, _skippedEdges) {
+        // sum of skipped callers ("R") or callees ("S") of a function
+        QString point, from, to;
+        if (!e->from()) {
+            point = nodeName(e->to(), QLatin1Char('R'));
+            from = point;
+            to = nodeName(e->to());
+        } else {
+            point = nodeName(e->from(), QLatin1Char('S'));
+            from = nodeName(e->from());
+            to = point;
+        }
+        *stream << QStringLiteral("  %1 [shape=point,label=\"\"];\n")
+                   .arg(point);
+        *stream << QStringLiteral("  %1 -> %2 [label=\"%3\\n%4 x\",weight=%5];\n")
+                   .arg(from)
+                   .arg(to)
+                   .arg(SubCost(e->cost).pretty())
+                   .arg(SubCost(e->count).pretty())
+                   .arg((int)log(e->cost));
+    }
 
     *stream << "}\n";
 
@@ -1066,11 +1105,17 @@ void GraphExporter::buildGraph(TraceFunction* f, int depth, bool toCallees,
     TraceFunction* f2;
 
     // on entering a cycle, only go the FunctionCycle
-    TraceCallList l = toCallees ? f->callings(false) : f->callers(false);
-
-    foreach(TraceCall* call, l) {
+    CallGraph* g = f->data()->callGraph();
+    int id = g->id(f);
+    const CallGraph::Edge *edge = nullptr, *end = nullptr;
+    if (id >= 0) {
+        edge = toCallees ? g->callingsBegin(id) : g->callersBegin(id);
+        end = toCallees ? g->callingsEnd(id) : g->callersEnd(id);
+    }
 
-        f2 = toCallees ? call->called(false) : call->caller(false);
+    for(; edge != end; ++edge) {
+        TraceCall* call = g->call(edge->call);
+        f2 = g->function(edge->function);
 
         double count = call->callCount() * factor;
         double cost = call->subCost(_eventType) * factor;
@@ -1113,9 +1158,7 @@ void GraphExporter::buildGraph(TraceFunction* f, int depth, bool toCallees,
         }
 
         // - do not do a DFS on calls in recursion/cycle
-        if (call->inCycle()>0)
-            continue;
-        if (call->isRecursion())
+        if (g->isCyclic(edge->call))
             continue;
 
         if (toCallees)
@@ -1161,8 +1204,19 @@ PanningView::PanningView(QWidget * parent)
 
 void PanningView::setZoomRect(const QRectF& r)
 {
+    QRectF old = _zoomRect;
     _zoomRect = r;
-    viewport()->update();
+    if (!old.isValid() || !r.isValid()) {
+        viewport()->update();
+        return;
+    }
+
+    // only redraw around old and new zoom rect (with pen width): this
+    // is called on each scroll step, and drawing all items of large
+    // graphs would be slow
+    QRect dirty = mapFromScene(old).boundingRect() |
+                  mapFromScene(r).boundingRect();
+    viewport()->update(dirty.adjusted(-3, -3, 3, 3));
 }
 
 void PanningView::drawForeground(QPainter * p, const QRectF&)
@@ -1223,7 +1277,7 @@ void PanningView::mouseReleaseEvent(QMouseEvent*)
 
 CanvasNode::CanvasNode(CallGraphView* v, GraphNode* n, int x, int y, int w,
                        int h) :
-    QGraphicsRectItem(QRect(x, y, w, h)), _node(n), _view(v)
+    QGraphicsRectItem(QRect(x, y, w, h)), _node(n), _view(v), _cluster(nullptr)
 {
     setPosition(0, DrawParams::TopCenter);
     setPosition(1, DrawParams::BottomCenter);
@@ -1280,12 +1334,20 @@ void CanvasNode::paint(QPainter* p,
                        const QStyleOptionGraphicsItem* option,
                        QWidget*)
 {
+    double scale = GraphLOD::scale(option, p);
+    // drawn as part of the cluster box
+    if (_cluster && GraphLOD::isCollapsed(scale))
+        return;
+
     QRect r = rect().toRect(), origRect = r;
 
     r.setRect(r.x()+1, r.y()+1, r.width()-2, r.height()-2);
 
     RectDrawing d(r);
-    d.drawBack(p, this);
+    if (GraphLOD::isSimple(scale))
+        p->fillRect(r, backColor());
+    else
+        d.drawBack(p, this);
     r.setRect(r.x()+2, r.y()+2, r.width()-4, r.height()-4);
 
 #if 0
@@ -1300,7 +1362,7 @@ void CanvasNode::paint(QPainter* p,
     p->drawRect(QRect(origRect.x(), origRect.y(), origRect.width()-1,
                       origRect.height()-1));
 
-    if (option->levelOfDetailFromTransform(p->transform()) < .5)
+    if (!GraphLOD::showText(scale, QFontMetrics(font()).height()))
         return;
 
     d.setRect(r);
@@ -1365,7 +1427,9 @@ void CanvasEdgeLabel::paint(QPainter* p,
                             const QStyleOptionGraphicsItem* option, QWidget*)
 {
     // draw nothing in PanningView
-    if (option->levelOfDetailFromTransform(p->transform()) < .5)
+    double scale = GraphLOD::scale(option, p);
+    if (!GraphLOD::showText(scale, QFontMetrics(font()).height()) ||
+        _ce->isCollapsed(scale))
         return;
 
     QRect r = rect().toRect();
@@ -1385,8 +1449,12 @@ CanvasEdgeArrow::CanvasEdgeArrow(CanvasEdge* ce)
 {}
 
 void CanvasEdgeArrow::paint(QPainter* p,
-                            const QStyleOptionGraphicsItem *, QWidget *)
+                            const QStyleOptionGraphicsItem* option, QWidget*)
 {
+    // too small to be seen when zoomed out
+    if (GraphLOD::isSimple(GraphLOD::scale(option, p)))
+        return;
+
     p->setRenderHint(QPainter::Antialiasing);
     p->setBrush(_ce->isSelected() ? Qt::red : Qt::black);
     p->drawPolygon(polygon(), Qt::OddEvenFill);
@@ -1446,27 +1514,42 @@ void CanvasEdge::setControlPoints(const QPolygon& pa)
         path.cubicTo(pa[i], pa[(i + 1) % pa.size()], pa[(i + 2) % pa.size()]);
 
     setPath(path);
+    _simplePath = GraphLOD::simplePath(pa);
 }
 
+bool CanvasEdge::isCollapsed(double scale)
+{
+    if (!GraphLOD::isCollapsed(scale)) return false;
+
+    CanvasNode* from = _edge->fromNode() ? _edge->fromNode()->canvasNode() : nullptr;
+    CanvasNode* to = _edge->toNode() ? _edge->toNode()->canvasNode() : nullptr;
+    return from && to && from->cluster() && (from->cluster() == to->cluster());
+}
 
 void CanvasEdge::paint(QPainter* p,
                        const QStyleOptionGraphicsItem* option, QWidget*)
 {
-    p->setRenderHint(QPainter::Antialiasing);
-
     qreal levelOfDetail;
-    levelOfDetail = option->levelOfDetailFromTransform(p->transform());
+    levelOfDetail = GraphLOD::scale(option, p);
+    if (isCollapsed(levelOfDetail))
+        return;
+
+    // when zoomed out, polylines without antialiasing are good enough
+    bool simple = GraphLOD::isSimple(levelOfDetail);
+    const QPainterPath& edgePath = simple ? _simplePath : path();
+    if (!simple)
+        p->setRenderHint(QPainter::Antialiasing);
 
     QPen mypen = pen();
     mypen.setWidthF(1.0/levelOfDetail * _thickness);
     p->setPen(mypen);
-    p->drawPath(path());
+    p->drawPath(edgePath);
 
     if (isSelected()) {
         mypen.setColor(Qt::red);
         mypen.setWidthF(1.0/levelOfDetail * _thickness/2.0);
         p->setPen(mypen);
-        p->drawPath(path());
+        p->drawPath(edgePath);
     }
 }
 
@@ -1536,13 +1619,56 @@ void CanvasFrame::paint(QPainter* p,
 }
 
 
+//
+// CanvasCluster
+//
+
+CanvasCluster::CanvasCluster(const QRectF& r, const QString& name,
+                             const QColor& c)
+    : QGraphicsRectItem(r), _name(name)
+{
+    setBrush(c);
+    setCollapsed(false);
+}
+
+void CanvasCluster::setCollapsed(bool collapsed)
+{
+    // the box is painted in the panner, but should not get the tooltip
+    // or clicks of the main view for the gaps between its nodes
+    setToolTip(collapsed ? _name : QString());
+    setAcceptedMouseButtons(collapsed ? Qt::AllButtons : Qt::NoButton);
+}
+
+void CanvasCluster::paint(QPainter* p,
+                          const QStyleOptionGraphicsItem* option, QWidget*)
+{
+    // nodes of the cluster are drawn themselves when not zoomed out
+    if (!GraphLOD::isCollapsed(GraphLOD::scale(option, p)))
+        return;
+
+    p->setPen(Qt::black);
+    p->setBrush(brush());
+    p->drawRect(rect());
+
+    // name with normal font size, if it fits into the box
+    p->save();
+    QRect r = p->transform().mapRect(rect()).toRect();
+    p->resetTransform();
+    QFontMetrics fm(p->font());
+    if ((r.height() > fm.height()) && (r.width() > 4 * fm.averageCharWidth()))
+        p->drawText(r, Qt::AlignCenter,
+                    fm.elidedText(_name, Qt::ElideMiddle, r.width() - 4));
+    p->restore();
+}
+
+
 
 //
 // CallGraphView
 //
 CallGraphView::CallGraphView(TraceItemView* parentView, QWidget* parent,
                              const QString& name) :
-    QGraphicsView(parent), TraceItemView(parentView)
+    QGraphicsView(parent), TraceItemView(parentView), _frameTime(this)
 {
     setObjectName(name);
     _zoomPosition = DEFAULT_ZOOMPOS;
@@ -1574,6 +1700,7 @@ CallGraphView::CallGraphView(TraceItemView* parentView, QWidget* parent,
     // tooltips...
     //_tip = new CallGraphTip(this);
 
+    _useGraphviz = DEFAULT_USEGRAPHVIZ;
     _renderProcess = nullptr;
     _prevSelectedNode = nullptr;
     connect(&_renderTimer, &QTimer::timeout,
@@ -2083,6 +2210,11 @@ void CallGraphView::refresh()
     _selectedNode = nullptr;
     _selectedEdge = nullptr;
 
+    if (!_useGraphviz) {
+        layoutGraph();
+        return;
+    }
+
     /*
      * Call 'dot' asynchronously in the background with the aim to
      * - have responsive GUI while layout task runs (potentially long!)
@@ -2106,6 +2238,29 @@ void CallGraphView::refresh()
         renderProgram = QStringLiteral("dot");
     renderArgs << QStringLiteral("-Tplain");
 
+    _exporter.reset(_data, _activeItem, _eventType, _groupType);
+    QByteArray dot;
+    QBuffer buffer(&dot);
+    buffer.open(QIODevice::WriteOnly);
+    _exporter.writeDot(&buffer);
+    buffer.close();
+
+    // scaling of 'dot' output depends on font and detail level
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(renderProgram.toUtf8());
+    hash.addData(QByteArray::number(fontMetrics().height()));
+    hash.addData(QByteArray::number(_detailLevel));
+    hash.addData(dot);
+    _renderKey = hash.result();
+
+    const GraphLayout* cached = GraphLayoutCache::global()->find(_renderKey);
+    if (cached) {
+        GraphLayout layout = *cached;
+        bindLayout(layout);
+        showLayout(layout);
+        return;
+    }
+
     _unparsedOutput = QString();
 
     // display warning if layouting takes > 1s
@@ -2128,8 +2283,7 @@ void CallGraphView::refresh()
     // thus, we use a local copy afterwards
     QProcess* p = _renderProcess;
     p->start(renderProgram, renderArgs);
-    _exporter.reset(_data, _activeItem, _eventType, _groupType);
-    _exporter.writeDot(p);
+    p->write(dot);
     p->closeWriteChannel();
 }
 
@@ -2182,27 +2336,52 @@ void CallGraphView::dotExited()
     _renderProcess->deleteLater();
     _renderProcess = nullptr;
 
+    GraphLayout layout;
+    if (!parseDotOutput(layout)) {
+        QString s = tr("Error running the graph layouting tool.\n");
+        s += tr("Please check that 'dot' is installed (package GraphViz).");
+        showText(s);
+        return;
+    }
+    GraphLayoutCache::global()->insert(_renderKey, layout);
+    showLayout(layout);
+}
+
+/* Set nodes and edges of a cached layout from the names of its nodes,
+ * as the cached ones are from a graph not existing any longer.
+ */
+void CallGraphView::bindLayout(GraphLayout& layout)
+{
+    for (int i = 0; i < layout.nodeCount(); i++) {
+        GraphLayout::Node& node = layout.nodeAt(i);
+        node.node = _exporter.node(_exporter.toFunc(node.name));
+    }
+    for (int i = 0; i < layout.edgeCount(); i++) {
+        GraphLayout::Edge& edge = layout.edgeAt(i);
+        edge.edge = nullptr;
+        if ((edge.from < 0) || (edge.to < 0)) continue;
+        edge.edge = _exporter.edge(_exporter.toFunc(layout.nodeAt(edge.from).name),
+                                   _exporter.toFunc(layout.nodeAt(edge.to).name));
+    }
+}
+
+/* Parse the output of 'dot -Tplain' into @p layout, with coordinates
+ * scaled to the scene. Returns false if no graph was found.
+ */
+bool CallGraphView::parseDotOutput(GraphLayout& layout)
+{
     QString line, cmd;
-    CanvasNode *rItem;
-    QGraphicsEllipseItem* eItem;
-    CanvasEdge* sItem;
-    CanvasEdgeLabel* lItem;
-    QTextStream* dotStream;
     double scale = 1.0, scaleX = 1.0, scaleY = 1.0;
     double dotWidth = 0, dotHeight = 0;
-    GraphNode* activeNode = nullptr;
-    GraphEdge* activeEdge = nullptr;
+    bool graphFound = false;
 
-    _renderTimer.stop();
-    viewport()->setUpdatesEnabled(false);
-    clear();
-    dotStream = new QTextStream(&_unparsedOutput, QIODevice::ReadOnly);
+    QTextStream dotStream(&_unparsedOutput, QIODevice::ReadOnly);
 
     // First pass to adjust coordinate scaling by node height given from dot
     // Normal detail level (=1) should be 3 lines using general KDE font
     double nodeHeight = 0.0;
     while(1) {
-        line = dotStream->readLine();
+        line = dotStream.readLine();
         if (line.isNull()) break;
         if (line.isEmpty()) continue;
         QTextStream lineStream(&line, QIODevice::ReadOnly);
@@ -2217,10 +2396,10 @@ void CallGraphView::dotExited()
         scaleY = (8 + (1 + 2 * _detailLevel) * fontMetrics().height()) / nodeHeight;
         scaleX = 80;
     }
-    dotStream->seek(0);
+    dotStream.seek(0);
     int lineno = 0;
     while (1) {
-        line = dotStream->readLine();
+        line = dotStream.readLine();
         if (line.isNull())
             break;
 
@@ -2243,33 +2422,17 @@ void CallGraphView::dotExited()
             QString dotWidthString, dotHeightString;
             // scale will not be used
             lineStream >> scale >> dotWidthString >> dotHeightString;
-            dotWidth = dotWidthString.toDouble();
-            dotHeight = dotHeightString.toDouble();
-
-            if (!_scene) {
-                int w = (int)(scaleX * dotWidth);
-                int h = (int)(scaleY * dotHeight);
 
-                // We use as minimum canvas size the desktop size.
-                // Otherwise, the canvas would have to be resized on widget resize.
-                _xMargin = 50;
-                if (w < QApplication::primaryScreen()->size().width())
-                    _xMargin += (QApplication::primaryScreen()->size().width()-w)/2;
-
-                _yMargin = 50;
-                if (h < QApplication::primaryScreen()->size().height())
-                    _yMargin += (QApplication::primaryScreen()->size().height()-h)/2;
-
-                _scene = new QGraphicsScene( 0.0, 0.0,
-                                             qreal(w+2*_xMargin), qreal(h+2*_yMargin));
-                // Change background color for call graph from default system color to
-                // white. It has to blend into the gradient for the selected function.
-                _scene->setBackgroundBrush(Qt::white);
+            if (!graphFound) {
+                dotWidth = dotWidthString.toDouble();
+                dotHeight = dotHeightString.toDouble();
+                layout.setSize(QSizeF(scaleX * dotWidth, scaleY * dotHeight));
+                graphFound = true;
 
 #if DEBUG_GRAPH
                 qDebug() << qPrintable(_exporter.filename()) << ":" << lineno
                          << " - graph (" << dotWidth << " x " << dotHeight
-                         << ") => (" << w << " x " << h << ")";
+                         << ") => " << layout.size();
 #endif
             } else
                 qDebug() << "Ignoring 2nd 'graph' from dot ("
@@ -2284,7 +2447,7 @@ void CallGraphView::dotExited()
             continue;
         }
 
-        if (_scene == nullptr) {
+        if (!graphFound) {
             qDebug() << "Ignoring '"<< cmd
                      << "' without 'graph' from dot ("<< _exporter.filename()
                      << ":"<< lineno << ")";
@@ -2304,55 +2467,25 @@ void CallGraphView::dotExited()
 
             GraphNode* n = _exporter.node(_exporter.toFunc(nodeName));
 
-            int xx = (int)(scaleX * x + _xMargin);
-            int yy = (int)(scaleY * (dotHeight - y)+ _yMargin);
-            int w = (int)(scaleX * width);
-            int h = (int)(scaleY * height);
-
-#if DEBUG_GRAPH
-            qDebug() << _exporter.filename() << ":" << lineno
-                     << " - node '" << nodeName << "' ( "
-                     << x << "/" << y << " - "
-                     << width << "x" << height << " ) => ("
-                     << xx-w/2 << "/" << yy-h/2 << " - "
-                     << w << "x" << h << ")" << endl;
-#endif
-
             // Unnamed nodes with collapsed edges (with 'R' and 'S')
-            if (nodeName[0] == 'R'|| nodeName[0] == 'S') {
-                w = 10, h = 10;
-                eItem = new QGraphicsEllipseItem( QRectF(xx-w/2, yy-h/2, w, h) );
-                _scene->addItem(eItem);
-                eItem->setBrush(Qt::gray);
-                eItem->setZValue(1.0);
-                eItem->show();
-                continue;
-            }
-
-            if (!n) {
+            if (!n && (nodeName[0] != 'R') && (nodeName[0] != 'S')) {
                 qDebug("Warning: Unknown function '%s' ?!",
                        qPrintable(nodeName));
                 continue;
             }
-            n->setVisible(true);
-
-            rItem = new CanvasNode(this, n, xx-w/2, yy-h/2, w, h);
-            // limit symbol space to a maximal number of lines depending on detail level
-            if (_detailLevel>0) rItem->setMaxLines(0, 2*_detailLevel);
-            _scene->addItem(rItem);
-            n->setCanvasNode(rItem);
-
-            if (n) {
-                if (n->function() == activeItem())
-                    activeNode = n;
-                if (n->function() == selectedItem())
-                    _selectedNode = n;
-                rItem->setSelected(n == _selectedNode);
-            }
 
-            rItem->setZValue(1.0);
-            rItem->show();
+            QSizeF s(scaleX * width, scaleY * height);
+            int i = layout.addNode(nodeName, n, s);
+            QPointF center(scaleX * x, scaleY * (dotHeight - y));
+            layout.nodeAt(i).rect.moveCenter(center);
 
+#if DEBUG_GRAPH
+            qDebug() << _exporter.filename() << ":" << lineno
+                     << " - node '" << nodeName << "' ( "
+                     << x << "/" << y << " - "
+                     << width << "x" << height << " ) => "
+                     << layout.nodeAt(i).rect;
+#endif
             continue;
         }
 
@@ -2360,7 +2493,6 @@ void CallGraphView::dotExited()
 
         QString node1Name, node2Name, label, edgeX, edgeY;
         double x, y;
-        QPolygon poly;
         int points, i;
         lineStream >> node1Name >> node2Name >> points;
 
@@ -2372,30 +2504,22 @@ void CallGraphView::dotExited()
                      << ")";
             continue;
         }
-        e->setVisible(true);
-        if (e->fromNode())
-            e->fromNode()->addCallee(e);
-        if (e->toNode())
-            e->toNode()->addCaller(e);
 
         if (0)
             qDebug("  Edge with %d points:", points);
 
-        poly.resize(points);
+        QPolygonF poly(points);
         for (i=0; i<points; ++i) {
             if (lineStream.atEnd())
                 break;
             lineStream >> edgeX >> edgeY;
             x = edgeX.toDouble();
             y = edgeY.toDouble();
-
-            int xx = (int)(scaleX * x + _xMargin);
-            int yy = (int)(scaleY * (dotHeight - y)+ _yMargin);
+            poly[i] = QPointF(scaleX * x, scaleY * (dotHeight - y));
 
             if (0)
-                qDebug("   P %d: ( %f / %f ) => ( %d / %d)", i, x, y, xx, yy);
-
-            poly.setPoint(i, xx, yy);
+                qDebug("   P %d: ( %f / %f ) => ( %f / %f)", i, x, y,
+                       poly[i].x(), poly[i].y());
         }
         if (i < points) {
             qDebug("CallGraphView: Can not read %d spline points (%s:%d)",
@@ -2403,6 +2527,251 @@ void CallGraphView::dotExited()
             continue;
         }
 
+        int ei = layout.addEdge(e, layout.node(node1Name),
+                                layout.node(node2Name), false);
+        GraphLayout::Edge& edge = layout.edgeAt(ei);
+        edge.points = poly;
+
+        if (lineStream.atEnd())
+            continue;
+
+        // parse quoted label
+        QChar c;
+        lineStream >> c;
+        while (c.isSpace())
+            lineStream >> c;
+        if (c != '\"') {
+            lineStream >> label;
+            label = c + label;
+        } else {
+            lineStream >> c;
+            while (!c.isNull() && (c != '\"')) {
+                //if (c == '\\') lineStream >> c;
+
+                label += c;
+                lineStream >> c;
+            }
+        }
+        lineStream >> edgeX >> edgeY;
+        x = edgeX.toDouble();
+        y = edgeY.toDouble();
+
+        edge.hasLabel = true;
+        edge.labelPos = QPointF(scaleX * x, scaleY * (dotHeight - y));
+
+        if (0)
+            qDebug("   Label '%s': ( %f / %f ) => ( %f / %f)",
+                   qPrintable(label), x, y,
+                   edge.labelPos.x(), edge.labelPos.y());
+    }
+
+    return graphFound;
+}
+
+/* Lay out the visible part of the call graph in-process.
+ * If the visible graph did not change since the last layout (e.g. when
+ * only changing limits), the previous geometry is reused; otherwise,
+ * the previous layout gives the initial order of nodes.
+ */
+void CallGraphView::layoutGraph()
+{
+    _exporter.reset(_data, _activeItem, _eventType, _groupType);
+    _exporter.selectVisible();
+
+    // node sizes as for dot output scaled in parseDotOutput()
+    QFontMetrics fm = fontMetrics();
+    double nodeHeight = 8 + (1 + 2 * _detailLevel) * fm.height();
+
+    GraphLayout layout;
+    switch (_layout) {
+    case LeftRight:
+        layout.setMode(GraphLayout::LeftRight);
+        break;
+    case Circular:
+        layout.setMode(GraphLayout::Circular);
+        break;
+    default:
+        layout.setMode(GraphLayout::TopDown);
+        break;
+    }
+    layout.setSpacing(2 * fm.averageCharWidth(), nodeHeight / 2);
+    layout.setLabelSize(QSizeF(100, _detailLevel * 20));
+
+    QMap<TraceCostItem*, QList<GraphNode*> >::ConstIterator lit;
+    const QMap<TraceCostItem*, QList<GraphNode*> >& nodes = _exporter.visibleNodes();
+    int cluster = 0;
+    for (lit = nodes.constBegin(); lit != nodes.constEnd(); ++lit, cluster++) {
+        int c = (_clusterGroups && lit.key()) ? cluster : -1;
+        foreach(GraphNode* n, lit.value()) {
+            TraceFunction* f = n->function();
+            QString abr = GlobalConfig::shortenSymbol(f->prettyName());
+            // we want a minimal size for cost display
+            if ((int)abr.length() < 8) abr = abr + QString(8 - abr.length(),'_');
+            double w = fm.horizontalAdvance(abr) + 4 * fm.averageCharWidth();
+            layout.addNode(GraphExporter::nodeName(f), n, QSizeF(w, nodeHeight), c);
+        }
+    }
+    foreach(GraphEdge* e, _exporter.visibleEdges())
+        layout.addEdge(e, layout.node(GraphExporter::nodeName(e->from())),
+                       layout.node(GraphExporter::nodeName(e->to())));
+    foreach(GraphEdge* e, _exporter.skippedEdges()) {
+        QString point, node;
+        if (!e->from()) {
+            point = GraphExporter::nodeName(e->to(), QLatin1Char('R'));
+            node = GraphExporter::nodeName(e->to());
+        } else {
+            point = GraphExporter::nodeName(e->from(), QLatin1Char('S'));
+            node = GraphExporter::nodeName(e->from());
+        }
+        int p = layout.addNode(point, nullptr, QSizeF(10, 10));
+        if (!e->from())
+            layout.addEdge(e, p, layout.node(node));
+        else
+            layout.addEdge(e, layout.node(node), p);
+    }
+
+    TraceFunction* f = _exporter.centerFunction();
+    if (f)
+        layout.setCenter(layout.node(GraphExporter::nodeName(f)));
+
+    // revisited graphs are taken from the cache
+    QByteArray key = layout.signature();
+    const GraphLayout* cached = GraphLayoutCache::global()->find(key);
+    bool changed = layout.run(cached ? cached : &_graphLayout);
+    if (changed || !cached)
+        GraphLayoutCache::global()->insert(key, layout);
+    if (0) qDebug("CallGraphView::layoutGraph: %d nodes, %d edges%s",
+                  layout.nodeCount(), layout.edgeCount(),
+                  changed ? "" : " (unchanged)");
+    _graphLayout = layout;
+
+    showLayout(layout);
+}
+
+// Build the scene from a layouted graph
+void CallGraphView::showLayout(const GraphLayout& layout)
+{
+    CanvasNode *rItem;
+    QGraphicsEllipseItem* eItem;
+    CanvasEdge* sItem;
+    CanvasEdgeLabel* lItem;
+    GraphNode* activeNode = nullptr;
+    GraphEdge* activeEdge = nullptr;
+
+    _renderTimer.stop();
+    viewport()->setUpdatesEnabled(false);
+    clear();
+
+    {
+        int w = (int)layout.size().width();
+        int h = (int)layout.size().height();
+
+        // We use as minimum canvas size the desktop size.
+        // Otherwise, the canvas would have to be resized on widget resize.
+        _xMargin = 50;
+        if (w < QApplication::primaryScreen()->size().width())
+            _xMargin += (QApplication::primaryScreen()->size().width()-w)/2;
+
+        _yMargin = 50;
+        if (h < QApplication::primaryScreen()->size().height())
+            _yMargin += (QApplication::primaryScreen()->size().height()-h)/2;
+
+        _scene = new QGraphicsScene( 0.0, 0.0,
+                                     qreal(w+2*_xMargin), qreal(h+2*_yMargin));
+        // Change background color for call graph from default system color to
+        // white. It has to blend into the gradient for the selected function.
+        _scene->setBackgroundBrush(Qt::white);
+    }
+
+    QPointF margin(_xMargin, _yMargin);
+
+    for (int i = 0; i < layout.nodeCount(); i++) {
+        const GraphLayout::Node& node = layout.nodeAt(i);
+        GraphNode* n = node.node;
+
+        QPointF center = node.rect.center() + margin;
+        int xx = (int)center.x();
+        int yy = (int)center.y();
+        int w = (int)node.rect.width();
+        int h = (int)node.rect.height();
+
+        // Unnamed nodes with collapsed edges (with 'R' and 'S')
+        if (!n) {
+            if (node.name[0] == 'F')
+                continue;
+            w = 10, h = 10;
+            eItem = new QGraphicsEllipseItem( QRectF(xx-w/2, yy-h/2, w, h) );
+            _scene->addItem(eItem);
+            eItem->setBrush(Qt::gray);
+            eItem->setZValue(1.0);
+            eItem->show();
+            continue;
+        }
+        n->setVisible(true);
+
+        rItem = new CanvasNode(this, n, xx-w/2, yy-h/2, w, h);
+        // limit symbol space to a maximal number of lines depending on detail level
+        if (_detailLevel>0) rItem->setMaxLines(0, 2*_detailLevel);
+        _scene->addItem(rItem);
+        n->setCanvasNode(rItem);
+
+        if (n->function() == activeItem())
+            activeNode = n;
+        if (n->function() == selectedItem())
+            _selectedNode = n;
+        rItem->setSelected(n == _selectedNode);
+
+        rItem->setZValue(1.0);
+        rItem->show();
+    }
+
+    // boxes replacing the nodes of a group when zoomed out
+    if (_clusterGroups) {
+        QMap<TraceCostItem*, QList<GraphNode*> >::ConstIterator lit;
+        const QMap<TraceCostItem*, QList<GraphNode*> >& nodes = _exporter.visibleNodes();
+        for (lit = nodes.constBegin(); lit != nodes.constEnd(); ++lit) {
+            if (!lit.key())
+                continue;
+
+            QList<CanvasNode*> members;
+            QRectF r;
+            foreach(GraphNode* n, lit.value()) {
+                if (!n->canvasNode())
+                    continue;
+                members.append(n->canvasNode());
+                r |= n->canvasNode()->rect();
+            }
+            if (members.isEmpty())
+                continue;
+
+            CanvasCluster* cItem;
+            cItem = new CanvasCluster(r.adjusted(-5, -5, 5, 5),
+                                      lit.key()->prettyName(),
+                                      GlobalGUIConfig::groupColor(lit.key()));
+            _scene->addItem(cItem);
+            // below edges to not hide them from mouse clicks
+            cItem->setZValue(0.4);
+            cItem->setCollapsed(GraphLOD::isCollapsed(_zoomLevel));
+            foreach(CanvasNode* cn, members)
+                cn->setCluster(cItem);
+        }
+    }
+
+    for (int i = 0; i < layout.edgeCount(); i++) {
+        const GraphLayout::Edge& edge = layout.edgeAt(i);
+        GraphEdge* e = edge.edge;
+        int points = edge.points.count();
+        if (!e || (points < 2))
+            continue;
+
+        e->setVisible(true);
+        if (e->fromNode())
+            e->fromNode()->addCallee(e);
+        if (e->toNode())
+            e->toNode()->addCaller(e);
+
+        QPolygon poly = edge.points.translated(margin).toPolygon();
+
         // calls into/out of cycles are special: make them blue
         QColor arrowColor = Qt::black;
         TraceFunction* caller = e->fromNode() ? e->fromNode()->function() : nullptr;
@@ -2483,36 +2852,12 @@ void CallGraphView::dotExited()
             sItem->setArrow(aItem);
         }
 
-        if (lineStream.atEnd())
+        if (!edge.hasLabel)
             continue;
 
-        // parse quoted label
-        QChar c;
-        lineStream >> c;
-        while (c.isSpace())
-            lineStream >> c;
-        if (c != '\"') {
-            lineStream >> label;
-            label = c + label;
-        } else {
-            lineStream >> c;
-            while (!c.isNull() && (c != '\"')) {
-                //if (c == '\\') lineStream >> c;
-
-                label += c;
-                lineStream >> c;
-            }
-        }
-        lineStream >> edgeX >> edgeY;
-        x = edgeX.toDouble();
-        y = edgeY.toDouble();
-
-        int xx = (int)(scaleX * x + _xMargin);
-        int yy = (int)(scaleY * (dotHeight - y)+ _yMargin);
-
-        if (0)
-            qDebug("   Label '%s': ( %f / %f ) => ( %d / %d)",
-                   qPrintable(label), x, y, xx, yy);
+        QPointF labelPos = edge.labelPos + margin;
+        int xx = (int)labelPos.x();
+        int yy = (int)labelPos.y();
 
         // Fixed Dimensions for Label: 100 x 40
         int w = 100;
@@ -2524,21 +2869,12 @@ void CallGraphView::dotExited()
         sItem->setLabel(lItem);
         if (h>0)
             lItem->show();
-
     }
-    delete dotStream;
 
     // for keyboard navigation
     _exporter.sortEdges();
 
-    if (!_scene) {
-        _scene = new QGraphicsScene;
-
-        QString s = tr("Error running the graph layouting tool.\n");
-        s += tr("Please check that 'dot' is installed (package GraphViz).");
-        _scene->addSimpleText(s);
-        centerOn(0, 0);
-    } else if (!activeNode && !activeEdge) {
+    if (!activeNode && !activeEdge) {
         QString s = tr("There is no call graph available for function\n"
                        "\t'%1'\n"
                        "because it has no cost of the selected event type.")
@@ -2600,9 +2936,6 @@ void CallGraphView::dotExited()
 
     _scene->update();
     viewport()->setUpdatesEnabled(true);
-
-    delete _renderProcess;
-    _renderProcess = nullptr;
 }
 
 
@@ -2629,7 +2962,8 @@ void CallGraphView::wheelEvent(QWheelEvent* e)
     if (e->modifiers() & Qt::ControlModifier)
     {
         int angle = e->angleDelta().y();
-        if ((_zoomLevel <= 0.5 && angle < 0) || (_zoomLevel >= 1.3 && angle > 0))
+        if ((_zoomLevel <= GraphLOD::minZoom && angle < 0) ||
+            (_zoomLevel >= GraphLOD::maxZoom && angle > 0))
             return;
 
         const ViewportAnchor anchor = transformationAnchor();
@@ -2640,15 +2974,35 @@ void CallGraphView::wheelEvent(QWheelEvent* e)
         else
             factor = 0.9;
 
+        bool collapsed = GraphLOD::isCollapsed(_zoomLevel);
         scale(factor, factor);
         _zoomLevel = transform().m11();
         setTransformationAnchor(anchor);
+
+        if (_scene && (GraphLOD::isCollapsed(_zoomLevel) != collapsed)) {
+            QList<QGraphicsItem *> l = _scene->items();
+            for (int i = 0; i < l.size(); ++i)
+                if (l[i]->type() == CANVAS_CLUSTER)
+                    ((CanvasCluster*)l[i])->setCollapsed(!collapsed);
+        }
         return;
     }
     // Don't eat the event if we didn't hold 'ctrl'
     QGraphicsView::wheelEvent(e);
 }
 
+void CallGraphView::drawBackground(QPainter* p, const QRectF& r)
+{
+    _frameTime.begin();
+    QGraphicsView::drawBackground(p, r);
+}
+
+void CallGraphView::drawForeground(QPainter* p, const QRectF& r)
+{
+    QGraphicsView::drawForeground(p, r);
+    _frameTime.end(p);
+}
+
 
 void CallGraphView::zoomRectMoved(qreal dx, qreal dy)
 {
@@ -2978,6 +3332,13 @@ QMenu* CallGraphView::addLayoutMenu(QMenu* menu)
     addLayoutAction(m, tr("Top to Down"), TopDown);
     addLayoutAction(m, tr("Left to Right"), LeftRight);
     addLayoutAction(m, tr("Circular"), Circular);
+    m->addSeparator();
+
+    // data -1: not a layout
+    QAction* a = m->addAction(tr("Use Graphviz"));
+    a->setData(-1);
+    a->setCheckable(true);
+    a->setChecked(_useGraphviz);
 
     connect(m, &QMenu::triggered,
             this, &CallGraphView::layoutTriggered );
@@ -2988,7 +3349,11 @@ QMenu* CallGraphView::addLayoutMenu(QMenu* menu)
 
 void CallGraphView::layoutTriggered(QAction* a)
 {
-    _layout = (Layout) a->data().toInt(nullptr);
+    int l = a->data().toInt(nullptr);
+    if (l < 0)
+        _useGraphviz = !_useGraphviz;
+    else
+        _layout = (Layout) l;
     refresh();
 }
 
@@ -3097,6 +3462,10 @@ void CallGraphView::contextMenuEvent(QContextMenuEvent* e)
     QAction* layoutTall = vpopup->addAction(tr("Tall"));
     layoutTall->setCheckable(true);
     layoutTall->setChecked(_detailLevel == 2);
+    vpopup->addSeparator();
+    QAction* toggleFrameTime = vpopup->addAction(tr("Show Frame Time"));
+    toggleFrameTime->setCheckable(true);
+    toggleFrameTime->setChecked(_frameTime.isEnabled());
 
     addLayoutMenu(&popup);
     addZoomPosMenu(&popup);
@@ -3164,6 +3533,8 @@ void CallGraphView::contextMenuEvent(QContextMenuEvent* e)
         _detailLevel = 2;
         refresh();
     }
+    else if (a == toggleFrameTime)
+        _frameTime.setEnabled(!_frameTime.isEnabled());
 }
 
 
@@ -3217,6 +3588,7 @@ void CallGraphView::restoreOptions(const QString& prefix, const QString& postfix
     _detailLevel = g->value(QStringLiteral("DetailLevel"), DEFAULT_DETAILLEVEL).toInt();
     _layout = GraphOptions::layout(g->value(QStringLiteral("Layout"),
                                             layoutString(DEFAULT_LAYOUT)).toString());
+    _useGraphviz = g->value(QStringLiteral("UseGraphviz"), DEFAULT_USEGRAPHVIZ).toBool();
     _zoomPosition = zoomPos(g->value(QStringLiteral("ZoomPosition"),
                                      zoomPosString(DEFAULT_ZOOMPOS)).toString());
 
@@ -3236,6 +3608,7 @@ void CallGraphView::saveOptions(const QString& prefix, const QString& postfix)
     g->setValue(QStringLiteral("ClusterGroups"), _clusterGroups, DEFAULT_CLUSTERGROUPS);
     g->setValue(QStringLiteral("DetailLevel"), _detailLevel, DEFAULT_DETAILLEVEL);
     g->setValue(QStringLiteral("Layout"), layoutString(_layout), layoutString(DEFAULT_LAYOUT));
+    g->setValue(QStringLiteral("UseGraphviz"), _useGraphviz, DEFAULT_USEGRAPHVIZ);
     g->setValue(QStringLiteral("ZoomPosition"), zoomPosString(_zoomPosition),
                 zoomPosString(DEFAULT_ZOOMPOS));
 
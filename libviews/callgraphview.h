@@ -31,6 +31,8 @@
 #include <QContextMenuEvent>
 #include <QMouseEvent>
 
+#include "graphlayout.h"
+#include "graphlod.h"
 #include "treemap.h" // for DrawParams
 #include "tracedata.h"
 #include "traceitemview.h"
@@ -41,6 +43,7 @@ class QIODevice;
 
 class CanvasNode;
 class CanvasEdge;
+class CanvasCluster;
 class GraphEdge;
 class CallGraphView;
 
@@ -284,6 +287,9 @@ protected:
  *
  * Generates a graph file for "dot"
  * Create an instance and
+ *
+ * The visible part of the graph is also used directly for the
+ * in-process layout of CallGraphView (see GraphLayout).
  */
 class GraphExporter : public StorableGraphOptions
 {
@@ -323,6 +329,32 @@ public:
     // calls createGraph before dumping of not already created
     bool writeDot(QIODevice* = nullptr);
 
+    // Select nodes/edges to show according to limits (done once per graph)
+    void selectVisible();
+
+    // visible nodes, grouped by cost item for clustering
+    const QMap<TraceCostItem*, QList<GraphNode*> >& visibleNodes() const
+    {
+        return _visibleNodes;
+    }
+
+    const QList<GraphEdge*>& visibleEdges() const
+    {
+        return _visibleEdges;
+    }
+
+    // sums of skipped calls from (caller nullptr) or to (callee nullptr) nodes
+    const QList<GraphEdge*>& skippedEdges() const
+    {
+        return _skippedEdges;
+    }
+
+    // function in the center of a circular layout
+    TraceFunction* centerFunction();
+
+    // node name in a dot file: 'F' for functions, 'R'/'S' for skipped calls
+    static QString nodeName(TraceFunction*, QChar type = QLatin1Char('F'));
+
     // ephemeral save dialog and exporter
     static bool savePrompt(QWidget *, TraceData*, TraceFunction*,
                            EventType*, ProfileContext::Type,
@@ -353,7 +385,7 @@ private:
     ProfileContext::Type _groupType;
     QTemporaryFile* _tmpFile;
     double _realFuncLimit, _realCallLimit;
-    bool _graphCreated;
+    bool _graphCreated, _visibleSelected;
 
     GraphOptions* _go;
 
@@ -363,6 +395,10 @@ private:
     // graph parts written to file
     GraphNodeMap _nodeMap;
     GraphEdgeMap _edgeMap;
+
+    // visible parts, see selectVisible()
+    QMap<TraceCostItem*, QList<GraphNode*> > _visibleNodes;
+    QList<GraphEdge*> _visibleEdges, _skippedEdges;
 };
 
 
@@ -401,12 +437,15 @@ protected:
  * - CanvasEdgeLabel  (Label for edges)
  * - CanvasEdgeArrow  (Arrows at the end of the edge spline)
  * - CanvasFrame      (Grey background blending to show active node)
+ * - CanvasCluster    (Box for nodes of a cluster when zoomed out)
+ *
+ * Details are left out when items get small on screen, see GraphLOD.
  */
 
 enum {
     CANVAS_NODE = 1122,
     CANVAS_EDGE, CANVAS_EDGELABEL, CANVAS_EDGEARROW,
-    CANVAS_FRAME
+    CANVAS_FRAME, CANVAS_CLUSTER
 };
 
 class CanvasNode : public QGraphicsRectItem, public StoredDrawParams
@@ -423,6 +462,17 @@ public:
         return _node;
     }
 
+    // cluster box this node is collapsed into when zoomed out
+    CanvasCluster* cluster() const
+    {
+        return _cluster;
+    }
+
+    void setCluster(CanvasCluster* c)
+    {
+        _cluster = c;
+    }
+
     int type() const override
     {
         return CANVAS_NODE;
@@ -431,6 +481,7 @@ public:
 private:
     GraphNode* _node;
     CallGraphView* _view;
+    CanvasCluster* _cluster;
 };
 
 
@@ -521,6 +572,9 @@ public:
         return _edge;
     }
 
+    // true if edge is inside of a cluster collapsed at @p scale
+    bool isCollapsed(double scale);
+
     int type() const override
     {
         return CANVAS_EDGE;
@@ -531,6 +585,8 @@ private:
     CanvasEdgeLabel* _label;
     CanvasEdgeArrow* _arrow;
     QPolygon _points;
+    // path used when zoomed out
+    QPainterPath _simplePath;
 
     double _thickness;
 };
@@ -558,6 +614,26 @@ private:
 };
 
 
+class CanvasCluster : public QGraphicsRectItem
+{
+public:
+    CanvasCluster(const QRectF&, const QString& name, const QColor&);
+
+    int type() const override
+    {
+        return CANVAS_CLUSTER;
+    }
+
+    void paint(QPainter*, const QStyleOptionGraphicsItem*, QWidget*) override;
+
+    // set by the view on zoom changes
+    void setCollapsed(bool);
+
+private:
+    QString _name;
+};
+
+
 class CallGraphTip;
 
 /**
@@ -626,12 +702,18 @@ protected:
     void focusOutEvent(QFocusEvent*) override;
     void scrollContentsBy(int dx, int dy) override;
 	void wheelEvent(QWheelEvent*) override;
+    void drawBackground(QPainter*, const QRectF&) override;
+    void drawForeground(QPainter*, const QRectF&) override;
 
 private:
     void updateSizes(QSize s = QSize(0,0));
     CostItem* canShow(CostItem*) override;
     void doUpdate(int, bool) override;
     void refresh();
+    void layoutGraph();
+    bool parseDotOutput(GraphLayout&);
+    void bindLayout(GraphLayout&);
+    void showLayout(const GraphLayout&);
     void makeFrame(CanvasNode*, bool active);
     void clear();
     void showText(QString);
@@ -666,13 +748,20 @@ private:
     GraphEdge* _selectedEdge;
 
     qreal _zoomLevel = 1;
+    FrameTimeOverlay _frameTime;
 
     // widget options
     ZoomPosition _zoomPosition, _lastAutoPosition;
 
-    // background rendering
+    // in-process layout, kept for incremental re-layout
+    GraphLayout _graphLayout;
+
+    // background rendering with Graphviz
+    bool _useGraphviz;
     QProcess* _renderProcess;
     QString _renderProcessCmdLine;
+    // cache key for layout of running process
+    QByteArray _renderKey;
     QTimer _renderTimer;
     GraphNode* _prevSelectedNode;
     QPoint _prevSelectedPos;
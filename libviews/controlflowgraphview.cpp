@@ -28,6 +28,7 @@
 #include <QGraphicsView>
 #include <QResizeEvent>
 #include <QMouseEvent>
+#include <QWheelEvent>
 #include <QPoint>
 #include <QSize>
 #include <QTransform>
@@ -1505,7 +1506,7 @@ CanvasCFGNode::CanvasCFGNode(ControlFlowGraphView* view, CFGNode* node,
     setZValue(1.0);
 }
 
-void CanvasCFGNode::paint(QPainter* p, const QStyleOptionGraphicsItem*, QWidget*)
+void CanvasCFGNode::paint(QPainter* p, const QStyleOptionGraphicsItem* option, QWidget*)
 {
     const QRectF r = rect();
     const bool reduced = _view->isReduced(_node);
@@ -1516,6 +1517,17 @@ void CanvasCFGNode::paint(QPainter* p, const QStyleOptionGraphicsItem*, QWidget*
     qreal topLineY = r.y();
     p->fillRect(r.x() + 1, topLineY + 1, r.width(), step * 2, Qt::gray);
 
+    // only the outline when zoomed out: text and instruction rows
+    // would not be readable
+    if (!GraphLOD::showText(GraphLOD::scale(option, p), _view->fontMetrics().height()))
+    {
+        if (isSelected())
+            p->setPen(QPen{Qt::darkGreen, 2});
+
+        p->drawRect(r);
+        return;
+    }
+
     QString cost;
     if (GlobalConfig::showPercentage())
     {
@@ -1603,8 +1615,11 @@ CanvasCFGEdgeLabel::CanvasCFGEdgeLabel(CanvasCFGEdge* ce, qreal x, qreal y, qrea
     setZValue(1.5);
 }
 
-void CanvasCFGEdgeLabel::paint(QPainter* p, const QStyleOptionGraphicsItem*, QWidget*)
+void CanvasCFGEdgeLabel::paint(QPainter* p, const QStyleOptionGraphicsItem* option, QWidget*)
 {
+    if (!GraphLOD::showText(GraphLOD::scale(option, p), p->fontMetrics().height()))
+        return;
+
     p->drawText(rect(), Qt::AlignCenter, _label);
 }
 
@@ -1620,8 +1635,12 @@ CanvasCFGEdgeArrow::CanvasCFGEdgeArrow(CanvasCFGEdge* ce, const QPolygon& arrow)
     setZValue(1.5);
 }
 
-void CanvasCFGEdgeArrow::paint(QPainter* p, const QStyleOptionGraphicsItem*, QWidget*)
+void CanvasCFGEdgeArrow::paint(QPainter* p, const QStyleOptionGraphicsItem* option, QWidget*)
 {
+    // too small to be seen when zoomed out
+    if (GraphLOD::isSimple(GraphLOD::scale(option, p)))
+        return;
+
     p->setRenderHint(QPainter::Antialiasing);
     p->setBrush(Qt::black);
     p->drawPolygon(polygon(), Qt::OddEvenFill);
@@ -1644,6 +1663,7 @@ CanvasCFGEdge::CanvasCFGEdge(CFGEdge* e, const QPolygon& poly, const QColor& edg
         path.cubicTo(_points[i], _points[(i + 1) % nPoints], _points[(i + 2) % nPoints]);
 
     setPath(path);
+    _simplePath = GraphLOD::simplePath(_points);
     setPen(QPen{edgeColor});
     setFlag(QGraphicsItem::ItemIsSelectable);
     setZValue(0.5);
@@ -1651,15 +1671,19 @@ CanvasCFGEdge::CanvasCFGEdge(CFGEdge* e, const QPolygon& poly, const QColor& edg
 
 void CanvasCFGEdge::paint(QPainter* p, const QStyleOptionGraphicsItem* option, QWidget*)
 {
-    qreal levelOfDetail = option->levelOfDetailFromTransform(p->transform());
+    qreal levelOfDetail = GraphLOD::scale(option, p);
 
     static constexpr double thickness = 0.9;
 
+    // when zoomed out, polylines without antialiasing are good enough
+    const bool simple = GraphLOD::isSimple(levelOfDetail);
+
     QPen mypen = pen();
     mypen.setWidthF(isSelected() ? 2.0 : thickness / levelOfDetail);
-    p->setRenderHint(QPainter::Antialiasing);
+    if (!simple)
+        p->setRenderHint(QPainter::Antialiasing);
     p->setPen(mypen);
-    p->drawPath(path());
+    p->drawPath(simple ? _simplePath : path());
 }
 
 // ======================================================================================
@@ -1670,7 +1694,7 @@ void CanvasCFGEdge::paint(QPainter* p, const QStyleOptionGraphicsItem* option, Q
 
 ControlFlowGraphView::ControlFlowGraphView(TraceItemView* parentView, QWidget* parent,
                                            const QString& name)
-    : QGraphicsView{parent}, TraceItemView{parentView}
+    : QGraphicsView{parent}, TraceItemView{parentView}, _frameTime{this}
 {
     setObjectName(name);
     setWhatsThis(whatsThis());
@@ -2373,6 +2397,8 @@ enum MenuActions
 
     useIntelSyntax,
 
+    showFrameTime,
+
     // special value
     nActions
 };
@@ -2455,6 +2481,12 @@ void ControlFlowGraphView::contextMenuEvent(QContextMenuEvent* event)
     addLayoutMenu(popup);
     addZoomPosMenu(popup);
 
+    popup.addSeparator();
+
+    actions[MenuActions::showFrameTime] = popup.addAction(QObject::tr("Show Frame Time"));
+    actions[MenuActions::showFrameTime]->setCheckable(true);
+    actions[MenuActions::showFrameTime]->setChecked(_frameTime.isEnabled());
+
     QAction* action = popup.exec(event->globalPos());
     const auto index = std::distance(actions.begin(),
                                      std::find(actions.begin(), actions.end(), action));
@@ -2549,6 +2581,10 @@ void ControlFlowGraphView::contextMenuEvent(QContextMenuEvent* event)
             break;
         }
 
+        case MenuActions::showFrameTime:
+            _frameTime.setEnabled(action->isChecked());
+            break;
+
         default: // practically nActions
             break;
     }
@@ -2715,6 +2751,40 @@ void ControlFlowGraphView::scrollContentsBy(int dx, int dy)
     _panningView->setZoomRect(QRectF{topLeft, bottomRight});
 }
 
+// Handles zooming in and out with 'ctrl + mouse-wheel-up/down'
+void ControlFlowGraphView::wheelEvent(QWheelEvent* e)
+{
+    if (!(e->modifiers() & Qt::ControlModifier))
+    {
+        QGraphicsView::wheelEvent(e);
+        return;
+    }
+
+    const int angle = e->angleDelta().y();
+    const qreal zoom = transform().m11();
+    if ((zoom <= GraphLOD::minZoom && angle < 0) ||
+        (zoom >= GraphLOD::maxZoom && angle > 0))
+        return;
+
+    const ViewportAnchor anchor = transformationAnchor();
+    setTransformationAnchor(QGraphicsView::AnchorViewCenter);
+    const qreal factor = (angle > 0) ? 1.1 : 0.9;
+    scale(factor, factor);
+    setTransformationAnchor(anchor);
+}
+
+void ControlFlowGraphView::drawBackground(QPainter* p, const QRectF& r)
+{
+    _frameTime.begin();
+    QGraphicsView::drawBackground(p, r);
+}
+
+void ControlFlowGraphView::drawForeground(QPainter* p, const QRectF& r)
+{
+    QGraphicsView::drawForeground(p, r);
+    _frameTime.end(p);
+}
+
 namespace
 {
 
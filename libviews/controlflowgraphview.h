@@ -33,6 +33,7 @@
 
 #include "traceitemview.h"
 #include "callgraphview.h"
+#include "graphlod.h"
 #include "tracedata.h"
 #include "config.h"
 
@@ -395,6 +396,8 @@ public:
 private:
     CFGEdge* _edge;
     QPolygon _points;
+    // path used when zoomed out
+    QPainterPath _simplePath;
 };
 
 
@@ -453,6 +456,9 @@ protected:
     void exportGraphAsImage();
     void keyPressEvent(QKeyEvent*) override;
     void scrollContentsBy(int dx, int dy) override;
+    void wheelEvent(QWheelEvent*) override;
+    void drawBackground(QPainter*, const QRectF&) override;
+    void drawForeground(QPainter*, const QRectF&) override;
 
 private:
     void mouseEvent(void (TraceItemView::* func)(CostItem*), QGraphicsItem* item);
@@ -511,6 +517,7 @@ private:
     ZoomPosition _lastAutoPosition = ZoomPosition::TopLeft;
 
     CFGExporter _exporter;
+    FrameTimeOverlay _frameTime;
 
     CFGNode* _selectedNode = nullptr;
     CFGNode* _prevSelectedNode = nullptr;
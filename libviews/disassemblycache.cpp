@@ -0,0 +1,312 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Cache for output of objdump
+ */
+
+#include "disassemblycache.h"
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// memory for output of objdump, in KB
+#define CACHE_MAXCOST  (64*1024)
+// disk entries not used for this number of days are removed
+#define CACHE_MAXAGE   30
+// disk space for output of objdump, in MB; least recently used is removed
+#define CACHE_MAXDISK  256
+
+// objdump is given up after RUN_TIMEOUT ms; cancellation is checked
+// every RUN_CHECKINTERVAL ms
+#define RUN_TIMEOUT       30000
+#define RUN_CHECKINTERVAL 100
+
+
+struct DisassemblyCache::Object {
+    // hash of objdump format, file name, size and modification time
+    QByteArray key;
+    // ranges cached in memory or on disk
+    QList<Range> ranges;
+    bool prefetched;
+};
+
+static QString rangeName(const DisassemblyCache::Range& r)
+{
+    return QStringLiteral("%1-%2").arg(r.first.toString(), r.second.toString());
+}
+
+
+//---------------------------------------------------
+// DisassemblyCache
+
+DisassemblyCache* DisassemblyCache::global()
+{
+    static DisassemblyCache* cache = new DisassemblyCache;
+    return cache;
+}
+
+DisassemblyCache::DisassemblyCache()
+{
+    _output.setMaxCost(CACHE_MAXCOST);
+    _pool.setMaxThreadCount(1);
+    // on exit, do not start prefetching, and kill a running objdump
+    if (qApp)
+        QObject::connect(qApp, &QCoreApplication::aboutToQuit, [this]() {
+            _canceled.storeRelaxed(1);
+            _pool.clear();
+            _pool.waitForDone();
+        });
+
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!dir.isEmpty() && QDir().mkpath(dir + QStringLiteral("/disassembly")))
+        _dir = dir + QStringLiteral("/disassembly");
+    prune();
+}
+
+QString DisassemblyCache::command(const QString& format, const QString& objfile,
+                                  Addr start, Addr end)
+{
+    return format.arg(start.toString(), end.toString(), objfile);
+}
+
+DisassemblyCache::Object* DisassemblyCache::object(const QString& format,
+                                                   const QString& objfile)
+{
+    QFileInfo fi(objfile);
+    if (!fi.exists()) return nullptr;
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(format.toUtf8());
+    hash.addData(QByteArray(1, '\n'));
+    hash.addData(fi.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(fi.size()) + '\n');
+    hash.addData(QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+    QByteArray key = hash.result().toHex();
+
+    Object* o = _objects.value(key, nullptr);
+    if (o) return o;
+
+    o = new Object;
+    o->key = key;
+    o->prefetched = false;
+    _objects.insert(key, o);
+
+    // ranges cached on disk by earlier sessions
+    if (!_dir.isEmpty()) {
+        QDir d(_dir + '/' + QString::fromLatin1(key));
+        foreach(const QString& name, d.entryList(QDir::Files)) {
+            QByteArray s = name.toLatin1();
+            int sep = s.indexOf('-');
+            if (sep <= 0) continue;
+            Range r;
+            if (r.first.set(s.constData()) != sep) continue;
+            if (r.second.set(s.constData() + sep + 1) != s.length() - sep - 1)
+                continue;
+            o->ranges.append(r);
+        }
+    }
+
+    if (0) qDebug("DisassemblyCache: %s for '%s', %d ranges on disk",
+                  key.constData(), qPrintable(objfile), (int)o->ranges.count());
+    return o;
+}
+
+bool DisassemblyCache::find(Object* o, Addr start, Addr end, Range& range)
+{
+    bool found = false;
+    foreach(const Range& r, o->ranges) {
+        if ((r.first > start) || (r.second < end)) continue;
+        // smallest range containing [start; end]
+        if (found && (r.second.v() - r.first.v() >=
+                      range.second.v() - range.first.v())) continue;
+        range = r;
+        found = true;
+    }
+    return found;
+}
+
+bool DisassemblyCache::load(Object* o, const Range& r, QByteArray& output)
+{
+    QByteArray key = o->key + '/' + rangeName(r).toLatin1();
+    QByteArray* data = _output.object(key);
+    if (data) {
+        output = *data;
+        return true;
+    }
+
+    if (_dir.isEmpty()) {
+        o->ranges.removeAll(r);
+        return false;
+    }
+
+    QFile file(_dir + '/' + QString::fromLatin1(key));
+    if (file.open(QIODevice::ReadOnly))
+        output = qUncompress(file.readAll());
+    if (output.isEmpty()) {
+        // broken entry
+        o->ranges.removeAll(r);
+        file.remove();
+        return false;
+    }
+    // modification time is time of last use, see prune()
+    file.setFileTime(QDateTime::currentDateTime(),
+                     QFileDevice::FileModificationTime);
+
+    _output.insert(key, new QByteArray(output), output.size() / 1024 + 1);
+    return true;
+}
+
+void DisassemblyCache::store(Object* o, const Range& r, const QByteArray& output)
+{
+    if (output.isEmpty()) return;
+
+    if (!o->ranges.contains(r))
+        o->ranges.append(r);
+    QByteArray key = o->key + '/' + rangeName(r).toLatin1();
+    _output.insert(key, new QByteArray(output), output.size() / 1024 + 1);
+
+    if (_dir.isEmpty()) return;
+
+    QDir().mkpath(_dir + '/' + QString::fromLatin1(o->key));
+    QSaveFile file(_dir + '/' + QString::fromLatin1(key));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(qCompress(output));
+        file.commit();
+    }
+}
+
+bool DisassemblyCache::run(const QString& command, QByteArray& output)
+{
+    qDebug("Running '%s'...", qPrintable(command));
+
+    QProcess objdump;
+    objdump.startCommand(command);
+    if (!objdump.waitForStarted()) return false;
+
+    // wait in steps to check for cancellation: the process is killed by
+    // the thread owning it, as QProcess is not thread-safe
+    QElapsedTimer timer;
+    timer.start();
+    while (!objdump.waitForFinished(RUN_CHECKINTERVAL)) {
+        if ((objdump.state() == QProcess::NotRunning) ||
+            _canceled.loadRelaxed() || timer.hasExpired(RUN_TIMEOUT)) {
+            objdump.kill();
+            objdump.waitForFinished();
+            return false;
+        }
+    }
+
+    output = objdump.readAllStandardOutput();
+    return true;
+}
+
+bool DisassemblyCache::dump(const QString& format, const QString& objfile,
+                            Addr start, Addr end,
+                            QByteArray& output, QString& cmd)
+{
+    cmd = command(format, objfile, start, end);
+
+    {
+        QMutexLocker locker(&_mutex);
+        Object* o = object(format, objfile);
+        Range r;
+        if (o && find(o, start, end, r) && load(o, r, output)) {
+            if (0) qDebug("DisassemblyCache: 0x%s-0x%s found in %s",
+                          qPrintable(start.toString()), qPrintable(end.toString()),
+                          qPrintable(rangeName(r)));
+            return true;
+        }
+    }
+
+    if (!run(cmd, output)) return false;
+
+    QMutexLocker locker(&_mutex);
+    Object* o = object(format, objfile);
+    if (o) store(o, Range(start, end), output);
+    return true;
+}
+
+void DisassemblyCache::prefetch(const QString& format, const QString& objfile,
+                                const QList<Range>& ranges)
+{
+    QMutexLocker locker(&_mutex);
+    Object* o = object(format, objfile);
+    if (!o || o->prefetched) return;
+    o->prefetched = true;
+
+    QList<Range> todo;
+    Range found;
+    foreach(const Range& r, ranges)
+        if (!find(o, r.first, r.second, found))
+            todo.append(r);
+    if (todo.isEmpty()) return;
+
+    _pool.start([this, format, objfile, todo]() {
+        foreach(const Range& r, todo) {
+            if (_canceled.loadRelaxed()) return;
+
+            {
+                QMutexLocker locker(&_mutex);
+                Object* o = object(format, objfile);
+                Range found;
+                // object changed on disk, or range was shown meanwhile
+                if (!o || find(o, r.first, r.second, found)) continue;
+            }
+
+            QByteArray output;
+            if (!run(command(format, objfile, r.first, r.second), output))
+                return;
+
+            QMutexLocker locker(&_mutex);
+            Object* o = object(format, objfile);
+            if (o) store(o, r, output);
+        }
+    });
+}
+
+void DisassemblyCache::prune()
+{
+    if (_dir.isEmpty()) return;
+
+    // entries of all objects, least recently used first
+    QFileInfoList entries;
+    QDir d(_dir);
+    foreach(const QFileInfo& fi, d.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot))
+        entries += QDir(fi.absoluteFilePath()).entryInfoList(QDir::Files);
+    std::sort(entries.begin(), entries.end(),
+              [](const QFileInfo& a, const QFileInfo& b) {
+        return a.lastModified() < b.lastModified();
+    });
+
+    qint64 size = 0;
+    foreach(const QFileInfo& fi, entries)
+        size += fi.size();
+
+    QDateTime limit = QDateTime::currentDateTime().addDays(-CACHE_MAXAGE);
+    foreach(const QFileInfo& fi, entries) {
+        if ((fi.lastModified() >= limit) &&
+            (size <= (qint64) CACHE_MAXDISK * 1024 * 1024)) break;
+        QFile::remove(fi.absoluteFilePath());
+        size -= fi.size();
+    }
+
+    // directories of objects without entries left
+    foreach(const QFileInfo& fi, d.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot))
+        d.rmdir(fi.fileName());
+}
@@ -0,0 +1,93 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Cache for output of objdump
+ */
+
+#ifndef DISASSEMBLYCACHE_H
+#define DISASSEMBLYCACHE_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QThreadPool>
+
+#include "addr.h"
+
+/**
+ * Output of objdump for address ranges of ELF objects, kept in memory
+ * and on disk, so that machine code of functions shown before, also
+ * in earlier sessions, does not need objdump to be run again.
+ *
+ * Entries are found by the objdump command (a format whose remaining
+ * placeholders are for start address, end address and object file),
+ * the object file with its size and modification time, and the
+ * address range. Output for a range also is used for ranges
+ * contained in it: lines outside of the wanted range are to be
+ * skipped by the caller.
+ *
+ * Disassembly of given ranges, e.g. for the hottest functions of an
+ * object, can be prefetched in a background thread. Only one objdump
+ * runs at a time for prefetching.
+ */
+class DisassemblyCache
+{
+public:
+    typedef QPair<Addr, Addr> Range;
+
+    static DisassemblyCache* global();
+
+    /**
+     * Sets @p output to the output of objdump for range
+     * [@p start; @p end] of @p objfile, running objdump if not
+     * cached. Returns false if objdump could not be run. @p command
+     * is set to the command line used for the range.
+     */
+    bool dump(const QString& format, const QString& objfile,
+              Addr start, Addr end, QByteArray& output, QString& command);
+
+    // run objdump for @p ranges not cached yet in the background
+    void prefetch(const QString& format, const QString& objfile,
+                  const QList<Range>& ranges);
+
+private:
+    struct Object;
+
+    DisassemblyCache();
+
+    // Object for current version of @p objfile, or nullptr if not found
+    Object* object(const QString& format, const QString& objfile);
+    // cached range containing [start; end], or false if not cached
+    bool find(Object*, Addr start, Addr end, Range& range);
+    bool load(Object*, const Range&, QByteArray& output);
+    void store(Object*, const Range&, const QByteArray& output);
+    // run objdump, killed if running on exit
+    bool run(const QString& command, QByteArray& output);
+    static QString command(const QString& format, const QString& objfile,
+                           Addr start, Addr end);
+    // remove disk entries not used for a long time, and limit disk usage
+    void prune();
+
+    // protects all members below, used by prefetch thread
+    QMutex _mutex;
+    QHash<QByteArray, Object*> _objects;
+    // output of ranges, by key of object and range; cost in KB
+    QCache<QByteArray, QByteArray> _output;
+    // directory for disk cache, empty if not available
+    QString _dir;
+
+    QThreadPool _pool;
+    // set on exit, to stop prefetching
+    QAtomicInt _canceled;
+};
+
+#endif // DISASSEMBLYCACHE_H
@@ -8,8 +8,11 @@
 
 #include "functionlistmodel.h"
 
+#include <numeric>
+
 #include "globalguiconfig.h"
 #include "listutils.h"
+#include "costcolumns.h"
 
 /* helper for setting function filter: we want it to work similar to globbing:
  * - escape most special characters in regexps: ( ) [ ] | . \
@@ -325,7 +328,32 @@ void FunctionListModel::computeTopList()
     }
 
     FunctionLessThan lessThan(_sortColumn, _sortOrder, _eventType);
-    std::stable_sort(_filteredList.begin(), _filteredList.end(), lessThan);
+    if ((_sortColumn <= 1) && _eventType) {
+        // sort by cost: calculate costs of all functions once, column-wise,
+        // instead of twice per comparison
+        int count = _filteredList.count();
+        CostColumns columns(_eventType->set(), count);
+        for (int i = 0; i < count; i++) {
+            TraceFunction* f = _filteredList[i];
+            columns.set(i, (_sortColumn == 0) ? f->inclusive() : f);
+        }
+        QVector<SubCost> costs = columns.subCosts(_eventType);
+
+        QVector<int> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        bool descending = (_sortOrder == Qt::DescendingOrder);
+        std::stable_sort(order.begin(), order.end(), [&](int i1, int i2) {
+            return descending ? (costs[i2] < costs[i1]) : (costs[i1] < costs[i2]);
+        });
+
+        QList<TraceFunction*> sorted;
+        sorted.reserve(count);
+        foreach(int i, order)
+            sorted.append(_filteredList[i]);
+        _filteredList = sorted;
+    }
+    else
+        std::stable_sort(_filteredList.begin(), _filteredList.end(), lessThan);
 
     foreach(TraceFunction* f, _filteredList) {
         _topList.append(f);
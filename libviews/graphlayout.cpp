@@ -0,0 +1,849 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Layout of call graphs
+ */
+
+#include "graphlayout.h"
+
+#include <math.h>
+#include <limits.h>
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QPair>
+
+
+// helpers
+
+static QPointF swapped(const QPointF& p)
+{
+    return QPointF(p.y(), p.x());
+}
+
+static QRectF swapped(const QRectF& r)
+{
+    return QRectF(swapped(r.topLeft()), QSizeF(r.height(), r.width()));
+}
+
+// straight edge as cubic bezier spline
+static QPolygonF straightSpline(const QPointF& from, const QPointF& to)
+{
+    QPolygonF pts;
+    QPointF d = (to - from) / 3;
+    pts << from << from + d << to - d << to;
+    return pts;
+}
+
+// point on the border of @p r on the line from its center towards @p to
+static QPointF borderPoint(const QRectF& r, const QPointF& to)
+{
+    QPointF c = r.center();
+    QPointF d = to - c;
+    double s = 1.0;
+    if (fabs(d.x()) * r.height() > fabs(d.y()) * r.width())
+        s = r.width() / 2 / fabs(d.x());
+    else if (d.y() != 0)
+        s = r.height() / 2 / fabs(d.y());
+    return c + d * qMin(s, 1.0);
+}
+
+// Weight for aligning neighbors in adjacent layers: prefer long edges
+// (between dummy nodes) to be straight
+static double alignWeight(int v, int w, int nodes)
+{
+    if ((v >= nodes) && (w >= nodes)) return 8.0;
+    if ((v >= nodes) || (w >= nodes)) return 2.0;
+    return 1.0;
+}
+
+/* Replace @p t by nondecreasing values minimizing the weighted squared
+ * distance to the original values (pool adjacent violators)
+ */
+static void isotonic(QVector<double>& t, const QVector<double>& weight)
+{
+    QVector<double> value, sum;
+    QVector<int> count;
+    for (int i = 0; i < t.count(); i++) {
+        value.append(t[i]);
+        sum.append(weight[i]);
+        count.append(1);
+        int last = value.count() - 1;
+        while ((last > 0) && (value[last-1] > value[last])) {
+            double s = sum[last-1] + sum[last];
+            value[last-1] = (value[last-1] * sum[last-1] +
+                             value[last] * sum[last]) / s;
+            sum[last-1] = s;
+            count[last-1] += count[last];
+            value.removeLast();
+            sum.removeLast();
+            count.removeLast();
+            last--;
+        }
+    }
+    int i = 0;
+    for (int b = 0; b < value.count(); b++)
+        for (int k = 0; k < count[b]; k++)
+            t[i++] = value[b];
+}
+
+/* Sort nodes of a layer by barycenter of positions of their neighbors
+ * in the adjacent layer. Nodes of a cluster are sorted by the average
+ * barycenter of the cluster first, to keep them together.
+ */
+struct OrderItem {
+    double clusterKey, key;
+    int v;
+
+    bool operator<(const OrderItem& o) const
+    {
+        if (clusterKey != o.clusterKey) return clusterKey < o.clusterKey;
+        return key < o.key;
+    }
+};
+
+static void orderLayer(QVector<int>& layer,
+                       const QVector<QVector<int> >& neighbors,
+                       QVector<int>& pos, const QVector<int>& cluster)
+{
+    int count = layer.count();
+    QVector<OrderItem> items(count);
+    QHash<int, QPair<double, int> > clusterSum;
+    for (int i = 0; i < count; i++) {
+        int v = layer[i];
+        double key = i;
+        if (!neighbors[v].isEmpty()) {
+            key = 0.0;
+            foreach(int w, neighbors[v])
+                key += pos[w];
+            key /= neighbors[v].count();
+        }
+        items[i].key = key;
+        items[i].v = v;
+        if (cluster[v] >= 0) {
+            QPair<double, int>& s = clusterSum[cluster[v]];
+            s.first += key;
+            s.second++;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        int c = cluster[items[i].v];
+        if (c < 0)
+            items[i].clusterKey = items[i].key;
+        else {
+            const QPair<double, int>& s = clusterSum[c];
+            items[i].clusterKey = s.first / s.second;
+        }
+    }
+    std::stable_sort(items.begin(), items.end());
+    for (int i = 0; i < count; i++) {
+        layer[i] = items[i].v;
+        pos[items[i].v] = i;
+    }
+}
+
+// number of edge crossings between all adjacent layers
+static int crossings(const QVector<QVector<int> >& layers,
+                     const QVector<QVector<int> >& down,
+                     const QVector<int>& pos)
+{
+    int res = 0;
+    QVector<QPair<int, int> > edges;
+    QVector<int> tree;
+    for (int l = 0; l + 1 < layers.count(); l++) {
+        edges.clear();
+        foreach(int v, layers[l])
+            foreach(int w, down[v])
+                edges.append(qMakePair(pos[v], pos[w]));
+        std::sort(edges.begin(), edges.end());
+
+        // edges crossing an edge have a start before and an end behind it;
+        // count these with a Fenwick tree over end positions
+        int size = layers[l+1].count();
+        tree.fill(0, size + 1);
+        for (int i = 0; i < edges.count(); i++) {
+            int p = edges[i].second + 1;
+            int before = 0;
+            for (int j = p; j > 0; j -= j & -j)
+                before += tree[j];
+            res += i - before;
+            for (int j = p; j <= size; j += j & -j)
+                tree[j]++;
+        }
+    }
+    return res;
+}
+
+
+//---------------------------------------------------
+// GraphLayout
+
+GraphLayout::GraphLayout()
+{
+    _mode = TopDown;
+    _nodeSep = 20.0;
+    _rankSep = 40.0;
+    _center = 0;
+}
+
+void GraphLayout::clear()
+{
+    _nodes.clear();
+    _edges.clear();
+    _index.clear();
+    _size = QSizeF();
+}
+
+void GraphLayout::setSpacing(double nodeSep, double rankSep)
+{
+    _nodeSep = nodeSep;
+    _rankSep = rankSep;
+}
+
+int GraphLayout::addNode(const QString& name, GraphNode* n, const QSizeF& s,
+                         int cluster)
+{
+    Node node;
+    node.name = name;
+    node.node = n;
+    node.rect = QRectF(QPointF(0, 0), s);
+    node.cluster = cluster;
+    _index.insert(name, _nodes.count());
+    _nodes.append(node);
+    return _nodes.count() - 1;
+}
+
+int GraphLayout::addEdge(GraphEdge* e, int from, int to, bool hasLabel)
+{
+    Edge edge;
+    edge.edge = e;
+    edge.from = from;
+    edge.to = to;
+    edge.hasLabel = hasLabel;
+    _edges.append(edge);
+    return _edges.count() - 1;
+}
+
+int GraphLayout::node(const QString& name) const
+{
+    return _index.value(name, -1);
+}
+
+bool GraphLayout::sameGraph(const GraphLayout& l) const
+{
+    if ((_mode != l._mode) || (_nodeSep != l._nodeSep) ||
+        (_rankSep != l._rankSep) || (_labelSize != l._labelSize) ||
+        (_center != l._center) ||
+        (_nodes.count() != l._nodes.count()) ||
+        (_edges.count() != l._edges.count()))
+        return false;
+
+    for (int i = 0; i < _nodes.count(); i++) {
+        const Node& n1 = _nodes[i];
+        const Node& n2 = l._nodes[i];
+        if ((n1.name != n2.name) || (n1.cluster != n2.cluster) ||
+            (n1.rect.size() != n2.rect.size()))
+            return false;
+    }
+    for (int i = 0; i < _edges.count(); i++) {
+        const Edge& e1 = _edges[i];
+        const Edge& e2 = l._edges[i];
+        if ((e1.from != e2.from) || (e1.to != e2.to) ||
+            (e1.hasLabel != e2.hasLabel))
+            return false;
+    }
+    return true;
+}
+
+QByteArray GraphLayout::signature() const
+{
+    QByteArray data;
+    QDataStream s(&data, QIODevice::WriteOnly);
+    s << (int)_mode << _nodeSep << _rankSep << _labelSize << _center;
+    foreach(const Node& n, _nodes)
+        s << n.name << n.rect.size() << n.cluster;
+    foreach(const Edge& e, _edges)
+        s << e.from << e.to << e.hasLabel;
+
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+bool GraphLayout::run(const GraphLayout* previous)
+{
+    if (previous && sameGraph(*previous)) {
+        for (int i = 0; i < _nodes.count(); i++)
+            _nodes[i].rect = previous->_nodes[i].rect;
+        for (int i = 0; i < _edges.count(); i++) {
+            _edges[i].points = previous->_edges[i].points;
+            _edges[i].labelPos = previous->_edges[i].labelPos;
+        }
+        _size = previous->_size;
+        return false;
+    }
+
+    if (previous && (previous->_mode != _mode))
+        previous = nullptr;
+
+    if (_nodes.isEmpty())
+        _size = QSizeF();
+    else {
+        if (_mode == Circular)
+            runCircular(previous);
+        else
+            runLayered(previous);
+        normalize();
+    }
+
+    if (0) qDebug("GraphLayout: %d nodes, %d edges => %.0f x %.0f",
+                  _nodes.count(), _edges.count(),
+                  _size.width(), _size.height());
+    return true;
+}
+
+void GraphLayout::addSelfLoop(Edge& e, const QRectF& r, bool transposed)
+{
+    // loop at the right side (or bottom, if transposed) of the node
+    double x = r.right() + 24;
+    double y1 = r.top() + r.height() / 4;
+    double y2 = r.bottom() - r.height() / 4;
+    double labelWidth = transposed ? _labelSize.height() : _labelSize.width();
+
+    e.points.clear();
+    e.points << QPointF(r.right(), y1) << QPointF(x, y1)
+             << QPointF(x, y2) << QPointF(r.right(), y2);
+    e.labelPos = QPointF(x + labelWidth / 2 + 4, (y1 + y2) / 2);
+}
+
+/* Layered layout, top down; for left to right, sizes and resulting
+ * coordinates are swapped. Nodes are followed by dummy nodes in the
+ * arrays for vertices <v> used below.
+ */
+void GraphLayout::runLayered(const GraphLayout* previous)
+{
+    bool transposed = (_mode == LeftRight);
+    int n = _nodes.count();
+    int edgeCount = _edges.count();
+
+    // label size across and along edges, if labels are shown
+    double labelAcross = 0.0, labelAlong = 0.0;
+    if (!_labelSize.isEmpty()) {
+        labelAcross = transposed ? _labelSize.height() : _labelSize.width();
+        labelAlong = transposed ? _labelSize.width() : _labelSize.height();
+    }
+
+    QVector<double> width(n), height(n), extra(n, 0.0);
+    QVector<int> cluster(n);
+    for (int v = 0; v < n; v++) {
+        QSizeF s = _nodes[v].rect.size();
+        width[v] = transposed ? s.height() : s.width();
+        height[v] = transposed ? s.width() : s.height();
+        cluster[v] = _nodes[v].cluster;
+    }
+
+    QVector<QVector<int> > out(n);
+    QVector<int> inDegree(n, 0);
+    for (int e = 0; e < edgeCount; e++) {
+        const Edge& edge = _edges[e];
+        if ((edge.from < 0) || (edge.to < 0)) continue;
+        if (edge.from == edge.to) {
+            // space for the loop and its label
+            extra[edge.from] = qMax(extra[edge.from],
+                                    24 + (edge.hasLabel ? labelAcross + 8 : 0));
+            continue;
+        }
+        out[edge.from].append(e);
+        inDegree[edge.to]++;
+    }
+
+    // break cycles: reverse edges to nodes on the current DFS path,
+    // starting from nodes without callers
+    QVector<bool> reversed(edgeCount, false);
+    QVector<int> state(n, 0); // 0: not visited, 1: on path, 2: done
+    QVector<int> path, next;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int r = 0; r < n; r++) {
+            if (state[r] != 0) continue;
+            if ((pass == 0) && (inDegree[r] > 0)) continue;
+
+            state[r] = 1;
+            path.append(r);
+            next.append(0);
+            while (!path.isEmpty()) {
+                int v = path.last();
+                if (next.last() < out[v].count()) {
+                    int e = out[v][next.last()++];
+                    int w = _edges[e].to;
+                    if (state[w] == 1)
+                        reversed[e] = true;
+                    else if (state[w] == 0) {
+                        state[w] = 1;
+                        path.append(w);
+                        next.append(0);
+                    }
+                    continue;
+                }
+                state[v] = 2;
+                path.removeLast();
+                next.removeLast();
+            }
+        }
+    }
+
+    // acyclic graph: edges from tail to head, -1 if not used
+    QVector<int> tail(edgeCount, -1), head(edgeCount, -1);
+    QVector<QVector<int> > dagOut(n), dagIn(n);
+    for (int v = 0; v < n; v++) {
+        foreach(int e, out[v]) {
+            tail[e] = reversed[e] ? _edges[e].to : v;
+            head[e] = reversed[e] ? v : _edges[e].to;
+            dagOut[tail[e]].append(e);
+            dagIn[head[e]].append(e);
+        }
+    }
+
+    // topological order
+    QVector<int> order, pending(n);
+    order.reserve(n);
+    for (int v = 0; v < n; v++) {
+        pending[v] = dagIn[v].count();
+        if (pending[v] == 0) order.append(v);
+    }
+    for (int i = 0; i < order.count(); i++)
+        foreach(int e, dagOut[order[i]])
+            if (--pending[head[e]] == 0)
+                order.append(head[e]);
+
+    // layers by longest path from sources
+    QVector<int> layer(n, 0);
+    foreach(int v, order)
+        foreach(int e, dagOut[v])
+            layer[head[e]] = qMax(layer[head[e]], layer[v] + 1);
+
+    // move nodes with more callees than callers down to their callees
+    for (int i = order.count() - 1; i >= 0; i--) {
+        int v = order[i];
+        if (dagOut[v].count() <= dagIn[v].count()) continue;
+        int minLayer = INT_MAX;
+        foreach(int e, dagOut[v])
+            minLayer = qMin(minLayer, layer[head[e]]);
+        if (minLayer - 1 > layer[v])
+            layer[v] = minLayer - 1;
+    }
+
+    int layerCount = 0;
+    for (int v = 0; v < n; v++)
+        layerCount = qMax(layerCount, layer[v] + 1);
+
+    // split edges spanning multiple layers with dummy nodes
+    QVector<QVector<int> > chain(edgeCount);
+    for (int e = 0; e < edgeCount; e++) {
+        if (tail[e] < 0) continue;
+        chain[e].append(tail[e]);
+        for (int l = layer[tail[e]] + 1; l < layer[head[e]]; l++) {
+            chain[e].append(layer.count());
+            layer.append(l);
+            width.append(0.0);
+            height.append(0.0);
+            extra.append(0.0);
+            cluster.append(-1);
+        }
+        chain[e].append(head[e]);
+    }
+    int vertexCount = layer.count();
+
+    QVector<QVector<int> > up(vertexCount), down(vertexCount);
+    for (int e = 0; e < edgeCount; e++) {
+        for (int k = 0; k + 1 < chain[e].count(); k++) {
+            down[chain[e][k]].append(chain[e][k+1]);
+            up[chain[e][k+1]].append(chain[e][k]);
+        }
+    }
+
+    // initial order: previous positions if known, otherwise
+    // barycenter of already placed callers, new sources to the right
+    QHash<QString, double> previousX;
+    if (previous) {
+        foreach(const Node& node, previous->_nodes) {
+            QPointF c = node.rect.center();
+            previousX.insert(node.name, transposed ? c.y() : c.x());
+        }
+    }
+    QVector<QVector<int> > layers(layerCount);
+    for (int v = 0; v < vertexCount; v++)
+        layers[layer[v]].append(v);
+
+    QVector<double> key(vertexCount);
+    QVector<OrderItem> items;
+    for (int l = 0; l < layerCount; l++) {
+        items.clear();
+        foreach(int v, layers[l]) {
+            OrderItem item;
+            item.v = v;
+            if ((v < n) && previousX.contains(_nodes[v].name))
+                item.key = previousX.value(_nodes[v].name);
+            else if (!up[v].isEmpty()) {
+                item.key = 0.0;
+                foreach(int w, up[v])
+                    item.key += key[w];
+                item.key /= up[v].count();
+            }
+            else
+                item.key = 1e9 + v;
+            item.clusterKey = item.key;
+            key[v] = item.key;
+            items.append(item);
+        }
+        std::stable_sort(items.begin(), items.end());
+        for (int i = 0; i < items.count(); i++)
+            layers[l][i] = items[i].v;
+    }
+
+    QVector<int> pos(vertexCount);
+    for (int l = 0; l < layerCount; l++)
+        for (int i = 0; i < layers[l].count(); i++)
+            pos[layers[l][i]] = i;
+
+    // reduce crossings by alternating downward and upward sweeps
+    QVector<QVector<int> > best = layers;
+    int bestCrossings = crossings(layers, down, pos);
+    int sweeps = previousX.isEmpty() ? 12 : 4;
+    for (int it = 0; (it < sweeps) && (bestCrossings > 0); it++) {
+        bool downward = (it % 2 == 0);
+        for (int k = 1; k < layerCount; k++) {
+            if (downward)
+                orderLayer(layers[k], up, pos, cluster);
+            else
+                orderLayer(layers[layerCount - 1 - k], down, pos, cluster);
+        }
+        int c = crossings(layers, down, pos);
+        if (c < bestCrossings) {
+            bestCrossings = c;
+            best = layers;
+        }
+    }
+    layers = best;
+    for (int l = 0; l < layerCount; l++)
+        for (int i = 0; i < layers[l].count(); i++)
+            pos[layers[l][i]] = i;
+
+    // x coordinates: move nodes towards their neighbors, keeping the
+    // order and minimal distances in each layer
+    QVector<double> x(vertexCount, 0.0);
+    QVector<double> target, weight, offset;
+    for (int it = 0; it < 9; it++) {
+        // first pack, then align alternately to layer above and below,
+        // lastly to both
+        bool useUp = (it % 2 == 1) || (it == 8);
+        bool useDown = ((it > 0) && (it % 2 == 0));
+        for (int k = 0; k < layerCount; k++) {
+            const QVector<int>& l = layers[useDown && !useUp ?
+                                           layerCount - 1 - k : k];
+            int count = l.count();
+            target.resize(count);
+            weight.resize(count);
+            offset.resize(count);
+            for (int i = 0; i < count; i++) {
+                int v = l[i];
+                double sum = 0.0, wsum = 0.0;
+                if (useUp) {
+                    foreach(int w, up[v]) {
+                        double aw = alignWeight(v, w, n);
+                        sum += aw * x[w];
+                        wsum += aw;
+                    }
+                }
+                if (useDown) {
+                    foreach(int w, down[v]) {
+                        double aw = alignWeight(v, w, n);
+                        sum += aw * x[w];
+                        wsum += aw;
+                    }
+                }
+                offset[i] = 0.0;
+                if (i > 0) {
+                    int u = l[i-1];
+                    double gap = ((u >= n) || (v >= n)) ? _nodeSep / 2 : _nodeSep;
+                    offset[i] = offset[i-1] + width[u] / 2 + extra[u] +
+                                width[v] / 2 + gap;
+                }
+                target[i] = ((wsum > 0) ? sum / wsum : x[v]) - offset[i];
+                // nodes without neighbors give way
+                weight[i] = (wsum > 0) ? wsum : 0.1;
+            }
+            if (it == 0) target.fill(0.0);
+            isotonic(target, weight);
+            for (int i = 0; i < count; i++)
+                x[l[i]] = target[i] + offset[i];
+        }
+    }
+
+    // y coordinates: centers of layers, with space for edge labels
+    double gap = qMax(_rankSep, labelAlong + _rankSep / 2);
+    QVector<double> layerY(layerCount);
+    double top = 0.0;
+    for (int l = 0; l < layerCount; l++) {
+        double h = 0.0;
+        foreach(int v, layers[l])
+            h = qMax(h, height[v]);
+        layerY[l] = top + h / 2;
+        top += h + gap;
+    }
+
+    QVector<QRectF> rect(n);
+    for (int v = 0; v < n; v++)
+        rect[v] = QRectF(x[v] - width[v] / 2, layerY[layer[v]] - height[v] / 2,
+                         width[v], height[v]);
+
+    // ports: spread ends of edges over the middle of node borders,
+    // ordered by position of the other end
+    QVector<double> outPort(edgeCount), inPort(edgeCount);
+    QVector<QPair<double, int> > ends;
+    for (int v = 0; v < n; v++) {
+        for (int side = 0; side < 2; side++) {
+            const QVector<int>& edges = (side == 0) ? dagOut[v] : dagIn[v];
+            ends.clear();
+            foreach(int e, edges) {
+                const QVector<int>& c = chain[e];
+                int other = (side == 0) ? c[1] : c[c.count() - 2];
+                ends.append(qMakePair(x[other], e));
+            }
+            std::sort(ends.begin(), ends.end());
+            int m = ends.count();
+            for (int k = 0; k < m; k++) {
+                double p = x[v] + 0.6 * width[v] * ((k + 1.0) / (m + 1) - 0.5);
+                if (side == 0)
+                    outPort[ends[k].second] = p;
+                else
+                    inPort[ends[k].second] = p;
+            }
+        }
+    }
+
+    for (int e = 0; e < edgeCount; e++) {
+        Edge& edge = _edges[e];
+        if ((edge.from >= 0) && (edge.from == edge.to)) {
+            addSelfLoop(edge, rect[edge.from], transposed);
+        }
+        else if (tail[e] >= 0) {
+            const QVector<int>& c = chain[e];
+            int last = c.count() - 1;
+            QVector<QPointF> q;
+            q.append(QPointF(outPort[e], rect[c[0]].bottom()));
+            for (int k = 1; k < last; k++)
+                q.append(QPointF(x[c[k]], layerY[layer[c[k]]]));
+            q.append(QPointF(inPort[e], rect[c[last]].top()));
+
+            // vertical tangents at nodes and dummy nodes
+            edge.points.clear();
+            edge.points << q[0];
+            for (int k = 0; k < last; k++) {
+                QPointF d(0, (q[k+1].y() - q[k].y()) / 2);
+                edge.points << q[k] + d << q[k+1] - d << q[k+1];
+            }
+
+            // label besides the segment leaving the caller
+            int s = reversed[e] ? last - 1 : 0;
+            edge.labelPos = (q[s] + q[s+1]) / 2 +
+                            QPointF(labelAcross / 2 + 4, 0);
+
+            if (reversed[e])
+                std::reverse(edge.points.begin(), edge.points.end());
+        }
+        else
+            continue;
+
+        if (transposed) {
+            for (int i = 0; i < edge.points.count(); i++)
+                edge.points[i] = swapped(edge.points[i]);
+            edge.labelPos = swapped(edge.labelPos);
+        }
+    }
+
+    for (int v = 0; v < n; v++)
+        _nodes[v].rect = transposed ? swapped(rect[v]) : rect[v];
+
+    if (0) qDebug("GraphLayout: %d layers, %d dummy nodes, %d crossings",
+                  layerCount, vertexCount - n, bestCrossings);
+}
+
+/* Circular layout: the center node is surrounded by rings of nodes with
+ * increasing distance to it (ignoring edge directions). Nodes on a
+ * ring are ordered by the angle of a neighbor on the inner ring.
+ */
+void GraphLayout::runCircular(const GraphLayout* previous)
+{
+    int n = _nodes.count();
+    QVector<QVector<int> > adjacent(n);
+    foreach(const Edge& e, _edges) {
+        if ((e.from < 0) || (e.to < 0) || (e.from == e.to)) continue;
+        adjacent[e.from].append(e.to);
+        adjacent[e.to].append(e.from);
+    }
+
+    int center = ((_center >= 0) && (_center < n)) ? _center : 0;
+    QVector<int> ring(n, -1), parent(n, -1);
+    QVector<int> queue;
+    ring[center] = 0;
+    queue.append(center);
+    for (int i = 0; i < queue.count(); i++) {
+        int v = queue[i];
+        foreach(int w, adjacent[v]) {
+            if (ring[w] >= 0) continue;
+            ring[w] = ring[v] + 1;
+            parent[w] = v;
+            queue.append(w);
+        }
+    }
+    int ringCount = ring[queue.last()] + 1;
+    // unconnected nodes on an additional ring
+    if (queue.count() < n) {
+        for (int v = 0; v < n; v++)
+            if (ring[v] < 0) ring[v] = ringCount;
+        ringCount++;
+    }
+
+    QHash<QString, double> previousAngle;
+    if (previous && (previous->_center >= 0) &&
+        (previous->_center < previous->_nodes.count())) {
+        QPointF c = previous->_nodes[previous->_center].rect.center();
+        foreach(const Node& node, previous->_nodes) {
+            QPointF d = node.rect.center() - c;
+            previousAngle.insert(node.name, atan2(d.y(), d.x()));
+        }
+    }
+
+    QVector<QVector<int> > rings(ringCount);
+    for (int v = 0; v < n; v++)
+        rings[ring[v]].append(v);
+
+    QVector<double> angle(n, 0.0), diag(n);
+    for (int v = 0; v < n; v++) {
+        QSizeF s = _nodes[v].rect.size();
+        diag[v] = sqrt(s.width() * s.width() + s.height() * s.height());
+    }
+
+    double radius = 0.0, lastDiag = 0.0;
+    QVector<OrderItem> items;
+    for (int r = 0; r < ringCount; r++) {
+        items.clear();
+        double circumference = 0.0, maxDiag = 0.0;
+        foreach(int v, rings[r]) {
+            OrderItem item;
+            item.v = v;
+            if (previousAngle.contains(_nodes[v].name))
+                item.key = previousAngle.value(_nodes[v].name);
+            else if (parent[v] >= 0)
+                item.key = angle[parent[v]];
+            else
+                item.key = 10.0 + v;
+            item.clusterKey = item.key;
+            items.append(item);
+            circumference += diag[v] + _nodeSep;
+            maxDiag = qMax(maxDiag, diag[v]);
+        }
+        std::stable_sort(items.begin(), items.end());
+
+        // neighbors on a ring are apart by the chord of their angle
+        double minRadius = 0.0;
+        int m = items.count();
+        for (int i = 0; (m > 1) && (i < m); i++) {
+            int v = items[i].v, w = items[(i + 1) % m].v;
+            double d = (diag[v] + diag[w]) / 2 + _nodeSep;
+            double a = M_PI * d / circumference;
+            minRadius = qMax(minRadius, d / (2 * sin(a)));
+        }
+        if (r > 0)
+            radius = qMax(radius + (lastDiag + maxDiag) / 2 + _rankSep,
+                          minRadius);
+        lastDiag = maxDiag;
+
+        // distribute by size, starting at the angle of the first node
+        double a = (items[0].key < 10.0) ? items[0].key : 0.0;
+        for (int i = 0; i < items.count(); i++) {
+            int v = items[i].v;
+            double share = 2 * M_PI * (diag[v] + _nodeSep) / circumference;
+            if (i > 0) a += share / 2;
+            angle[v] = a;
+            a += share / 2;
+            QSizeF s = _nodes[v].rect.size();
+            QPointF c(radius * cos(angle[v]), radius * sin(angle[v]));
+            _nodes[v].rect = QRectF(c - QPointF(s.width() / 2, s.height() / 2), s);
+        }
+    }
+
+    for (int i = 0; i < _edges.count(); i++) {
+        Edge& e = _edges[i];
+        if ((e.from < 0) || (e.to < 0)) continue;
+        if (e.from == e.to) {
+            addSelfLoop(e, _nodes[e.from].rect, false);
+            continue;
+        }
+        const QRectF& r1 = _nodes[e.from].rect;
+        const QRectF& r2 = _nodes[e.to].rect;
+        e.points = straightSpline(borderPoint(r1, r2.center()),
+                                  borderPoint(r2, r1.center()));
+        e.labelPos = (e.points.first() + e.points.last()) / 2;
+    }
+}
+
+void GraphLayout::normalize()
+{
+    QRectF bounds;
+    foreach(const Node& n, _nodes)
+        bounds |= n.rect;
+    foreach(const Edge& e, _edges) {
+        if (e.points.isEmpty()) continue;
+        bounds |= e.points.boundingRect();
+        if (e.hasLabel && !_labelSize.isEmpty())
+            bounds |= QRectF(e.labelPos - QPointF(_labelSize.width() / 2,
+                                                  _labelSize.height() / 2),
+                             _labelSize);
+    }
+
+    QPointF d = -bounds.topLeft();
+    for (int i = 0; i < _nodes.count(); i++)
+        _nodes[i].rect.translate(d);
+    for (int i = 0; i < _edges.count(); i++) {
+        _edges[i].points.translate(d);
+        _edges[i].labelPos += d;
+    }
+    _size = bounds.size();
+}
+
+
+//---------------------------------------------------
+// GraphLayoutCache
+
+GraphLayoutCache* GraphLayoutCache::global()
+{
+    static GraphLayoutCache* cache = new GraphLayoutCache;
+    return cache;
+}
+
+GraphLayoutCache::GraphLayoutCache()
+{
+    // about 50 graphs with 1000 nodes and edges
+    _cache.setMaxCost(50000);
+}
+
+const GraphLayout* GraphLayoutCache::find(const QByteArray& key)
+{
+    // marks the layout as most recently used
+    return _cache.object(key);
+}
+
+void GraphLayoutCache::insert(const QByteArray& key, const GraphLayout& l)
+{
+    _cache.insert(key, new GraphLayout(l), l.nodeCount() + l.edgeCount() + 1);
+}
+
+void GraphLayoutCache::clear()
+{
+    _cache.clear();
+}
@@ -0,0 +1,164 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Layout of call graphs
+ */
+
+#ifndef GRAPHLAYOUT_H
+#define GRAPHLAYOUT_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QPolygonF>
+#include <QRectF>
+#include <QSizeF>
+#include <QString>
+#include <QVector>
+
+class GraphNode;
+class GraphEdge;
+
+/**
+ * Geometry of the visible part of a call graph as shown by
+ * CallGraphView, in scene coordinates without margins.
+ *
+ * This either is filled from the output of Graphviz, or computed
+ * in-process by run() with a layered (Sugiyama style) layout:
+ * - cycles are broken by reversing DFS back edges,
+ * - nodes are put into layers by longest path, with nodes having more
+ *   callees than callers moved down next to their callees,
+ * - edges spanning multiple layers are split by dummy nodes,
+ * - crossings are reduced by barycenter sweeps, keeping nodes of the
+ *   same cluster together,
+ * - positions in a layer are balanced towards the neighbors, keeping
+ *   minimal distances (isotonic regression per layer).
+ * Edges are returned as cubic bezier splines. The circular layout puts
+ * nodes on rings around a center node by their distance to it.
+ *
+ * Nodes are identified by the names also used in the dot file, see
+ * GraphExporter::nodeName(). When given a previous layout of the same
+ * mode, the order of nodes in layers starts from the previous one, so
+ * that nodes keep their relative positions. If the graph did not
+ * change at all, e.g. when only limits are changed without hiding or
+ * showing nodes or edges, the previous geometry is reused.
+ */
+class GraphLayout
+{
+public:
+    enum Mode { TopDown, LeftRight, Circular };
+
+    struct Node {
+        QString name;
+        // nullptr for points collecting skipped calls
+        GraphNode* node;
+        QRectF rect;
+        // nodes with same cluster id >= 0 are kept together
+        int cluster;
+    };
+
+    struct Edge {
+        GraphEdge* edge;
+        // node indexes, -1 if not known
+        int from, to;
+        // control points of cubic bezier spline: 1+3n points
+        QPolygonF points;
+        bool hasLabel;
+        // center of label
+        QPointF labelPos;
+    };
+
+    GraphLayout();
+
+    void clear();
+
+    void setMode(Mode m) { _mode = m; }
+    Mode mode() const { return _mode; }
+
+    // minimal distance between nodes in a layer and between layers
+    void setSpacing(double nodeSep, double rankSep);
+    // edge labels get space between layers
+    void setLabelSize(const QSizeF& s) { _labelSize = s; }
+    // node in the center for the circular layout
+    void setCenter(int n) { _center = n; }
+
+    int addNode(const QString& name, GraphNode*, const QSizeF&,
+                int cluster = -1);
+    int addEdge(GraphEdge*, int from, int to, bool hasLabel = true);
+    // index of node with @p name, or -1
+    int node(const QString& name) const;
+
+    int nodeCount() const { return _nodes.count(); }
+    int edgeCount() const { return _edges.count(); }
+    Node& nodeAt(int i) { return _nodes[i]; }
+    const Node& nodeAt(int i) const { return _nodes[i]; }
+    Edge& edgeAt(int i) { return _edges[i]; }
+    const Edge& edgeAt(int i) const { return _edges[i]; }
+
+    QSizeF size() const { return _size; }
+    void setSize(const QSizeF& s) { _size = s; }
+
+    // hash of everything given as input to run()
+    QByteArray signature() const;
+
+    /**
+     * Compute geometry of nodes and edges added.
+     * Returns false if the geometry of @p previous was reused.
+     */
+    bool run(const GraphLayout* previous = nullptr);
+
+private:
+    // true if nodes and edges are the same as in @p l
+    bool sameGraph(const GraphLayout& l) const;
+    void runLayered(const GraphLayout* previous);
+    void runCircular(const GraphLayout* previous);
+    void addSelfLoop(Edge&, const QRectF&, bool transposed);
+    // move all items to start at (0/0) and set size
+    void normalize();
+
+    Mode _mode;
+    double _nodeSep, _rankSep;
+    QSizeF _labelSize;
+    int _center;
+    QSizeF _size;
+
+    QVector<Node> _nodes;
+    QVector<Edge> _edges;
+    QHash<QString, int> _index;
+};
+
+
+/**
+ * Layouts of recently shown call graphs, shared by all call graph
+ * views, to make revisiting a graph instant. Least recently used
+ * layouts are dropped first.
+ *
+ * Layouts done in-process are found by GraphLayout::signature(), and
+ * layouts done by Graphviz by a hash of its input. Pointers to graph
+ * nodes/edges in cached layouts get invalid, and need to be set again
+ * from the names of nodes when used.
+ *
+ * The cache is only to be used from the GUI thread.
+ */
+class GraphLayoutCache
+{
+public:
+    static GraphLayoutCache* global();
+
+    // layout for @p key, or nullptr if not cached
+    const GraphLayout* find(const QByteArray& key);
+    void insert(const QByteArray& key, const GraphLayout&);
+    void clear();
+
+private:
+    GraphLayoutCache();
+
+    // cost of a layout: number of nodes and edges
+    QCache<QByteArray, GraphLayout> _cache;
+};
+
+#endif // GRAPHLAYOUT_H
@@ -0,0 +1,115 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Level of detail for drawing graph views
+ */
+
+#include "graphlod.h"
+
+#include <QFontMetrics>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+
+//---------------------------------------------------
+// GraphLOD
+
+double GraphLOD::scale(const QStyleOptionGraphicsItem* option,
+                       const QPainter* p)
+{
+    return option->levelOfDetailFromTransform(p->transform());
+}
+
+QPainterPath GraphLOD::simplePath(const QPolygon& pa)
+{
+    QPainterPath path;
+    if (pa.isEmpty()) return path;
+
+    path.moveTo(pa[0]);
+    for (int i = 3; i < pa.size(); i += 3)
+        path.lineTo(pa[i]);
+    // spline not ending with a full bezier segment
+    if ((pa.size() - 1) % 3 != 0)
+        path.lineTo(pa.last());
+
+    return path;
+}
+
+
+//---------------------------------------------------
+// FrameTimeOverlay
+
+FrameTimeOverlay::FrameTimeOverlay(QGraphicsView* view)
+{
+    _view = view;
+    _enabled = false;
+    _updateMode = view->viewportUpdateMode();
+    _lastTime = _maxTime = 0.0;
+    _frames = 0;
+    _fps = 0.0;
+}
+
+void FrameTimeOverlay::setEnabled(bool enabled)
+{
+    if (_enabled == enabled) return;
+    _enabled = enabled;
+
+    // partial updates or scrolling of the viewport would keep
+    // old overlays and hide the time for drawing a full frame
+    if (enabled) {
+        _updateMode = _view->viewportUpdateMode();
+        _view->setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+        _frames = 0;
+        _fps = _maxTime = 0.0;
+        _intervalTimer.start();
+    }
+    else
+        _view->setViewportUpdateMode(_updateMode);
+
+    _view->viewport()->update();
+}
+
+void FrameTimeOverlay::begin()
+{
+    if (_enabled)
+        _frameTimer.start();
+}
+
+void FrameTimeOverlay::end(QPainter* p)
+{
+    if (!_enabled || !_frameTimer.isValid()) return;
+
+    _lastTime = _frameTimer.nsecsElapsed() / 1000000.0;
+    if (_lastTime > _maxTime) _maxTime = _lastTime;
+    _frames++;
+
+    qint64 interval = _intervalTimer.elapsed();
+    if (interval >= 1000) {
+        _fps = 1000.0 * _frames / interval;
+        _frames = 0;
+        _maxTime = _lastTime;
+        _intervalTimer.restart();
+    }
+
+    QString s = QStringLiteral("%1 ms/frame (max %2 ms), %3 fps")
+                .arg(_lastTime, 0, 'f', 1)
+                .arg(_maxTime, 0, 'f', 1)
+                .arg(_fps, 0, 'f', 1);
+
+    // draw in viewport coordinates
+    p->save();
+    p->resetTransform();
+    QFontMetrics fm(_view->font());
+    QRect r = fm.boundingRect(s).adjusted(-4, -2, 4, 2);
+    r.moveTopLeft(QPoint(4, 4));
+    p->setPen(Qt::black);
+    p->setBrush(QColor(255, 255, 255, 200));
+    p->drawRect(r);
+    p->setFont(_view->font());
+    p->drawText(r, Qt::AlignCenter, s);
+    p->restore();
+}
@@ -0,0 +1,84 @@
+/*
+    This file is part of KCachegrind.
+
+    SPDX-License-Identifier: GPL-2.0-only
+*/
+
+/*
+ * Level of detail for drawing graph views
+ */
+
+#ifndef GRAPHLOD_H
+#define GRAPHLOD_H
+
+#include <QElapsedTimer>
+#include <QGraphicsView>
+#include <QPainterPath>
+#include <QPolygon>
+
+class QPainter;
+class QStyleOptionGraphicsItem;
+
+/**
+ * Level of detail used by the canvas items of CallGraphView and
+ * ControlFlowGraphView, depending on the size items get on screen.
+ * This keeps zoomed out views and the panners fast for large graphs:
+ * - text is drawn only if its font gets at least minTextHeight pixels,
+ * - below simpleScale, nodes are drawn flat without shading, edges as
+ *   polylines without antialiasing, and arrows are left out,
+ * - below collapseScale, nodes in a cluster are drawn as one box.
+ * Zooming with the mouse wheel is limited to [minZoom; maxZoom]; views
+ * can be zoomed out below collapseScale.
+ */
+class GraphLOD
+{
+public:
+    static constexpr double minTextHeight = 6.0;
+    static constexpr double simpleScale = 0.4;
+    static constexpr double collapseScale = 0.2;
+    static constexpr double minZoom = 0.1;
+    static constexpr double maxZoom = 1.3;
+
+    // pixels on screen per scene unit for item painted with @p p
+    static double scale(const QStyleOptionGraphicsItem*, const QPainter* p);
+
+    static bool showText(double scale, int fontHeight)
+    { return scale * fontHeight >= minTextHeight; }
+    static bool isSimple(double scale) { return scale < simpleScale; }
+    static bool isCollapsed(double scale) { return scale < collapseScale; }
+
+    // polyline through the end points of cubic bezier segments
+    static QPainterPath simplePath(const QPolygon& controlPoints);
+};
+
+
+/**
+ * Time needed to draw frames of a graph view, shown in the top left
+ * corner of the view for measuring. begin() is to be called from
+ * drawBackground(), and end() from drawForeground() of the view.
+ * While enabled, the view always is updated as a whole, so times are
+ * for drawing all visible items.
+ */
+class FrameTimeOverlay
+{
+public:
+    explicit FrameTimeOverlay(QGraphicsView*);
+
+    bool isEnabled() const { return _enabled; }
+    void setEnabled(bool);
+
+    void begin();
+    void end(QPainter*);
+
+private:
+    QGraphicsView* _view;
+    bool _enabled;
+    QGraphicsView::ViewportUpdateMode _updateMode;
+    // started at begin of frame, and at start of FPS interval
+    QElapsedTimer _frameTimer, _intervalTimer;
+    double _lastTime, _maxTime;
+    int _frames;
+    double _fps;
+};
+
+#endif // GRAPHLOD_H
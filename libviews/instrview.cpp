@@ -14,11 +14,11 @@
 
 #include <assert.h>
 
+#include <QBuffer>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
-#include <QProcess>
 #include <QAction>
 #include <QMenu>
 #include <QScrollBar>
@@ -27,6 +27,7 @@
 #include <QProcessEnvironment>
 
 #include "config.h"
+#include "disassemblycache.h"
 #include "globalconfig.h"
 #include "instritem.h"
 
@@ -35,6 +36,9 @@
 
 #define DEFAULT_SHOWHEXCODE true
 
+// number of hottest functions of an object disassembled in background
+#define PREFETCH_FUNCTIONS 20
+
 
 // Helpers
 
@@ -459,6 +463,10 @@ void InstrView::doUpdate(int changeType, bool)
         return;
     }
 
+    // a new trace may have an object at the address of the last one
+    if (changeType & dataChanged)
+        _prefetchedObject = nullptr;
+
     // On eventTypeChanged, we can not just change the costs shown in
     // already existing items, as costs of 0 should make the line to not
     // be shown at all. So we do a full refresh.
@@ -651,6 +659,8 @@ void InstrView::refresh()
         if (it == itEnd) break;
     }
 
+    prefetchDisassembly(f->object());
+
     _lastHexCodeWidth = columnWidth(4);
     setColumnWidths();
 
@@ -849,24 +859,13 @@ bool InstrView::fillInstrRange(TraceFunction* function,
     }
     function->object()->setDirectory(dir);
 
-    // call objdump synchronously
+    // call objdump synchronously, if not cached
     QString objfile = dir + '/' + function->object()->shortName();
-    QString objdump_format = getObjDumpFormat();
-    if (objdump_format.isEmpty())
-        objdump_format = getObjDump() + " -C -d %1 --start-address=0x%2 --stop-address=0x%3 \"%4\"";
-    QString objdumpCmd = objdump_format
-            .arg(_useIntelSyntax ? QStringLiteral("-M intel") : QStringLiteral(""))
-            .arg(dumpStartAddr.toString())
-            .arg(dumpEndAddr.toString())
-            .arg(objfile);
-
-    qDebug("Running '%s'...", qPrintable(objdumpCmd));
-
-    // and run...
-    QProcess objdump;
-    objdump.startCommand(objdumpCmd);
-    if (!objdump.waitForStarted() ||
-        !objdump.waitForFinished()) {
+    QString objdumpCmd;
+    QByteArray output;
+    if (!DisassemblyCache::global()->dump(objdumpFormat(), objfile,
+                                          dumpStartAddr, dumpEndAddr,
+                                          output, objdumpCmd)) {
 
         new InstrItem(this, this, 1,
                       tr("There is an error trying to execute the command"));
@@ -879,6 +878,9 @@ bool InstrView::fillInstrRange(TraceFunction* function,
         return false;
     }
 
+    QBuffer objdump(&output);
+    objdump.open(QIODevice::ReadOnly);
+
 
 #define BUF_SIZE  256
 
@@ -1178,6 +1180,73 @@ bool InstrView::fillInstrRange(TraceFunction* function,
     return true;
 }
 
+// objdump command for DisassemblyCache, with syntax option applied
+QString InstrView::objdumpFormat() const
+{
+    QString format = getObjDumpFormat();
+    if (format.isEmpty())
+        format = getObjDump() + " -C -d %1 --start-address=0x%2 --stop-address=0x%3 \"%4\"";
+    return format.arg(_useIntelSyntax ? QStringLiteral("-M intel") : QStringLiteral(""));
+}
+
+// range given to objdump for instructions from @p first to @p last,
+// as in fillInstrRange()
+static DisassemblyCache::Range dumpRange(Addr first, Addr last, bool isArm)
+{
+    // for Arm: address always even (even for Thumb encoding)
+    if (isArm)
+        first = first.alignedDown(2);
+
+    return DisassemblyCache::Range((first<20) ? Addr(0) : first -20, last +20);
+}
+
+/**
+ * Disassemble the functions of object @p o with most cost in the
+ * background, to make switching to them fast.
+ */
+void InstrView::prefetchDisassembly(TraceObject* o)
+{
+    if (o == _prefetchedObject) return;
+    _prefetchedObject = o;
+
+    QString dir = o->directory();
+    if (!searchFile(dir, o)) return;
+
+    QList<TraceFunction*> functions;
+    foreach(TraceFunction* f, o->functions())
+        if (f->subCost(_eventType) > 0)
+            functions.append(f);
+    std::sort(functions.begin(), functions.end(),
+              [this](TraceFunction* f1, TraceFunction* f2) {
+        return f1->subCost(_eventType) > f2->subCost(_eventType);
+    });
+    if (functions.count() > PREFETCH_FUNCTIONS)
+        functions.erase(functions.begin() + PREFETCH_FUNCTIONS, functions.end());
+
+    bool isArm = (_data->architecture() == TraceData::ArchARM);
+    QList<DisassemblyCache::Range> ranges;
+    foreach(TraceFunction* f, functions) {
+        TraceInstrMap* instrMap = f->instrMap();
+        if (!instrMap || instrMap->isEmpty()) continue;
+
+        // split at large gaps as done in refresh(), but over all
+        // instructions: ranges shown for any event type are contained
+        TraceInstrMap::Iterator it = instrMap->begin();
+        Addr first = (*it).addr(), last = first;
+        for (++it; it != instrMap->end(); ++it) {
+            if (!(*it).addr().isInRange(last, 10000)) {
+                ranges.append(dumpRange(first, last, isArm));
+                first = (*it).addr();
+            }
+            last = (*it).addr();
+        }
+        ranges.append(dumpRange(first, last, isArm));
+    }
+
+    DisassemblyCache::global()->prefetch(objdumpFormat(),
+                                         dir + '/' + o->shortName(), ranges);
+}
+
 void InstrView::headerClicked(int col)
 {
     if (col == 0) {
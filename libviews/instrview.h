@@ -55,6 +55,8 @@ private:
     void updateJumpArray(Addr,InstrItem*,bool,bool);
     bool fillInstrRange(TraceFunction*,
                         TraceInstrMap::Iterator,TraceInstrMap::Iterator);
+    QString objdumpFormat() const;
+    void prefetchDisassembly(TraceObject*);
 
     bool _inSelectionUpdate;
 
@@ -68,6 +70,9 @@ private:
     // remember width of hex code column if hidden
     int _lastHexCodeWidth;
 
+    // object of last disassembly prefetch
+    TraceObject* _prefetchedObject = nullptr;
+
     // Flag indicating if x86 assembly syntax options should be available
     bool _maybeX86 = true;
 
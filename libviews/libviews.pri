@@ -13,6 +13,8 @@ NHEADERS += \
     $$PWD/multiview.h \
     $$PWD/tabview.h \
     $$PWD/callgraphview.h \
+    $$PWD/graphlayout.h \
+    $$PWD/graphlod.h \
     $$PWD/treemap.h \
     $$PWD/callitem.h \
     $$PWD/callview.h \
@@ -24,6 +26,7 @@ NHEADERS += \
     $$PWD/eventtypeview.h \
     $$PWD/instritem.h \
     $$PWD/instrview.h \
+    $$PWD/disassemblycache.h \
     $$PWD/partgraph.h \
     $$PWD/partlistitem.h \
     $$PWD/partview.h \
@@ -35,6 +38,8 @@ NHEADERS += \
 SOURCES += \
     $$PWD/globalguiconfig.cpp \
     $$PWD/callgraphview.cpp \
+    $$PWD/graphlayout.cpp \
+    $$PWD/graphlod.cpp \
     $$PWD/callitem.cpp \
     $$PWD/callmapview.cpp \
     $$PWD/callview.cpp \
@@ -47,6 +52,7 @@ SOURCES += \
     $$PWD/functionselection.cpp \
     $$PWD/instritem.cpp \
     $$PWD/instrview.cpp \
+    $$PWD/disassemblycache.cpp \
     $$PWD/listutils.cpp \
     $$PWD/multiview.cpp \
     $$PWD/partgraph.cpp \
@@ -28,6 +28,7 @@
 #include <QFileDialog>
 #include <QEventLoop>
 #include <QToolBar>
+#include <QToolButton>
 #include <QComboBox>
 #include <QMessageBox>
 #include <QStatusBar>
@@ -43,6 +44,8 @@
 #include "stackselection.h"
 #include "stackbrowser.h"
 #include "tracedata.h"
+#include "backgroundload.h"
+#include "pool.h"
 #include "config.h"
 #include "globalguiconfig.h"
 #include "multiview.h"
@@ -62,12 +65,27 @@ QCGTopLevel::QCGTopLevel()
     _statusLabel = new QLabel(_statusbar);
     _statusbar->addWidget(_statusLabel, 1);
 
+    _backgroundLoad = nullptr;
+    _loadTimer = new QTimer(this);
+    _loadTimer->setSingleShot(true);
+    _loadTimer->setInterval(100);
+    connect(_loadTimer, &QTimer::timeout,
+            this, &QCGTopLevel::checkBackgroundLoad);
+    _cancelLoadButton = new QToolButton(_statusbar);
+    _cancelLoadButton->setText(tr("Cancel"));
+    _cancelLoadButton->setToolTip(tr("Stop loading of profile data"));
+    _statusbar->addPermanentWidget(_cancelLoadButton);
+    _cancelLoadButton->hide();
+    connect(_cancelLoadButton, &QToolButton::clicked,
+            this, &QCGTopLevel::cancelLoad);
+
     _layoutCount = 1;
     _layoutCurrent = 0;
 
     resetState();
 
     GlobalGUIConfig::config()->readOptions();
+    FixPool::setUseHugePages(GlobalConfig::useHugePages());
 
     createActions();
     createDocks();
@@ -116,6 +134,7 @@ QCGTopLevel::~QCGTopLevel()
         }
     }
 #endif
+    cancelLoad();
     delete _data;
 }
 
@@ -382,6 +401,11 @@ void QCGTopLevel::createActions()
     _exportAction->setStatusTip(tr("Generate GraphViz file 'callgraph.dot'"));
     connect(_exportAction, &QAction::triggered, this, &QCGTopLevel::exportGraph);
 
+    _memoryUsageAction = new QAction(tr("Memory Usage"), this);
+    _memoryUsageAction->setStatusTip(tr("Show memory used by loaded profile data"));
+    connect(_memoryUsageAction, &QAction::triggered,
+            this, &QCGTopLevel::showMemoryUsage);
+
     _recentFilesMenuAction = new QAction(tr("Open &Recent"), this);
     _recentFilesMenuAction->setMenu(new QMenu(this));
     connect(_recentFilesMenuAction->menu(), &QMenu::aboutToShow,
@@ -612,6 +636,7 @@ void QCGTopLevel::createMenu()
     fileMenu->addAction(_addAction);
     fileMenu->addSeparator();
     fileMenu->addAction(_exportAction);
+    fileMenu->addAction(_memoryUsageAction);
     fileMenu->addSeparator();
     fileMenu->addAction(_closeAction);
     fileMenu->addSeparator();
@@ -866,14 +891,14 @@ void QCGTopLevel::load(QStringList files, bool addToRecentFiles)
         return;
     }
 
-    // this constructor enables progress bar callbacks
+    // notifications are forwarded to us on merging loaded parts
     TraceData* d = new TraceData(this);
-    int filesLoaded = d->load(files);
-    if (filesLoaded >0)
-        setData(d);
-
-    if (!addToRecentFiles) return;
+    startLoad(new BackgroundLoad(d, files),
+              addToRecentFiles ? files : QStringList());
+}
 
+void QCGTopLevel::updateRecentFiles(const QStringList& files, bool loaded)
+{
     // add to recent file list in config
     QStringList recentFiles;
     ConfigGroup* generalConfig = ConfigStorage::group(QStringLiteral("GeneralSettings"));
@@ -881,7 +906,7 @@ void QCGTopLevel::load(QStringList files, bool addToRecentFiles)
                                        QStringList()).toStringList();
     foreach(const QString& file, files) {
         recentFiles.removeAll(file);
-        if (filesLoaded >0)
+        if (loaded)
             recentFiles.prepend(file);
         if (recentFiles.count() >5)
             recentFiles.removeLast();
@@ -915,11 +940,71 @@ void QCGTopLevel::add(QStringList files)
         return;
     }
 
-    // this constructor enables progress bar callbacks
+    // notifications are forwarded to us on merging loaded parts
     TraceData* d = new TraceData(this);
-    int filesLoaded = d->load(files);
-    if (filesLoaded >0)
-        setData(d);
+    startLoad(new BackgroundLoad(d, files), QStringList());
+}
+
+void QCGTopLevel::startLoad(BackgroundLoad* load, const QStringList& recentFiles)
+{
+    // only one load at a time
+    cancelLoad();
+
+    _backgroundLoad = load;
+    _loadRecentFiles = recentFiles;
+    _cancelLoadButton->show();
+    load->start();
+    _loadTimer->start();
+}
+
+// merge loaded parts, and show them
+void QCGTopLevel::checkBackgroundLoad()
+{
+    if (!_backgroundLoad) return;
+
+    TraceData* d = _backgroundLoad->data();
+    if (_backgroundLoad->mergeLoaded() > 0) {
+        if (d != _data)
+            setData(d);
+        else {
+            // GUI update for added parts
+            _partSelection->hiddenPartsChangedSlot(_hiddenParts);
+            configChanged();
+
+            if (_data->parts().count()>1)
+                _partDock->show();
+        }
+    }
+
+    if (!_backgroundLoad->isFinished()) {
+        showStatus(tr("Loading %1").arg(_backgroundLoad->currentFile()),
+                   _backgroundLoad->progress());
+        _loadTimer->start();
+        return;
+    }
+
+    bool loaded = (_backgroundLoad->partsLoaded() > 0);
+    QStringList recentFiles = _loadRecentFiles;
+    cancelLoad();
+
+    if (!recentFiles.isEmpty())
+        updateRecentFiles(recentFiles, loaded);
+}
+
+void QCGTopLevel::cancelLoad()
+{
+    if (!_backgroundLoad) return;
+
+    _loadTimer->stop();
+    TraceData* d = _backgroundLoad->data();
+    // this waits for loading threads to stop
+    delete _backgroundLoad;
+    _backgroundLoad = nullptr;
+    _cancelLoadButton->hide();
+    showStatus(QString(), 0);
+
+    // keep parts already shown
+    if (d != _data) delete d;
 }
 
 void QCGTopLevel::loadDelayed(QString file, bool addToRecentFiles)
@@ -955,6 +1040,17 @@ void QCGTopLevel::exportGraph()
 }
 
 
+void QCGTopLevel::showMemoryUsage()
+{
+    if (!_data) return;
+
+    QString text = _data->memoryUsage().toString();
+    QMessageBox::information(this, tr("Memory Usage"),
+                             QStringLiteral("<pre>%1</pre>")
+                             .arg(text.toHtmlEscaped()));
+}
+
+
 void QCGTopLevel::setEventType(QString s)
 {
     EventType* ct;
@@ -1746,6 +1842,7 @@ void QCGTopLevel::updateStatusBar()
 
 void QCGTopLevel::closeEvent(QCloseEvent* event)
 {
+    cancelLoad();
     GlobalConfig::config()->saveOptions();
 
     saveTraceSettings();
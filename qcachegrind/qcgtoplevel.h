@@ -29,9 +29,12 @@ class QDockWidget;
 class QLabel;
 class QComboBox;
 class QProgressBar;
+class QTimer;
+class QToolButton;
 class QMenu;
 
 class TraceData;
+class BackgroundLoad;
 class MainWidget;
 class PartSelection;
 class FunctionSelection;
@@ -85,6 +88,7 @@ public Q_SLOTS:
     void loadDelayed(QStringList files, bool addToRecentFiles = true);
 
     void exportGraph();
+    void showMemoryUsage();
     void newWindow();
     void configure(QString page = QString());
     void about();
@@ -174,6 +178,10 @@ public Q_SLOTS:
     void loadFilesDelayed();
     void setDirectionDelayed();
 
+    // for loading in the background
+    void checkBackgroundLoad();
+    void cancelLoad();
+
     // configuration has changed
     void configChanged() override;
 
@@ -196,6 +204,10 @@ private:
     QString traceKey();
     void restoreTraceTypes();
     void restoreTraceSettings();
+    // start background loading, see checkBackgroundLoad()
+    void startLoad(BackgroundLoad*, const QStringList& recentFiles);
+    // add files to recent file list in config, if loaded
+    void updateRecentFiles(const QStringList& files, bool loaded);
 
     QStatusBar* _statusbar;
     QLabel* _statusLabel;
@@ -203,6 +215,12 @@ private:
     QElapsedTimer _progressStart;
     QProgressBar* _progressBar;
 
+    // background loading, with data shown as soon as parts are merged
+    BackgroundLoad* _backgroundLoad;
+    QStringList _loadRecentFiles;
+    QTimer* _loadTimer;
+    QToolButton* _cancelLoadButton;
+
     MultiView* _multiView;
     Qt::Orientation _spOrientation;
     bool _twoMainWidgets;
@@ -214,7 +232,8 @@ private:
 
     // menu/toolbar actions
     QAction *_newAction, *_openAction, *_addAction, *_reloadAction;
-    QAction *_exportAction, *_dumpToggleAction, *_exitAction;
+    QAction *_exportAction, *_memoryUsageAction;
+    QAction *_dumpToggleAction, *_exitAction;
     QAction *_sidebarMenuAction, *_recentFilesMenuAction;
     QAction *_cyclesToggleAction, *_percentageToggleAction;
     QAction *_expandedToggleAction, *_hideTemplatesToggleAction;